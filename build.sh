@@ -6,6 +6,9 @@ CXX=${CXX:-clang++}
 
 mkdir -p build
 ${CXX} $* -I. meow_example.cpp -O3 -mavx -maes -o build/meow_example
-${CXX} $* -I. util/meow_test.cpp -O3 -mavx -maes -o build/meow_test
+${CXX} $* -I. util/meow_test.cpp -O3 -mavx -maes -pthread -o build/meow_test
 ${CXX} $* -I. util/meow_search.cpp -O3 -mavx -maes -o build/meow_search
-${CXX} $* -I. util/meow_bench.cpp -O3 -mavx2 -maes -o build/meow_bench
+${CXX} $* -I. util/meow_bench.cpp -O3 -mavx2 -maes -pthread -o build/meow_bench
+${CXX} $* -I. util/meow_iobench.cpp -O3 -mavx -maes -o build/meow_iobench
+${CXX} $* -I. util/meow_fuzz.cpp -O2 -mavx -maes -o build/meow_fuzz
+${CXX} $* -I. util/meow_kat.cpp -O3 -mavx -maes -o build/meow_kat
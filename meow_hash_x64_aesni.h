@@ -206,8 +206,9 @@ struct meow_dump
     void *Ptr;
     char const *Title;
 };
-extern "C" meow_dump *MeowDumpTo;
-meow_dump *MeowDumpTo;
+// NOTE: Per thread, so that tests can dump states on several threads at once
+extern "C" thread_local meow_dump *MeowDumpTo;
+thread_local meow_dump *MeowDumpTo;
 #define MEOW_DUMP_STATE(T, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, ptr) \
 if(MeowDumpTo) \
 { \
@@ -227,6 +228,314 @@ if(MeowDumpTo) \
 #define MEOW_DUMP_STATE(...)
 #endif
 
+//
+// NOTE: Define MEOW_TIME_STAGES to 1 to have every MeowHash and MeowEnd call record
+// how many TSC ticks it spent in each stage (block absorption, building the
+// residual and length, the 32-byte lane tail, and the final mix-down and fold)
+// into a ring of the last MEOW_STAGE_RING_SIZE calls on the calling thread.  The
+// stamps are fenced, so they cost a few dozen cycles each and the timed hash is
+// slower than the real one; subtract the cost of back-to-back MeowStageClock()
+// calls from each stage.  MeowEnd has no block stage (MeowAbsorb does that work),
+// so it records zero there.
+//
+
+#if MEOW_TIME_STAGES
+enum meow_stage
+{
+    MeowStage_Blocks,
+    MeowStage_Residuals,
+    MeowStage_Lanes,
+    MeowStage_MixDown,
+
+    MeowStage_Count,
+};
+
+struct meow_stage_sample
+{
+    meow_u64 Len;
+    meow_u64 Cycles[MeowStage_Count];
+};
+
+#if !defined MEOW_STAGE_RING_SIZE
+#define MEOW_STAGE_RING_SIZE 4096
+#endif
+
+struct meow_stage_ring
+{
+    meow_u64 WriteCount; // NOTE: Samples[WriteCount % MEOW_STAGE_RING_SIZE] is written next
+    meow_stage_sample Samples[MEOW_STAGE_RING_SIZE];
+};
+static thread_local meow_stage_ring MeowStageRing;
+
+static meow_u64
+MeowStageClock(void)
+{
+    // NOTE: Without the fences, the out-of-order core would overlap one stage's
+    // work with the next and the stamps would land wherever it pleased
+    _mm_lfence();
+    meow_u64 Result = __rdtsc();
+    _mm_lfence();
+
+    return(Result);
+}
+
+// NOTE: The fences order the instructions, but the compiler could still move the
+// stage's register math across a stamp, so make it think the stamp reads them
+#if _MSC_VER && !defined(__clang__)
+#define MEOW_STAGE_PIN(xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7) _ReadWriteBarrier()
+#else
+#define MEOW_STAGE_PIN(xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7) \
+__asm__ __volatile__("" : "+x"(xmm0), "+x"(xmm1), "+x"(xmm2), "+x"(xmm3), "+x"(xmm4), "+x"(xmm5), "+x"(xmm6), "+x"(xmm7))
+#endif
+
+#define MEOW_STAGE_BEGIN(Len) \
+meow_stage_sample *MeowStageSample = MeowStageRing.Samples + (MeowStageRing.WriteCount++ % MEOW_STAGE_RING_SIZE); \
+MeowStageSample->Len = (Len); \
+MeowStageSample->Cycles[MeowStage_Blocks] = 0; \
+meow_u64 MeowStageAt = MeowStageClock()
+
+#define MEOW_STAGE_END(Stage, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7) \
+{ \
+    MEOW_STAGE_PIN(xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7); \
+    meow_u64 MeowStageNow = MeowStageClock(); \
+    MeowStageSample->Cycles[Stage] = MeowStageNow - MeowStageAt; \
+    MeowStageAt = MeowStageNow; \
+}
+#else
+#define MEOW_STAGE_BEGIN(...)
+#define MEOW_STAGE_END(...)
+#endif
+
+//
+// NOTE: Define MEOW_STATS to 1 to count, per thread, how many hashes of each size
+// class are done (by log2 of the length: bucket 0 is the empty input, bucket N is
+// lengths in [2^(N-1), 2^N)), how many bytes they cover, and how many bytes go
+// through each path: one-shot or streaming, with or without the prefetching loop.
+// A streaming hash counts as one hash of its total length when MeowEnd is called.
+//
+// Each thread claims a slot of its own on its first call, padded so that no two
+// threads' counters share a cache line, and only ever writes that slot, so a call
+// costs a thread-local lookup and a few adds.  MeowStatsSnapshot sums every slot;
+// the counts of exited threads stay in it.  Once MEOW_STATS_MAX_THREADS - 1 threads
+// have claimed slots, the rest share the last slot and pay for atomic adds.  The
+// slots are static like everything else here, so each translation unit that
+// includes this header counts its own calls.
+//
+
+#if MEOW_STATS
+#if !defined MEOW_STATS_MAX_THREADS
+#define MEOW_STATS_MAX_THREADS 256
+#endif
+
+#define MEOW_STATS_BUCKET_COUNT 65
+
+enum meow_stats_path
+{
+    MeowPath_OneShot,
+    MeowPath_OneShotPrefetch,
+    MeowPath_Stream,
+    MeowPath_StreamPrefetch,
+
+    MeowPath_Count,
+};
+
+struct meow_stats
+{
+    meow_u64 Calls[MEOW_STATS_BUCKET_COUNT];
+    meow_u64 Bytes[MEOW_STATS_BUCKET_COUNT];
+    meow_u64 PathCalls[MeowPath_Count];
+    meow_u64 PathBytes[MeowPath_Count];
+};
+
+// NOTE: 128 rather than 64, since the adjacent-line prefetcher pulls in pairs of lines
+struct alignas(128) meow_stats_slot
+{
+    meow_stats Stats;
+};
+
+static meow_stats_slot MeowStatsSlots[MEOW_STATS_MAX_THREADS];
+static long MeowStatsSlotsClaimed;
+static thread_local meow_stats_slot *MeowStatsThreadSlot;
+
+static meow_stats_slot *
+MeowStatsGetSlot(void)
+{
+    meow_stats_slot *Result = MeowStatsThreadSlot;
+    if(!Result)
+    {
+#if _MSC_VER && !defined(__clang__)
+        long Index = _InterlockedIncrement(&MeowStatsSlotsClaimed) - 1;
+#else
+        long Index = __atomic_fetch_add(&MeowStatsSlotsClaimed, 1, __ATOMIC_RELAXED);
+#endif
+        Result = MeowStatsSlots + ((Index < (MEOW_STATS_MAX_THREADS - 1)) ? Index : (MEOW_STATS_MAX_THREADS - 1));
+        MeowStatsThreadSlot = Result;
+    }
+
+    return(Result);
+}
+
+static void
+MeowStatsAdd(meow_stats_slot *Slot, meow_u64 *Counter, meow_u64 Amount)
+{
+    // NOTE: Only the owner writes a private slot, so a relaxed load and store is
+    // enough (and is a plain add); the snapshot just needs to see whole values
+#if _MSC_VER && !defined(__clang__)
+    if(Slot == (MeowStatsSlots + MEOW_STATS_MAX_THREADS - 1))
+    {
+        _InterlockedExchangeAdd64((__int64 volatile *)Counter, (__int64)Amount);
+    }
+    else
+    {
+        *(meow_u64 volatile *)Counter += Amount;
+    }
+#else
+    if(Slot == (MeowStatsSlots + MEOW_STATS_MAX_THREADS - 1))
+    {
+        __atomic_fetch_add(Counter, Amount, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_store_n(Counter, __atomic_load_n(Counter, __ATOMIC_RELAXED) + Amount, __ATOMIC_RELAXED);
+    }
+#endif
+}
+
+static int
+MeowStatsBucket(meow_u64 Len)
+{
+#if _MSC_VER && !defined(__clang__)
+    unsigned long High;
+    int Result = (_BitScanReverse(&High, (unsigned long)(Len >> 32)) ? (int)(High + 33) :
+                  _BitScanReverse(&High, (unsigned long)Len) ? (int)(High + 1) :
+                  0);
+#else
+    int Result = Len ? (64 - __builtin_clzll(Len)) : 0;
+#endif
+    return(Result);
+}
+
+static void
+MeowStatsCountHash(meow_u64 Len)
+{
+    meow_stats_slot *Slot = MeowStatsGetSlot();
+    int Bucket = MeowStatsBucket(Len);
+    MeowStatsAdd(Slot, &Slot->Stats.Calls[Bucket], 1);
+    MeowStatsAdd(Slot, &Slot->Stats.Bytes[Bucket], Len);
+}
+
+static void
+MeowStatsCountPath(int Path, meow_u64 Len)
+{
+    meow_stats_slot *Slot = MeowStatsGetSlot();
+    MeowStatsAdd(Slot, &Slot->Stats.PathCalls[Path], 1);
+    MeowStatsAdd(Slot, &Slot->Stats.PathBytes[Path], Len);
+}
+
+static int
+MeowStatsSnapshot(meow_stats *Snapshot)
+{
+    // NOTE: Returns how many threads have counted anything
+    int Result = 0;
+
+    meow_u64 *Total = (meow_u64 *)Snapshot;
+    int CounterCount = sizeof(meow_stats) / sizeof(meow_u64);
+    for(int Index = 0;
+        Index < CounterCount;
+        ++Index)
+    {
+        Total[Index] = 0;
+    }
+
+#if _MSC_VER && !defined(__clang__)
+    long Claimed = *(long volatile *)&MeowStatsSlotsClaimed;
+#else
+    long Claimed = __atomic_load_n(&MeowStatsSlotsClaimed, __ATOMIC_RELAXED);
+#endif
+    Result = (int)Claimed;
+
+    long SlotCount = (Claimed < MEOW_STATS_MAX_THREADS) ? Claimed : MEOW_STATS_MAX_THREADS;
+    for(long SlotIndex = 0;
+        SlotIndex < SlotCount;
+        ++SlotIndex)
+    {
+        meow_u64 *Counters = (meow_u64 *)&MeowStatsSlots[SlotIndex].Stats;
+        for(int Index = 0;
+            Index < CounterCount;
+            ++Index)
+        {
+#if _MSC_VER && !defined(__clang__)
+            Total[Index] += *(meow_u64 volatile *)(Counters + Index);
+#else
+            Total[Index] += __atomic_load_n(Counters + Index, __ATOMIC_RELAXED);
+#endif
+        }
+    }
+
+    return(Result);
+}
+
+#define MEOW_STATS_HASH(Len) MeowStatsCountHash(Len)
+#define MEOW_STATS_PATH(Path, Len) MeowStatsCountPath(Path, Len)
+#else
+#define MEOW_STATS_HASH(...)
+#define MEOW_STATS_PATH(...)
+#endif
+
+//
+// NOTE: Define MEOW_USDT to 1 to put USDT (SystemTap-style) static probes at the
+// entry and exit of MeowHash, MeowAbsorb and MeowEnd, so that bpftrace, perf or
+// SystemTap can watch the calls of a running program (see util/meow_trace.bt).  A
+// probe is a single nop plus an ELF note saying where its arguments live, so an
+// untraced call only pays for the nops and for having the arguments in hand;
+// durations come from the tracer's clock between the entry and exit probes.  The
+// notes are written here in the layout <sys/sdt.h> uses, so nothing needs to be
+// installed to build with them.
+//
+//   meow:hash_entry(Len, Source, Source & 63)      meow:hash_exit(Len, low 64 bits of hash)
+//   meow:absorb_entry(State, Len, Source & 63)     meow:absorb_exit(State, total length so far)
+//   meow:end_entry(State, total length)            meow:end_exit(State, low 64 bits of hash)
+//
+
+#if MEOW_USDT
+#if !__ELF__ || !__x86_64__
+#error MEOW_USDT probes are only available for x64 ELF targets
+#endif
+
+#define MEOW_USDT_ARG(Value) "nor"((meow_u64)(Value))
+#define MEOW_USDT_PROBE(Name, ArgFormat, ...) \
+__asm__ __volatile__( \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f, 994f-993f, 3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: .8byte 990b\n" \
+    ".8byte _.stapsdt.base\n" \
+    ".8byte 0\n" \
+    ".asciz \"meow\"\n" \
+    ".asciz \"" #Name "\"\n" \
+    ".asciz \"" ArgFormat "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base, 1\n" \
+    ".popsection\n" \
+    ".endif\n" \
+    : : __VA_ARGS__)
+
+#define MEOW_USDT_PROBE3(Name, A, B, C) MEOW_USDT_PROBE(Name, "8@%0 8@%1 8@%2", MEOW_USDT_ARG(A), MEOW_USDT_ARG(B), MEOW_USDT_ARG(C))
+#define MEOW_USDT_PROBE2(Name, A, B) MEOW_USDT_PROBE(Name, "8@%0 8@%1", MEOW_USDT_ARG(A), MEOW_USDT_ARG(B))
+#else
+#define MEOW_USDT_PROBE3(...)
+#define MEOW_USDT_PROBE2(...)
+#endif
+
 static meow_u8 MeowShiftAdjust[32] = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15};
 static meow_u8 MeowMaskLen[32] = {255,255,255,255, 255,255,255,255, 255,255,255,255, 255,255,255,255, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0};
 
@@ -264,6 +573,9 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     meow_u8 *rax = (meow_u8 *)SourceInit;
     meow_u8 *rcx = (meow_u8 *)Seed128Init;
     
+    MEOW_USDT_PROBE3(hash_entry, Len, rax, (meow_umm)rax & 63);
+    MEOW_STAGE_BEGIN(Len);
+    
     //
 	// NOTE(casey): Seed the eight hash registers
     //
@@ -285,6 +597,8 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     //
     
     meow_umm BlockCount = (Len >> 8);
+    MEOW_STATS_HASH(Len);
+    MEOW_STATS_PATH((BlockCount > MEOW_PREFETCH_LIMIT) ? MeowPath_OneShotPrefetch : MeowPath_OneShot, Len);
     if(BlockCount > MEOW_PREFETCH_LIMIT)
     {
         // NOTE(casey): For large input, modern Intel x64's can't hit full speed without prefetching, so we use this loop
@@ -326,6 +640,7 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     }
     
     MEOW_DUMP_STATE("PostBlocks", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_Blocks, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
     
     //
     // NOTE(casey): Load any less-than-32-byte residual
@@ -394,6 +709,7 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     MEOW_MIX_REG(xmm1, xmm5, xmm7, xmm2, xmm3,  xmm12, xmm13, xmm14, xmm15);
     
     MEOW_DUMP_STATE("PostAppend", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_Residuals, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
     
     //
     // NOTE(casey): Hash all full 32-byte blocks
@@ -414,6 +730,7 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     MixDown:
     
     MEOW_DUMP_STATE("PostLanes", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_Lanes, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
     
     MEOW_SHUFFLE(xmm0, xmm1, xmm2, xmm4, xmm5, xmm6);
     MEOW_SHUFFLE(xmm1, xmm2, xmm3, xmm5, xmm6, xmm7);
@@ -439,6 +756,8 @@ MeowHash(void *Seed128Init, meow_umm Len, void *SourceInit)
     paddq(xmm0, xmm4);
     
     MEOW_DUMP_STATE("PostFold", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_MixDown, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
+    MEOW_USDT_PROBE2(hash_exit, Len, _mm_cvtsi128_si64(xmm0));
     
     return(xmm0);
 }
@@ -541,6 +860,8 @@ MeowAbsorbBlocks(meow_state *State, meow_umm BlockCount, meow_u8 *rax)
 static void
 MeowAbsorb(meow_state *State, meow_umm Len, void *SourceInit)
 {
+    MEOW_USDT_PROBE3(absorb_entry, State, Len, (meow_umm)SourceInit & 63);
+    
     State->TotalLengthInBytes += Len;
     meow_u8 *Source = (meow_u8 *)SourceInit;
     
@@ -569,6 +890,11 @@ MeowAbsorb(meow_state *State, meow_umm Len, void *SourceInit)
     // NOTE(casey): Handle any full blocks
     meow_u64 BlockCount = (Len >> 8);
     meow_u64 Advance = (BlockCount << 8);
+    
+    // NOTE: The path is the loop these blocks take, which is only known once the
+    // residual has been filled; the bytes are all of this call's
+    MEOW_STATS_PATH((BlockCount > MEOW_PREFETCH_LIMIT) ? MeowPath_StreamPrefetch : MeowPath_Stream,
+                    (meow_umm)(Source - (meow_u8 *)SourceInit) + Len);
     MeowAbsorbBlocks(State, BlockCount, Source);
     
     Len -= Advance;
@@ -579,12 +905,16 @@ MeowAbsorb(meow_state *State, meow_umm Len, void *SourceInit)
     {
         State->Buffer[State->BufferLen++] = *Source++;
     }
+    
+    MEOW_USDT_PROBE2(absorb_exit, State, State->TotalLengthInBytes);
 }
 
 static meow_u128
 MeowEnd(meow_state *State, meow_u8 *Store128)
 {
     meow_umm Len = State->TotalLengthInBytes;
+    MEOW_USDT_PROBE2(end_entry, State, Len);
+    MEOW_STATS_HASH(Len);
     
     meow_u128 xmm0 = State->xmm0;
     meow_u128 xmm1 = State->xmm1;
@@ -599,6 +929,8 @@ MeowEnd(meow_state *State, meow_u8 *Store128)
     
     meow_u8 *rax = State->Buffer;
     
+    MEOW_STAGE_BEGIN(Len);
+    
     pxor_clear(xmm9, xmm9);
     pxor_clear(xmm11, xmm11);
     
@@ -639,6 +971,7 @@ MeowEnd(meow_state *State, meow_u8 *Store128)
     MEOW_MIX_REG(xmm1, xmm5, xmm7, xmm2, xmm3,  xmm12, xmm13, xmm14, xmm15);
     
     MEOW_DUMP_STATE("PostAppend", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_Residuals, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
     
     //
     // NOTE(casey): Hash all full 32-byte blocks
@@ -659,6 +992,7 @@ MeowEnd(meow_state *State, meow_u8 *Store128)
     MixDown:
     
     MEOW_DUMP_STATE("PostLanes", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_Lanes, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
     
     MEOW_SHUFFLE(xmm0, xmm1, xmm2, xmm4, xmm5, xmm6);
     MEOW_SHUFFLE(xmm1, xmm2, xmm3, xmm5, xmm6, xmm7);
@@ -696,6 +1030,8 @@ MeowEnd(meow_state *State, meow_u8 *Store128)
     paddq(xmm0, xmm4);
     
     MEOW_DUMP_STATE("PostFold", xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7, 0);
+    MEOW_STAGE_END(MeowStage_MixDown, xmm0, xmm1, xmm2, xmm3, xmm4, xmm5, xmm6, xmm7);
+    MEOW_USDT_PROBE2(end_exit, State, _mm_cvtsi128_si64(xmm0));
     
     return(xmm0);
 }
@@ -716,6 +1052,15 @@ MeowEnd(meow_state *State, meow_u8 *Store128)
 #undef MEOW_MIX_REG
 #undef MEOW_SHUFFLE
 #undef MEOW_DUMP_STATE
+#undef MEOW_STAGE_PIN
+#undef MEOW_STAGE_BEGIN
+#undef MEOW_STAGE_END
+#undef MEOW_STATS_HASH
+#undef MEOW_STATS_PATH
+#undef MEOW_USDT_ARG
+#undef MEOW_USDT_PROBE
+#undef MEOW_USDT_PROBE3
+#undef MEOW_USDT_PROBE2
 
 //
 // NOTE(casey): If you need to create your own seed from non-random data, you can use MeowExpandSeed
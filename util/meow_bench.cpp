@@ -13,6 +13,20 @@
 #include <math.h>
 #include <time.h>
 
+#if __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/utsname.h>
+#endif
+
 #ifdef __aarch64__
 // NOTE(mmozeiko): On ARM you normally cannot access cycle counter from user-space.
 // Download & build following kernel module that enables access to PMU cycle counter
@@ -58,6 +72,434 @@ _rotl(int unsigned Value, int Count)
 #define Mb(x) ((meow_u64)(x)*(meow_u64)1024*(meow_u64)1024)
 #define Gb(x) ((meow_u64)(x)*(meow_u64)1024*(meow_u64)1024*(meow_u64)1024)
 
+//
+// NOTE: Hardware performance counters
+//
+// TSC ticks run at a fixed rate no matter what the core is doing, so on a machine
+// with frequency scaling they can't tell a slower kernel from a slower clock.  On
+// Linux, perf_event_open gives us the core's real cycle count, plus instructions
+// and cache and TLB misses, so a regression can be pinned on the code or on the memory
+// system.  The counters are opened as one group so they are always scheduled
+// together, and read with rdpmc when the kernel allows it (a few dozen cycles)
+// instead of with a read() syscall (a microsecond or more).  Either way, the cost
+// of reading them is calibrated and subtracted.
+//
+
+#define PERF_MAX_EVENTS 8
+
+enum perf_fixed_event
+{
+    PerfEvent_Cycles,
+    PerfEvent_Instructions,
+    PerfEvent_L1DMisses,
+    PerfEvent_LLCMisses,
+    PerfEvent_DTLBMisses,
+    
+    PerfEvent_FixedCount,
+};
+
+struct perf_event_spec
+{
+    char const *Name;
+    meow_u32 Type;
+    meow_u64 Config;
+};
+
+struct perf_sample
+{
+    meow_u64 Values[PERF_MAX_EVENTS];
+};
+
+struct perf_counters
+{
+    int EventCount;
+    perf_event_spec Specs[PERF_MAX_EVENTS];
+    int Available[PERF_MAX_EVENTS];
+    
+    int LeaderFD;
+    int FDs[PERF_MAX_EVENTS];
+    void *Pages[PERF_MAX_EVENTS];
+    int UseRDPMC;
+    
+    meow_u64 Overhead[PERF_MAX_EVENTS];
+};
+
+#if __linux__
+
+static int
+OpenPerfCounters(perf_counters *Perf)
+{
+    Perf->LeaderFD = -1;
+    Perf->UseRDPMC = 1;
+    
+    int OpenCount = 0;
+    for(int EventIndex = 0;
+        EventIndex < Perf->EventCount;
+        ++EventIndex)
+    {
+        perf_event_spec *Spec = Perf->Specs + EventIndex;
+        
+        perf_event_attr Attr = {};
+        Attr.size = sizeof(Attr);
+        Attr.type = Spec->Type;
+        Attr.config = Spec->Config;
+        Attr.exclude_kernel = 1;
+        Attr.exclude_hv = 1;
+        Attr.read_format = PERF_FORMAT_GROUP;
+        if(Perf->LeaderFD < 0)
+        {
+            Attr.disabled = 1;
+            Attr.pinned = 1;
+        }
+        
+        int FD = (int)syscall(SYS_perf_event_open, &Attr, 0, -1, Perf->LeaderFD, 0);
+        Perf->FDs[EventIndex] = FD;
+        Perf->Pages[EventIndex] = 0;
+        Perf->Available[EventIndex] = (FD >= 0);
+        if(FD >= 0)
+        {
+            if(Perf->LeaderFD < 0)
+            {
+                Perf->LeaderFD = FD;
+            }
+            ++OpenCount;
+            
+            void *Page = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, FD, 0);
+            if(Page != MAP_FAILED)
+            {
+                Perf->Pages[EventIndex] = Page;
+            }
+        }
+    }
+    
+    if(OpenCount)
+    {
+        ioctl(Perf->LeaderFD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(Perf->LeaderFD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        
+        for(int EventIndex = 0;
+            EventIndex < Perf->EventCount;
+            ++EventIndex)
+        {
+            perf_event_mmap_page *Page = (perf_event_mmap_page *)Perf->Pages[EventIndex];
+            if(Perf->Available[EventIndex] && !(Page && Page->cap_user_rdpmc))
+            {
+                Perf->UseRDPMC = 0;
+            }
+        }
+#if !(__x86_64__ || __i386__)
+        Perf->UseRDPMC = 0;
+#endif
+    }
+    
+    return(OpenCount);
+}
+
+#if __x86_64__ || __i386__
+static meow_u64
+ReadPMC(meow_u32 Counter)
+{
+    meow_u32 Low, High;
+    __asm__ __volatile__("rdpmc" : "=a"(Low), "=d"(High) : "c"(Counter));
+    meow_u64 Result = ((meow_u64)High << 32) | Low;
+    return(Result);
+}
+#else
+#define ReadPMC(Counter) 0
+#endif
+
+static int
+ReadPerfCountersRDPMC(perf_counters *Perf, perf_sample *Sample)
+{
+    int Result = 1;
+    for(int EventIndex = 0;
+        Result && (EventIndex < Perf->EventCount);
+        ++EventIndex)
+    {
+        if(Perf->Available[EventIndex])
+        {
+            perf_event_mmap_page *Page = (perf_event_mmap_page *)Perf->Pages[EventIndex];
+            meow_u32 Sequence;
+            meow_u64 Count;
+            do
+            {
+                Sequence = Page->lock;
+                __asm__ __volatile__("" ::: "memory");
+                
+                meow_u32 Index = Page->index;
+                Count = Page->offset;
+                if(Index)
+                {
+                    int Width = Page->pmc_width;
+                    meow_u64 Raw = ReadPMC(Index - 1) << (64 - Width);
+                    Count += (meow_u64)((long long)Raw >> (64 - Width));
+                }
+                else
+                {
+                    // NOTE: The group isn't on the PMU right now, so rdpmc can't see it
+                    Result = 0;
+                }
+                
+                __asm__ __volatile__("" ::: "memory");
+            } while(Page->lock != Sequence);
+            
+            Sample->Values[EventIndex] = Count;
+        }
+    }
+    
+    return(Result);
+}
+
+static void
+ReadPerfCounters(perf_counters *Perf, perf_sample *Sample)
+{
+    if(!Perf->UseRDPMC || !ReadPerfCountersRDPMC(Perf, Sample))
+    {
+        meow_u64 Group[PERF_MAX_EVENTS + 1] = {};
+        if(read(Perf->LeaderFD, Group, sizeof(Group)) > 0)
+        {
+            int GroupIndex = 1;
+            for(int EventIndex = 0;
+                EventIndex < Perf->EventCount;
+                ++EventIndex)
+            {
+                if(Perf->Available[EventIndex])
+                {
+                    Sample->Values[EventIndex] = Group[GroupIndex++];
+                }
+            }
+        }
+    }
+}
+
+#else
+
+static int
+OpenPerfCounters(perf_counters *Perf)
+{
+    return(0);
+}
+
+static void
+ReadPerfCounters(perf_counters *Perf, perf_sample *Sample)
+{
+}
+
+#endif
+
+static void
+InitPerfCounters(perf_counters *Perf, char *RawEvents)
+{
+    Perf->EventCount = 0;
+    
+#if __linux__
+    perf_event_spec Fixed[] =
+    {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"L1D misses", PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_L1D |
+                                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))},
+        {"LLC misses", PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_LL |
+                                            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))},
+        {"dTLB misses", PERF_TYPE_HW_CACHE, (PERF_COUNT_HW_CACHE_DTLB |
+                                             (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))},
+    };
+    for(int EventIndex = 0;
+        EventIndex < PerfEvent_FixedCount;
+        ++EventIndex)
+    {
+        Perf->Specs[Perf->EventCount++] = Fixed[EventIndex];
+    }
+    
+    // NOTE: Raw events are model-specific (port utilization, for example), so they
+    // are passed in as comma-separated hex configs straight from the CPU's manual.
+    while(RawEvents && *RawEvents && (Perf->EventCount < PERF_MAX_EVENTS))
+    {
+        char *End = RawEvents;
+        meow_u64 Config = strtoull(RawEvents, &End, 16);
+        if(End == RawEvents)
+        {
+            break;
+        }
+        
+        char *Name = (char *)malloc(32);
+        sprintf(Name, "raw 0x%llx", Config);
+        perf_event_spec *Spec = Perf->Specs + Perf->EventCount++;
+        Spec->Name = Name;
+        Spec->Type = PERF_TYPE_RAW;
+        Spec->Config = Config;
+        
+        RawEvents = (*End == ',') ? (End + 1) : End;
+    }
+#endif
+    
+    if(!Perf->EventCount || !OpenPerfCounters(Perf))
+    {
+        Perf->EventCount = 0;
+    }
+}
+
+static void
+CalibratePerfCounters(perf_counters *Perf)
+{
+    // NOTE: Measure the exact sequence used around each hash call, minus the call,
+    // and keep the smallest count seen for each event as its fixed overhead.
+    for(int EventIndex = 0;
+        EventIndex < Perf->EventCount;
+        ++EventIndex)
+    {
+        Perf->Overhead[EventIndex] = (meow_u64)-1;
+    }
+    
+    for(int Run = 0;
+        Run < 1000;
+        ++Run)
+    {
+        perf_sample Start = {}, End = {};
+        int Ignored[4];
+        int unsigned Ignored2;
+        
+        ReadPerfCounters(Perf, &Start);
+        CPUID(Ignored, 0);
+        meow_u64 StartClock = __rdtsc();
+        meow_u64 EndClock = __rdtscp(&Ignored2);
+        CPUID(Ignored, 0);
+        ReadPerfCounters(Perf, &End);
+        (void)StartClock;
+        (void)EndClock;
+        
+        for(int EventIndex = 0;
+            EventIndex < Perf->EventCount;
+            ++EventIndex)
+        {
+            meow_u64 Delta = End.Values[EventIndex] - Start.Values[EventIndex];
+            if(Perf->Overhead[EventIndex] > Delta)
+            {
+                Perf->Overhead[EventIndex] = Delta;
+            }
+        }
+    }
+}
+
+static void
+PrintPerfCounters(perf_counters *Perf, FILE *Stream)
+{
+    if(Perf->EventCount)
+    {
+        fprintf(Stream, "Hardware counters (%s):\n", Perf->UseRDPMC ? "rdpmc" : "read syscall");
+        for(int EventIndex = 0;
+            EventIndex < Perf->EventCount;
+            ++EventIndex)
+        {
+            fprintf(Stream, "    %s: ", Perf->Specs[EventIndex].Name);
+            if(Perf->Available[EventIndex])
+            {
+                fprintf(Stream, "%.0f overhead per read pair\n", (double)Perf->Overhead[EventIndex]);
+            }
+            else
+            {
+                fprintf(Stream, "not available\n");
+            }
+        }
+    }
+    else
+    {
+        fprintf(Stream, "Hardware counters: not available (Linux perf_event_open only; check perf_event_paranoid)\n");
+    }
+    fprintf(Stream, "\n");
+}
+
+
+//
+// NOTE: Latency histograms
+//
+// The minimum and the best average say nothing about the tail, which is what
+// matters for small hashes on a latency-sensitive path.  Every call's clock count
+// goes into an HDR-style histogram: exact below 2*HISTOGRAM_SUB_COUNT, and above
+// that, HISTOGRAM_SUB_COUNT buckets per power of two (about 3% resolution), which
+// covers every 64-bit value in a few kilobytes.
+//
+
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKET_COUNT ((65 - HISTOGRAM_SUB_BITS)*HISTOGRAM_SUB_COUNT)
+
+// NOTE: A size whose p99 is more than this many times its p50 gets flagged
+#define UNSTABLE_TAIL_RATIO 2.0
+
+static int unsigned
+HighestBitIndex(meow_u64 Value)
+{
+#if _MSC_VER
+    unsigned long Result;
+    _BitScanReverse64(&Result, Value);
+    return((int unsigned)Result);
+#else
+    return(63 - __builtin_clzll(Value));
+#endif
+}
+
+static int unsigned
+HistogramBucket(meow_u64 Value)
+{
+    int unsigned Result = (int unsigned)Value;
+    if(Value >= 2*HISTOGRAM_SUB_COUNT)
+    {
+        int unsigned Shift = HighestBitIndex(Value) - HISTOGRAM_SUB_BITS;
+        Result = (Shift + 1)*HISTOGRAM_SUB_COUNT + (int unsigned)((Value >> Shift) - HISTOGRAM_SUB_COUNT);
+    }
+    return(Result);
+}
+
+static meow_u64
+HistogramBucketValue(int unsigned Bucket)
+{
+    // NOTE: Like HDR histograms, report the highest value the bucket could hold
+    meow_u64 Result = Bucket;
+    if(Bucket >= 2*HISTOGRAM_SUB_COUNT)
+    {
+        int unsigned Shift = (Bucket / HISTOGRAM_SUB_COUNT) - 1;
+        meow_u64 Low = (meow_u64)(HISTOGRAM_SUB_COUNT + (Bucket % HISTOGRAM_SUB_COUNT)) << Shift;
+        Result = Low + ((meow_u64)1 << Shift) - 1;
+    }
+    return(Result);
+}
+
+static meow_u64
+HistogramPercentile(meow_u32 *Histogram, meow_u64 SampleCount, meow_u64 MaxValue, double Percentile)
+{
+    meow_u64 Target = (meow_u64)ceil(Percentile*(double)SampleCount);
+    if(Target < 1)
+    {
+        Target = 1;
+    }
+    
+    meow_u64 Result = MaxValue;
+    meow_u64 Seen = 0;
+    for(int unsigned Bucket = 0;
+        Bucket < HISTOGRAM_BUCKET_COUNT;
+        ++Bucket)
+    {
+        Seen += Histogram[Bucket];
+        if(Seen >= Target)
+        {
+            Result = HistogramBucketValue(Bucket);
+            break;
+        }
+    }
+    
+    // NOTE: The bucket's top can overshoot the largest value actually seen
+    if(Result > MaxValue)
+    {
+        Result = MaxValue;
+    }
+    
+    return(Result);
+}
+
 struct test_results
 {
     int unsigned HashType;
@@ -68,6 +510,31 @@ struct test_results
     
     double MinBPC;
     double ExpBPC;
+    
+    meow_u64 P50Clocks;
+    meow_u64 P90Clocks;
+    meow_u64 P99Clocks;
+    meow_u64 P999Clocks;
+    meow_u64 MaxClocks;
+    int UnstableTail;
+    
+    // NOTE: Set when the isolated runner threw away too many windows to trust the rest
+    int Unreliable;
+    
+    // NOTE: Kept whole for the JSON results
+    char const *SizeClass;
+    meow_u64 SampleCount;
+    meow_u32 Histogram[HISTOGRAM_BUCKET_COUNT];
+    
+    // NOTE: Zero when the hardware counters aren't available
+    double CoreBPC;
+    double IPC;
+    double PerfPerCall[PERF_MAX_EVENTS];
+    
+    // NOTE: Zero when the roofline wasn't measured
+    char const *MemoryLevel;
+    double ReadBPC;
+    double CopyBPC;
 };
 
 struct input_size_test
@@ -76,12 +543,29 @@ struct input_size_test
     meow_u64 ClockAccum;
     meow_u64 ClockExp;
     meow_u64 ClockMin;
+    meow_u64 ClockMax;
+    
+    meow_u64 SampleCount;
+    meow_u32 Histogram[HISTOGRAM_BUCKET_COUNT];
     
     // NOTE(casey): We use a fake result target for writing in hopes of convincing the optimizer
     // that the computed hashes are actually used, and so won't be optimized out.
     meow_u128 FakeSlot;
     
     meow_u64 Size;
+    
+    meow_u64 PerfCount;
+    meow_u64 PerfAccum[PERF_MAX_EVENTS];
+    
+    // NOTE: Timestamp ticks spent on this size, overhead included, for the time budget
+    meow_u64 SpentClocks;
+    int StopReason;
+    meow_u64 NextConvergeCheck;
+    
+    // NOTE: How fast a plain read loop and memcpy get through this size, in the same cache state
+    char const *MemoryLevel;
+    double ReadBPC;
+    double CopyBPC;
 };
 
 #ifdef __aarch64__
@@ -96,12 +580,14 @@ struct input_size_tests
     meow_u64 MaxClockCount;
     meow_u64 RunsPerHashImplementation;
     int unsigned ClocksPerAvg;
+    int unsigned SizeCount;
     input_size_test Sizes[SIZE_COUNT_PER_BATCH];
 
     int unsigned ResultCount;
     test_results Results[SIZE_COUNT_PER_BATCH * SIZE_TYPE_COUNT * ArrayCount(NamedHashTypes)];
     
     meow_u64 SizeSeries;
+    char const *ClassName;
     char Name[64];
 };
 
@@ -165,7 +651,18 @@ CommitResults(int unsigned HashType, input_size_test *Test, input_size_tests *De
         Results->HashType = HashType;
         Results->Size = Test->Size;
         Results->MinClocks = Test->ClockMin;
+        
+        Results->P50Clocks = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.5);
+        Results->P90Clocks = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.9);
+        Results->P99Clocks = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.99);
+        Results->P999Clocks = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.999);
+        Results->MaxClocks = Test->ClockMax;
+        Results->UnstableTail = ((double)Results->P99Clocks > UNSTABLE_TAIL_RATIO*(double)Results->P50Clocks);
         Results->ExpClocks = Test->ClockExp;
+        Results->SizeClass = DestTests->ClassName;
+        Results->Unreliable = 0;
+        Results->SampleCount = Test->SampleCount;
+        memcpy(Results->Histogram, Test->Histogram, sizeof(Results->Histogram));
         
         Results->ExpBPC = 0.0f;
         if(Results->ExpClocks)
@@ -178,11 +675,47 @@ CommitResults(int unsigned HashType, input_size_test *Test, input_size_tests *De
         {
             Results->MinBPC = (double)Test->Size / (double)Results->MinClocks;
         }
+        
+        Results->CoreBPC = 0.0f;
+        Results->IPC = 0.0f;
+        for(int EventIndex = 0;
+            EventIndex < PERF_MAX_EVENTS;
+            ++EventIndex)
+        {
+            Results->PerfPerCall[EventIndex] = 0.0f;
+            if(Test->PerfCount)
+            {
+                Results->PerfPerCall[EventIndex] = (double)Test->PerfAccum[EventIndex] / (double)Test->PerfCount;
+            }
+        }
+        
+        double Cycles = Results->PerfPerCall[PerfEvent_Cycles];
+        if(Cycles > 0.0)
+        {
+            Results->CoreBPC = (double)Test->Size / Cycles;
+            Results->IPC = Results->PerfPerCall[PerfEvent_Instructions] / Cycles;
+        }
+        
+        Results->MemoryLevel = Test->MemoryLevel;
+        Results->ReadBPC = Test->ReadBPC;
+        Results->CopyBPC = Test->CopyBPC;
     }
     
     return(Results);
 }
 
+// NOTE: Expected throughput as a percentage of the read roofline, or 0 if it wasn't measured
+static double
+RooflinePercent(test_results *Results)
+{
+    double Result = 0.0;
+    if(Results->ReadBPC > 0.0)
+    {
+        Result = 100.0*Results->ExpBPC / Results->ReadBPC;
+    }
+    return(Result);
+}
+
 static int unsigned
 Random(meow_u64 *Series)
 {
@@ -269,8 +802,10 @@ InitializeTests(input_size_tests *Tests, int unsigned SizeType, meow_u64 MaxCloc
     }
     
     sprintf(Tests->Name, "%s%u", NameBase, SizeType);
+    Tests->ClassName = NameBase;
     Tests->ClocksPerAvg = ClocksPerAvg;
     Tests->MaxClockCount = (MaxClockCount / Divisor);
+    Tests->SizeCount = ArrayCount(Tests->Sizes);
     Tests->RunsPerHashImplementation = (ArrayCount(Tests->Sizes) * Tests->MaxClockCount);
     
 #if MEOW_TEST_BENCH_QUICK
@@ -278,538 +813,5121 @@ InitializeTests(input_size_tests *Tests, int unsigned SizeType, meow_u64 MaxCloc
 #endif
 }
 
-static void
-PrintLeaderboard(input_size_tests *Tests, FILE *Stream)
+//
+// NOTE: Targeted runs
+//
+// Instead of the 64 built-in size batches, -size gives the sizes to run (for
+// example "64,100-200:4,1k-1m"), which are sorted and run 16 to a batch.  A
+// bare range gets SIZE_COUNT_PER_BATCH sizes spaced geometrically between its
+// ends; a range with ":step" gets every step'th size.  Each batch runs as many
+// calls as the built-in batch its largest size would belong to, unless a cell
+// (one hash at one size) stops early, either because it has used up its time
+// budget or because the confidence interval on its median is already tight.
+//
+
+#define MAX_SELECTED_SIZES (SIZE_COUNT_PER_BATCH*SIZE_TYPE_COUNT)
+
+// NOTE: Convergence is checked every this many calls to a cell, once it has at least the minimum
+#define CONVERGE_CHECK_INTERVAL 1024
+#define CONVERGE_MIN_SAMPLES 2048
+
+enum stop_reason
 {
-    fprintf(Stream, "Leaderboard:\n");
+    Stop_None,
+    Stop_Budget,
+    Stop_Converged,
+};
+
+static char const *StopReasonNames[] = {"", "budget", "converged"};
+
+static meow_u64
+ParseSize(char *At, char **End)
+{
+    meow_u64 Result = strtoull(At, End, 10);
+    switch(**End)
+    {
+        case 'k': case 'K': {Result = Kb(Result); ++*End;} break;
+        case 'm': case 'M': {Result = Mb(Result); ++*End;} break;
+        case 'g': case 'G': {Result = Gb(Result); ++*End;} break;
+    }
     
-    qsort(Tests->Results, Tests->ResultCount, sizeof(Tests->Results[0]), ResultCompare);
+    return(Result);
+}
+
+static int
+CompareSizes(const void *AInit, const void *BInit)
+{
+    meow_u64 A = *(meow_u64 *)AInit;
+    meow_u64 B = *(meow_u64 *)BInit;
+    int Result = (A < B) ? -1 : (A > B) ? 1 : 0;
+    return(Result);
+}
+
+static int
+ParseSizeList(char *List, meow_u64 *Sizes, int MaxSizeCount)
+{
+    int Result = 0;
     
-    int unsigned ResultIndex = 0;
-    while(ResultIndex < Tests->ResultCount)
+    char *At = List;
+    while(*At && (Result >= 0))
     {
-        test_results *BestResults = Tests->Results + ResultIndex;
-        
-        meow_u64 CurSize = BestResults->Size;
-        meow_u64 ExpClocks = BestResults->ExpClocks;
-        meow_u64 MaxClocks = ExpClocks; // + (ExpClocks/ 100);
-        
-        fprintf(Stream, "    ");
-        PrintSize(Stream, BestResults->Size, true);
-        fprintf(Stream, ": %10.0f (%6.03f bytes/cycle) - ",
-                (double)BestResults->ExpClocks, (double)BestResults->ExpBPC);
-        
-        int TieCount = 0;
-        while(ResultIndex < Tests->ResultCount)
+        char *End = At;
+        meow_u64 First = ParseSize(At, &End);
+        meow_u64 Last = First;
+        meow_u64 Step = 0;
+        if(*End == '-')
         {
-            test_results *Results = Tests->Results + ResultIndex;
-            if(Results->Size == CurSize)
+            Last = ParseSize(End + 1, &End);
+            if(*End == ':')
             {
-                if(Results->ExpClocks <= MaxClocks)
+                Step = ParseSize(End + 1, &End);
+                if(!Step)
                 {
-                    named_hash_type Type = NamedHashTypes[Results->HashType];
-                    
-                    if(TieCount)
-                    {
-                        fprintf(Stream, ", ");
-                    }
-                    
-                    fprintf(Stream, "%s", Type.FullName);
-                    
-                    ++TieCount;
+                    End = At;
                 }
-                ++ResultIndex;
-            }
-            else
-            {
-                break;
             }
         }
-        if(TieCount > 1)
+        
+        if((End == At) || ((*End != ',') && *End) || (Last < First) || (Last > MAX_SIZE_TO_TEST))
         {
-            fprintf(Stream, " (%d-way tie)", TieCount);
+            Result = -1;
+            break;
         }
-        fprintf(Stream, "\n");
-    }
-}
         
-void
-WriteCSV(input_size_tests *Tests, char *CSVFileName)
-{
-    int unsigned TypeCount = ArrayCount(NamedHashTypes);
-
-    FILE *CSV = fopen(CSVFileName, "w");
-    if(CSV)
-    {
-        meow_u64 LastSize = 0;
-        fprintf(CSV, "Input");
-        for(int ResultIndex = 0;
-            ResultIndex < Tests->ResultCount;
-            ++ResultIndex)
+        if(Step)
         {
-            test_results *Results = Tests->Results + ResultIndex;
-            if(Results->Size != LastSize)
+            for(meow_u64 Size = First;
+                (Size <= Last) && (Result < MaxSizeCount);
+                Size += Step)
             {
-                LastSize = Results->Size;
-                fprintf(CSV, ",%.0f", (double)LastSize);
+                Sizes[Result++] = Size;
             }
         }
-        fprintf(CSV, "\n");
-        
-        LastSize = 0;
-        for(int TypeIndex = 0;
-            TypeIndex < TypeCount;
-            ++TypeIndex)
+        else if(First == Last)
         {
-            named_hash_type Type = NamedHashTypes[TypeIndex];
-            fprintf(CSV, "%s", Type.FullName);
-            for(int ResultIndex = 0;
-                ResultIndex < Tests->ResultCount;
-                ++ResultIndex)
+            if(Result < MaxSizeCount)
             {
-                test_results *Results = Tests->Results + ResultIndex;
-                if((Results->HashType == TypeIndex) &&
-                   (Results->Size != LastSize))
-                {
-                    LastSize = Results->Size;
-                    fprintf(CSV, ",%f", Results->ExpBPC);
-                }
+                Sizes[Result++] = First;
             }
-            fprintf(CSV, "\n");
         }
-        fprintf(CSV, "\n");
-        fprintf(CSV, "\n");
-        for(int TypeIndex = 0;
-            TypeIndex < TypeCount;
-            ++TypeIndex)
+        else
         {
-            named_hash_type Type = NamedHashTypes[TypeIndex];
-            fprintf(CSV, "%s", Type.FullName);
-            for(int ResultIndex = 0;
-                ResultIndex < Tests->ResultCount;
-                ++ResultIndex)
+            double Low = First ? (double)First : 1.0;
+            double Ratio = pow((double)Last / Low, 1.0 / (SIZE_COUNT_PER_BATCH - 1));
+            for(int Index = 0;
+                (Index < SIZE_COUNT_PER_BATCH) && (Result < MaxSizeCount);
+                ++Index)
             {
-                test_results *Results = Tests->Results + ResultIndex;
-                if((Results->HashType == TypeIndex) &&
-                   (Results->Size != LastSize))
+                meow_u64 Size = (Index == 0) ? First : (meow_u64)(Low*pow(Ratio, Index) + 0.5);
+                if(Size > Last)
                 {
-                    LastSize = Results->Size;
-                    fprintf(CSV, ",%f", Results->MinBPC);
+                    Size = Last;
                 }
+                Sizes[Result++] = Size;
             }
-            fprintf(CSV, "\n");
         }
-        fprintf(CSV, "\n");
-        fclose(CSV);
+        
+        At = *End ? End + 1 : End;
     }
-    else
+    
+    if(Result > 0)
     {
-        fprintf(stderr, "    (unable to open %s for writing)\n",
-                CSVFileName);
+        qsort(Sizes, Result, sizeof(Sizes[0]), CompareSizes);
+        
+        int Unique = 1;
+        for(int Index = 1;
+            Index < Result;
+            ++Index)
+        {
+            if(Sizes[Index] != Sizes[Unique - 1])
+            {
+                Sizes[Unique++] = Sizes[Index];
+            }
+        }
+        Result = Unique;
     }
+    
+    return(Result);
 }
 
-void
-WriteHTML(input_size_tests *Tests, char *HTMLFileName)
+static void
+InitializeSelectedTests(input_size_tests *Tests, meow_u64 *Sizes, int unsigned SizeCount,
+                        int unsigned BatchIndex, meow_u64 MaxClockCount)
 {
-    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    // NOTE: These match the classes in InitializeTests, by the largest size in the batch
+    meow_u64 Largest = Sizes[SizeCount - 1];
+    char *NameBase = (char *)"Tiny Input";
+    meow_u64 Divisor = 1;
+    int unsigned ClocksPerAvg = 100;
+    if(Largest > Mb(48))
+    {
+        NameBase = (char *)"Giant Input";
+        Divisor = 500000;
+        ClocksPerAvg = 1;
+    }
+    else if(Largest > Mb(4))
+    {
+        NameBase = (char *)"Large Input";
+        Divisor = 10000;
+        ClocksPerAvg = 5;
+    }
+    else if(Largest > Kb(512))
+    {
+        NameBase = (char *)"Medium Input";
+        Divisor = 200;
+        ClocksPerAvg = 10;
+    }
+    else if(Largest > Kb(4))
+    {
+        NameBase = (char *)"Small Input";
+        Divisor = 50;
+    }
+    
+    for(int unsigned Index = 0;
+        Index < SizeCount;
+        ++Index)
+    {
+        Tests->Sizes[Index].Size = Sizes[Index];
+    }
+    
+    sprintf(Tests->Name, "Selected %s%u", NameBase, BatchIndex);
+    Tests->ClassName = NameBase;
+    Tests->SizeCount = SizeCount;
+    Tests->ClocksPerAvg = ClocksPerAvg;
+    Tests->MaxClockCount = (MaxClockCount / Divisor);
+    Tests->RunsPerHashImplementation = (SizeCount * Tests->MaxClockCount);
+    
+#if MEOW_TEST_BENCH_QUICK
+    Tests->RunsPerHashImplementation /= 32;
+#endif
+}
 
-    // NOTE(casey): Dear C++ committee: how about you define the string as writable IF I TOLD YOU IT WAS WRITABLE
-    // instead of making it constant?  Oh, that's right - because you don't care what the programmer wants,
-    // you're always right about how code should work.  My bad.  So I get to type the word "const" three times
-    // for no reason whatsoever.  Nice work!  You really saved the day.
-    char const *CrappyColorTable[] =
+static double
+EstimateTimestampFrequency(void)
+{
+    // NOTE: Budgets are given in seconds but spent in timestamp ticks
+    double StartTime = GetWallClock();
+    meow_u64 StartClock = __rdtsc();
+    double EndTime = StartTime;
+    while((EndTime - StartTime) < 0.05)
     {
-        "#477ea0",
-        "#84ab3c",
-        "#50c76d",
-        "#d8823a",
-        "#da5bd5",
-        "#d63636",
-        "#897cd0",
-        "#949494",
-        "#af5f9d",
-        "#2ac4c5",
-        "#3b17c1",
-        "#ff0000", // TODO(casey): Real color here
-    };
+        EndTime = GetWallClock();
+    }
+    meow_u64 EndClock = __rdtsc();
     
-    FILE *Out = fopen(HTMLFileName, "w");
-    if(Out)
+    double Result = (double)(EndClock - StartClock) / (EndTime - StartTime);
+    return(Result);
+}
+
+static int
+MedianHasConverged(input_size_test *Test, double Tolerance)
+{
+    int Result = 0;
+    
+    if(Test->SampleCount >= CONVERGE_MIN_SAMPLES)
     {
-        fprintf(Out, "<!DOCTYPE html><html lang='en' itemscope itemtype='https://schema.org/Article'><head>\n");
-        fprintf(Out, "</head>\n");
-        fprintf(Out, "<body>\n");
-        
-        double MaxSizeCoord = log(1.0f + MAX_SIZE_TO_TEST);
-        double MaxSpeedCoord = 16.0; // TODO(casey): Should probably scan for this, eventually
+        // NOTE: A distribution-free 95% confidence interval for the median lies
+        // between the order statistics at n/2 -/+ 0.98*sqrt(n).  It can't get any
+        // tighter than the histogram's buckets, so a tolerance below their ~3% only
+        // stops once both ends are in the same bucket.
+        double N = (double)Test->SampleCount;
+        double HalfWidth = 0.98*sqrt(N) / N;
+        meow_u64 Low = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.5 - HalfWidth);
+        meow_u64 High = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.5 + HalfWidth);
+        meow_u64 Median = HistogramPercentile(Test->Histogram, Test->SampleCount, Test->ClockMax, 0.5);
         
+        Result = ((double)(High - Low) <= 2.0*Tolerance*(double)Median);
+    }
+    
+    return(Result);
+}
+
+static void
+RecordSample(input_size_test *Test, meow_u64 Clocks, meow_u64 *PerfDeltas, int PerfEventCount, int unsigned ClocksPerAvg)
+{
+    if(PerfEventCount)
+    {
+        for(int EventIndex = 0;
+            EventIndex < PerfEventCount;
+            ++EventIndex)
         {
-            meow_u64 LastSize = -1;
-            fprintf(Out, "<svg id='Graph' style='width:100%%;height:50vh;user-select:none;' viewBox='0 0 %f %f'>\n", MaxSizeCoord, MaxSpeedCoord);
+            Test->PerfAccum[EventIndex] += PerfDeltas[EventIndex];
+        }
+        ++Test->PerfCount;
+    }
+    
+    Test->ClockCount += 1;
+    Test->ClockAccum += Clocks;
+    
+    if(Test->ClockMin > Clocks)
+    {
+        Test->ClockMin = Clocks;
+    }
+    if(Test->ClockMax < Clocks)
+    {
+        Test->ClockMax = Clocks;
+    }
+    ++Test->Histogram[HistogramBucket(Clocks)];
+    ++Test->SampleCount;
+    
+    if(Test->ClockCount == ClocksPerAvg)
+    {
+        meow_u64 ExpClocks = Test->ClockAccum / Test->ClockCount;
+        if(Test->ClockExp > ExpClocks)
+        {
+            Test->ClockExp = ExpClocks;
+        }
+        
+        Test->ClockAccum = 0;
+        Test->ClockCount = 0;
+    }
+}
 
-            fprintf(Out, "<g id='ViewXForm'>\n");
-            double XLine = 1.0f;
-            for(int XIndex = 0;
-                ;
-                ++XIndex)
-            {
-                if(XIndex)
-                {
-                    double XCoord = log(1.0f + XLine);
-                    if(XCoord < MaxSizeCoord)
-                    {
-                        char const *Color = "#eeeeee";
-                        if((XIndex % 4) == 0)
-                        {
-                            Color = "#888888";
-                            
-                            fprintf(Out, "<text x='%f' y='%f' fill='%s' font-size='0.5' alignment-baseline='baseline'>", XCoord, MaxSpeedCoord, Color);
-                            PrintSize(Out, XLine, false, false);
-                            fprintf(Out, "</text>\n");
-                        }
-                        
-                        fprintf(Out, "<line x1='%f' y1='0' x2='%f' y2='%f' vector-effect='non-scaling-stroke' stroke='%s' stroke-width='1.0' />\n",
-                                XCoord, XCoord, MaxSpeedCoord, Color);
-                        
-                        XLine *= 2.0f;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
-            }
-            
-            double YLine = 0.0f;
-            for(;;)
+static int
+CheckForStop(input_size_test *Test, meow_u64 BudgetClocks, double ConvergeTolerance)
+{
+    // NOTE: Returns whether the size just stopped
+    int Result = 0;
+    if(Test->StopReason == Stop_None)
+    {
+        if(BudgetClocks && (Test->SpentClocks >= BudgetClocks))
+        {
+            Test->StopReason = Stop_Budget;
+            Result = 1;
+        }
+        else if((ConvergeTolerance > 0.0) && (Test->SampleCount >= Test->NextConvergeCheck))
+        {
+            Test->NextConvergeCheck = Test->SampleCount + CONVERGE_CHECK_INTERVAL;
+            if(MedianHasConverged(Test, ConvergeTolerance))
             {
-                double YCoord = (MaxSpeedCoord - YLine);
-                if(YLine < MaxSpeedCoord)
-                {
-                    char const *Color = "#eeeeee";
-                    if((YLine != 0.0) && (fmod(YLine, 4.0) == 0.0))
-                    {
-                        Color = "#888888";
-                        
-                        char Label[32];
-                        sprintf(Label, "%.0fb/c", YLine);
-                        fprintf(Out, "<text x='0' y='%f' fill='#888888' font-size='0.5' alignment-baseline='hanging'>%s</text>\n", YCoord, Label);
-                    }
-                    
-                    fprintf(Out, "<line x1='0' y1='%f' x2='%f' y2='%f' vector-effect='non-scaling-stroke' stroke='%s' stroke-width='1.0' />\n",
-                            YCoord, MaxSizeCoord, YCoord, Color);
-                    
-                    YLine += 1.0f;
-                }
-                else
-                {
-                    break;
-                }
+                Test->StopReason = Stop_Converged;
+                Result = 1;
             }
+        }
+    }
+    
+    return(Result);
+}
 
-            fprintf(Out, "<line id='size_line' x1='0' y1='0' x2='0' y2='%f' vector-effect='non-scaling-stroke' stroke='#ffaaaa' stroke-width='3.0' />\n", MaxSpeedCoord);
-            fprintf(Out, "<line id='speed_line' x1='0' y1='0' x2='%f' y2='0' vector-effect='non-scaling-stroke' stroke='#ffaaaa' stroke-width='3.0' />\n", MaxSizeCoord);
+//
+// NOTE: Isolated runner
+//
+// CPUID serialization keeps the processor from overlapping the timed call with
+// anything else, but does nothing about the rest of the machine.  On a shared host
+// the numbers move around with whatever else is scheduled on the core, and with
+// the core's clock, which the TSC doesn't see change.  -isolate pins the benchmark
+// to one processor (-pin to choose it, otherwise the last one it is allowed on,
+// since processor 0 usually takes the most interrupts), optionally raises it to
+// SCHED_FIFO (-fifo), and warms up until the core clock has settled.
+//
+// The calls are then timed in windows of about a millisecond.  At the end of each
+// window the core clock is measured against its settled value, using perf's cycle
+// count against the TSC or, failing that, the APERF/MPERF MSRs, and the thread's
+// context switches are checked.  Windows where the clock moved (turbo or
+// throttling) or the thread was switched out are thrown away whole, and if too
+// many of a hash's windows are thrown away its results are marked UNRELIABLE
+// instead of being printed as if they meant something.
+//
 
-            for(int TypeIndex = 0;
-                TypeIndex < TypeCount;
+#define RUNNER_WINDOW_SECONDS 0.001
+#define RUNNER_WINDOW_MAX_SAMPLES 4096
+#define RUNNER_WARMUP_WINDOW_SECONDS 0.01
+#define RUNNER_WARMUP_MAX_SECONDS 3.0
+// NOTE: Used when the core clock can't be measured, so there's nothing to wait for
+#define RUNNER_WARMUP_BLIND_SECONDS 0.5
+#define RUNNER_SETTLE_WINDOWS 5
+#define RUNNER_FREQUENCY_TOLERANCE 0.02
+#define RUNNER_DEFAULT_NOISE_PERCENT 10.0
+
+struct window_sample
+{
+    meow_u32 TestIndex;
+    meow_u64 Clocks;
+    meow_u64 PerfDeltas[PERF_MAX_EVENTS];
+};
+
+struct runner_clocks
+{
+    meow_u64 TSC;
+    meow_u64 Core;
+    meow_u64 Reference;
+    meow_u64 Switches;
+};
+
+// NOTE: A fake result target for the warm-up, like input_size_test::FakeSlot
+static meow_u128 RunnerFakeSlot;
+
+struct runner
+{
+    int Enabled;
+    int Processor;
+    int FIFO;
+    double NoiseThreshold;
+    
+    // NOTE: Where the core clock comes from, if anywhere
+    int UsePerfCycles;
+    int MSRHandle;
+    
+    double WindowTicks;
+    double SettledRatio;
+    
+    int SampleCount;
+    window_sample *Samples;
+    runner_clocks WindowStart;
+    
+    meow_u64 WindowCount;
+    meow_u64 RejectedFrequency;
+    meow_u64 RejectedSwitched;
+    double MinRatio;
+    double MaxRatio;
+};
+
+static meow_u64
+GetContextSwitchCount(void)
+{
+    meow_u64 Result = 0;
+#if __linux__
+    struct rusage Usage;
+    if(getrusage(RUSAGE_THREAD, &Usage) == 0)
+    {
+        Result = (meow_u64)Usage.ru_nvcsw + (meow_u64)Usage.ru_nivcsw;
+    }
+#endif
+    return(Result);
+}
+
+static meow_u64
+ReadMSR(int Handle, meow_u32 Register)
+{
+    meow_u64 Result = 0;
+#if __linux__
+    if(pread(Handle, &Result, sizeof(Result), Register) != sizeof(Result))
+    {
+        Result = 0;
+    }
+#endif
+    return(Result);
+}
+
+static runner_clocks
+ReadRunnerClocks(runner *Runner, perf_counters *Perf)
+{
+    runner_clocks Result = {};
+    Result.TSC = __rdtsc();
+    if(Runner->UsePerfCycles)
+    {
+        perf_sample Sample;
+        ReadPerfCounters(Perf, &Sample);
+        Result.Core = Sample.Values[PerfEvent_Cycles];
+        Result.Reference = Result.TSC;
+    }
+    else if(Runner->MSRHandle >= 0)
+    {
+        // NOTE: IA32_APERF and IA32_MPERF
+        Result.Core = ReadMSR(Runner->MSRHandle, 0xE8);
+        Result.Reference = ReadMSR(Runner->MSRHandle, 0xE7);
+    }
+    Result.Switches = GetContextSwitchCount();
+    
+    return(Result);
+}
+
+static double
+CoreClockRatio(runner *Runner, runner_clocks Start, runner_clocks End)
+{
+    // NOTE: Core clocks per reference clock, or 0 if there's no core clock
+    double Result = 0.0;
+    if((Runner->UsePerfCycles || (Runner->MSRHandle >= 0)) && (End.Reference > Start.Reference))
+    {
+        Result = (double)(End.Core - Start.Core) / (double)(End.Reference - Start.Reference);
+    }
+    return(Result);
+}
+
+static int
+InitRunner(runner *Runner, int Processor, perf_counters *Perf)
+{
+    int Result = 1;
+    
+    if(Processor < 0)
+    {
+        Runner->Processor = PinCurrentThread(GetProcessorCount() - 1);
+    }
+    else
+    {
+        Runner->Processor = PinToProcessor(Processor) ? Processor : -1;
+    }
+    
+    if(Runner->Processor < 0)
+    {
+        fprintf(stderr, "ERROR: Unable to pin to processor %d\n", Processor);
+        Result = 0;
+    }
+    
+    if(Result && Runner->FIFO)
+    {
+#if _WIN32
+        Runner->FIFO = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#elif __linux__
+        sched_param Param = {};
+        Param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        Runner->FIFO = (sched_setscheduler(0, SCHED_FIFO, &Param) == 0);
+#else
+        Runner->FIFO = 0;
+#endif
+        if(!Runner->FIFO)
+        {
+            fprintf(stderr, "WARNING: Unable to switch to real-time scheduling (not privileged?)\n");
+        }
+    }
+    
+    Runner->UsePerfCycles = (Perf->EventCount > PerfEvent_Cycles) && Perf->Available[PerfEvent_Cycles];
+    Runner->MSRHandle = -1;
+#if __linux__
+    if(!Runner->UsePerfCycles)
+    {
+        char MSRName[64];
+        sprintf(MSRName, "/dev/cpu/%d/msr", Runner->Processor);
+        Runner->MSRHandle = open(MSRName, O_RDONLY);
+        if((Runner->MSRHandle >= 0) && !ReadMSR(Runner->MSRHandle, 0xE7))
+        {
+            close(Runner->MSRHandle);
+            Runner->MSRHandle = -1;
+        }
+    }
+#endif
+    
+    Runner->WindowTicks = RUNNER_WINDOW_SECONDS*EstimateTimestampFrequency();
+    Runner->Samples = (window_sample *)malloc(RUNNER_WINDOW_MAX_SAMPLES*sizeof(window_sample));
+    
+    return(Result);
+}
+
+static void
+WarmUpRunner(runner *Runner, perf_counters *Perf, void *Buffer, meow_u64 BufferSize)
+{
+    // NOTE: Hash continuously, the way the benchmark will, until the core clock
+    // has held steady for RUNNER_SETTLE_WINDOWS windows in a row
+    meow_u64 Size = (BufferSize < Kb(64)) ? BufferSize : Kb(64);
+    int Measurable = (Runner->UsePerfCycles || (Runner->MSRHandle >= 0));
+    double StartTime = GetWallClock();
+    double Ratios[RUNNER_SETTLE_WINDOWS] = {};
+    int WindowCount = 0;
+    int Settled = 0;
+    while(!Settled)
+    {
+        runner_clocks Start = ReadRunnerClocks(Runner, Perf);
+        double WindowStart = GetWallClock();
+        while((GetWallClock() - WindowStart) < RUNNER_WARMUP_WINDOW_SECONDS)
+        {
+            RunnerFakeSlot = MeowHash(MeowDefaultSeed, Size, Buffer);
+        }
+        runner_clocks End = ReadRunnerClocks(Runner, Perf);
+        
+        double Elapsed = GetWallClock() - StartTime;
+        if(Measurable)
+        {
+            Ratios[WindowCount++ % RUNNER_SETTLE_WINDOWS] = CoreClockRatio(Runner, Start, End);
+            if(WindowCount >= RUNNER_SETTLE_WINDOWS)
+            {
+                double Min = Ratios[0], Max = Ratios[0], Sum = 0.0;
+                for(int Index = 0;
+                    Index < RUNNER_SETTLE_WINDOWS;
+                    ++Index)
+                {
+                    Min = (Ratios[Index] < Min) ? Ratios[Index] : Min;
+                    Max = (Ratios[Index] > Max) ? Ratios[Index] : Max;
+                    Sum += Ratios[Index];
+                }
+                Runner->SettledRatio = Sum / RUNNER_SETTLE_WINDOWS;
+                Settled = ((Max - Min) <= RUNNER_FREQUENCY_TOLERANCE*Runner->SettledRatio);
+            }
+            
+            if(!Settled && (Elapsed >= RUNNER_WARMUP_MAX_SECONDS))
+            {
+                fprintf(stderr, "WARNING: The core clock didn't settle during %.1fs of warm-up\n", Elapsed);
+                break;
+            }
+        }
+        else
+        {
+            Settled = (Elapsed >= RUNNER_WARMUP_BLIND_SECONDS);
+        }
+    }
+    
+    fprintf(stdout, "Isolated runner: processor %d%s, warmed up in %.2fs, ",
+            Runner->Processor, Runner->FIFO ? ", SCHED_FIFO" : "", GetWallClock() - StartTime);
+    if(Measurable)
+    {
+        fprintf(stdout, "core clock %.3fx %s%s\n", Runner->SettledRatio,
+                Runner->UsePerfCycles ? "TSC" : "nominal (APERF/MPERF)",
+                (Runner->SettledRatio > (1.0 + RUNNER_FREQUENCY_TOLERANCE)) ? " (turbo)" :
+                (Runner->SettledRatio < (1.0 - RUNNER_FREQUENCY_TOLERANCE)) ? " (throttled or power-saving)" : "");
+    }
+    else
+    {
+        fprintf(stdout, "core clock not measurable (no perf cycle counter or readable /dev/cpu/*/msr),\n"
+                "    so only context switches can reject a window\n");
+    }
+}
+
+static void
+BeginRunnerHash(runner *Runner, perf_counters *Perf)
+{
+    Runner->SampleCount = 0;
+    Runner->WindowCount = 0;
+    Runner->RejectedFrequency = 0;
+    Runner->RejectedSwitched = 0;
+    Runner->MinRatio = 0.0;
+    Runner->MaxRatio = 0.0;
+    Runner->WindowStart = ReadRunnerClocks(Runner, Perf);
+}
+
+static int
+RunnerWindowIsDone(runner *Runner)
+{
+    int Result = ((Runner->SampleCount == RUNNER_WINDOW_MAX_SAMPLES) ||
+                  ((double)(__rdtsc() - Runner->WindowStart.TSC) >= Runner->WindowTicks));
+    return(Result);
+}
+
+static void
+EndRunnerWindow(runner *Runner, perf_counters *Perf, input_size_tests *Tests)
+{
+    runner_clocks End = ReadRunnerClocks(Runner, Perf);
+    double Ratio = CoreClockRatio(Runner, Runner->WindowStart, End);
+    
+    int Rejected = 0;
+    if(End.Switches != Runner->WindowStart.Switches)
+    {
+        ++Runner->RejectedSwitched;
+        Rejected = 1;
+    }
+    else if((Ratio > 0.0) && (Runner->SettledRatio > 0.0) &&
+            (fabs(Ratio / Runner->SettledRatio - 1.0) > RUNNER_FREQUENCY_TOLERANCE))
+    {
+        ++Runner->RejectedFrequency;
+        Rejected = 1;
+    }
+    
+    if(!Rejected)
+    {
+        for(int SampleIndex = 0;
+            SampleIndex < Runner->SampleCount;
+            ++SampleIndex)
+        {
+            window_sample *Sample = Runner->Samples + SampleIndex;
+            RecordSample(Tests->Sizes + Sample->TestIndex, Sample->Clocks, Sample->PerfDeltas,
+                         Perf->EventCount, Tests->ClocksPerAvg);
+        }
+        
+        if(Ratio > 0.0)
+        {
+            if((Runner->MinRatio == 0.0) || (Runner->MinRatio > Ratio))
+            {
+                Runner->MinRatio = Ratio;
+            }
+            if(Runner->MaxRatio < Ratio)
+            {
+                Runner->MaxRatio = Ratio;
+            }
+        }
+    }
+    
+    ++Runner->WindowCount;
+    Runner->SampleCount = 0;
+    
+    // NOTE: Start the next window after the bookkeeping, so it doesn't count
+    Runner->WindowStart = ReadRunnerClocks(Runner, Perf);
+}
+
+static double
+RunnerRejectedFraction(runner *Runner)
+{
+    double Result = 0.0;
+    if(Runner->WindowCount)
+    {
+        Result = (double)(Runner->RejectedFrequency + Runner->RejectedSwitched) / (double)Runner->WindowCount;
+    }
+    return(Result);
+}
+
+static void
+PrintLeaderboard(input_size_tests *Tests, FILE *Stream)
+{
+    fprintf(Stream, "Leaderboard:\n");
+    
+    qsort(Tests->Results, Tests->ResultCount, sizeof(Tests->Results[0]), ResultCompare);
+    
+    int unsigned ResultIndex = 0;
+    while(ResultIndex < Tests->ResultCount)
+    {
+        test_results *BestResults = Tests->Results + ResultIndex;
+        
+        meow_u64 CurSize = BestResults->Size;
+        meow_u64 ExpClocks = BestResults->ExpClocks;
+        meow_u64 MaxClocks = ExpClocks; // + (ExpClocks/ 100);
+        
+        fprintf(Stream, "    ");
+        PrintSize(Stream, BestResults->Size, true);
+        if(BestResults->Unreliable)
+        {
+            // NOTE: Its numbers would only mislead
+            fprintf(Stream, ": UNRELIABLE - ");
+        }
+        else
+        {
+            fprintf(Stream, ": %10.0f (%6.03f bytes/cycle", 
+                    (double)BestResults->ExpClocks, (double)BestResults->ExpBPC);
+            if(BestResults->CoreBPC > 0.0)
+            {
+                fprintf(Stream, ", %6.03f bytes/core-cycle, %4.02f IPC", BestResults->CoreBPC, BestResults->IPC);
+            }
+            if(BestResults->ReadBPC > 0.0)
+            {
+                fprintf(Stream, ", %3.0f%% of %s roofline", RooflinePercent(BestResults), BestResults->MemoryLevel);
+            }
+            fprintf(Stream, ") [p50 %.0f, p90 %.0f, p99 %.0f, p99.9 %.0f, max %.0f]%s - ",
+                    (double)BestResults->P50Clocks, (double)BestResults->P90Clocks,
+                    (double)BestResults->P99Clocks, (double)BestResults->P999Clocks,
+                    (double)BestResults->MaxClocks, BestResults->UnstableTail ? " UNSTABLE TAIL" : "");
+        }
+        
+        int TieCount = 0;
+        while(ResultIndex < Tests->ResultCount)
+        {
+            test_results *Results = Tests->Results + ResultIndex;
+            if(Results->Size == CurSize)
+            {
+                if(Results->ExpClocks <= MaxClocks)
+                {
+                    named_hash_type Type = NamedHashTypes[Results->HashType];
+                    
+                    if(TieCount)
+                    {
+                        fprintf(Stream, ", ");
+                    }
+                    
+                    fprintf(Stream, "%s", Type.FullName);
+                    
+                    ++TieCount;
+                }
+                ++ResultIndex;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if(TieCount > 1)
+        {
+            fprintf(Stream, " (%d-way tie)", TieCount);
+        }
+        fprintf(Stream, "\n");
+    }
+}
+        
+void
+WriteCSV(input_size_tests *Tests, char *CSVFileName)
+{
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+
+    FILE *CSV = fopen(CSVFileName, "w");
+    if(CSV)
+    {
+        meow_u64 LastSize = 0;
+        fprintf(CSV, "Input");
+        for(int ResultIndex = 0;
+            ResultIndex < Tests->ResultCount;
+            ++ResultIndex)
+        {
+            test_results *Results = Tests->Results + ResultIndex;
+            if(Results->Size != LastSize)
+            {
+                LastSize = Results->Size;
+                fprintf(CSV, ",%.0f", (double)LastSize);
+            }
+        }
+        fprintf(CSV, "\n");
+        
+        LastSize = 0;
+        for(int TypeIndex = 0;
+            TypeIndex < TypeCount;
+            ++TypeIndex)
+        {
+            named_hash_type Type = NamedHashTypes[TypeIndex];
+            fprintf(CSV, "%s", Type.FullName);
+            for(int ResultIndex = 0;
+                ResultIndex < Tests->ResultCount;
+                ++ResultIndex)
+            {
+                test_results *Results = Tests->Results + ResultIndex;
+                if((Results->HashType == TypeIndex) &&
+                   (Results->Size != LastSize))
+                {
+                    LastSize = Results->Size;
+                    fprintf(CSV, ",%f", Results->ExpBPC);
+                }
+            }
+            fprintf(CSV, "\n");
+        }
+        fprintf(CSV, "\n");
+        fprintf(CSV, "\n");
+        for(int TypeIndex = 0;
+            TypeIndex < TypeCount;
+            ++TypeIndex)
+        {
+            named_hash_type Type = NamedHashTypes[TypeIndex];
+            fprintf(CSV, "%s", Type.FullName);
+            for(int ResultIndex = 0;
+                ResultIndex < Tests->ResultCount;
+                ++ResultIndex)
+            {
+                test_results *Results = Tests->Results + ResultIndex;
+                if((Results->HashType == TypeIndex) &&
+                   (Results->Size != LastSize))
+                {
+                    LastSize = Results->Size;
+                    fprintf(CSV, ",%f", Results->MinBPC);
+                }
+            }
+            fprintf(CSV, "\n");
+        }
+        fprintf(CSV, "\n");
+        
+        // NOTE: Latency percentiles, in clocks
+        char const *PercentileNames[] = {"p50", "p90", "p99", "p99.9", "max"};
+        for(int PercentileIndex = 0;
+            PercentileIndex < ArrayCount(PercentileNames);
+            ++PercentileIndex)
+        {
+            fprintf(CSV, "\n");
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(CSV, "%s %s clocks", Type.FullName, PercentileNames[PercentileIndex]);
+                LastSize = 0;
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->HashType == TypeIndex) &&
+                       (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        meow_u64 Percentiles[] =
+                        {
+                            Results->P50Clocks, Results->P90Clocks, Results->P99Clocks,
+                            Results->P999Clocks, Results->MaxClocks,
+                        };
+                        fprintf(CSV, ",%.0f", (double)Percentiles[PercentileIndex]);
+                    }
+                }
+                fprintf(CSV, "\n");
+            }
+        }
+        
+        // NOTE: Core-cycle throughput and IPC, when the hardware counters were available
+        for(int Section = 0;
+            (Section < 2) && Tests->ResultCount && (Tests->Results[0].CoreBPC > 0.0);
+            ++Section)
+        {
+            fprintf(CSV, "\n");
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(CSV, "%s %s", Type.FullName, Section ? "IPC" : "bytes/core-cycle");
+                LastSize = 0;
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->HashType == TypeIndex) &&
+                       (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        fprintf(CSV, ",%f", Section ? Results->IPC : Results->CoreBPC);
+                    }
+                }
+                fprintf(CSV, "\n");
+            }
+        }
+        
+        // NOTE: The memory roofline, and each hash as a percentage of it, when it was measured
+        int HaveRoofline = 0;
+        for(int ResultIndex = 0;
+            ResultIndex < Tests->ResultCount;
+            ++ResultIndex)
+        {
+            HaveRoofline |= (Tests->Results[ResultIndex].ReadBPC > 0.0);
+        }
+        if(HaveRoofline)
+        {
+            fprintf(CSV, "\n");
+            for(int Section = 0;
+                Section < 2;
+                ++Section)
+            {
+                fprintf(CSV, "%s", Section ? "memcpy bytes/cycle" : "Read roofline bytes/cycle");
+                LastSize = 0;
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if(!ResultIndex || (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        fprintf(CSV, ",%f", Section ? Results->CopyBPC : Results->ReadBPC);
+                    }
+                }
+                fprintf(CSV, "\n");
+            }
+            
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(CSV, "%s %% of roofline", Type.FullName);
+                LastSize = 0;
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->HashType == TypeIndex) &&
+                       (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        fprintf(CSV, ",%f", RooflinePercent(Results));
+                    }
+                }
+                fprintf(CSV, "\n");
+            }
+        }
+        fclose(CSV);
+    }
+    else
+    {
+        fprintf(stderr, "    (unable to open %s for writing)\n",
+                CSVFileName);
+    }
+}
+
+void
+WriteHTML(input_size_tests *Tests, char *HTMLFileName)
+{
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+
+    // NOTE(casey): Dear C++ committee: how about you define the string as writable IF I TOLD YOU IT WAS WRITABLE
+    // instead of making it constant?  Oh, that's right - because you don't care what the programmer wants,
+    // you're always right about how code should work.  My bad.  So I get to type the word "const" three times
+    // for no reason whatsoever.  Nice work!  You really saved the day.
+    char const *CrappyColorTable[] =
+    {
+        "#477ea0",
+        "#84ab3c",
+        "#50c76d",
+        "#d8823a",
+        "#da5bd5",
+        "#d63636",
+        "#897cd0",
+        "#949494",
+        "#af5f9d",
+        "#2ac4c5",
+        "#3b17c1",
+        "#ff0000", // TODO(casey): Real color here
+    };
+    
+    FILE *Out = fopen(HTMLFileName, "w");
+    if(Out)
+    {
+        fprintf(Out, "<!DOCTYPE html><html lang='en' itemscope itemtype='https://schema.org/Article'><head>\n");
+        fprintf(Out, "</head>\n");
+        fprintf(Out, "<body>\n");
+        
+        double MaxSizeCoord = log(1.0f + MAX_SIZE_TO_TEST);
+        double MaxSpeedCoord = 16.0; // TODO(casey): Should probably scan for this, eventually
+        
+        {
+            meow_u64 LastSize = -1;
+            fprintf(Out, "<svg id='Graph' style='width:100%%;height:50vh;user-select:none;' viewBox='0 0 %f %f'>\n", MaxSizeCoord, MaxSpeedCoord);
+
+            fprintf(Out, "<g id='ViewXForm'>\n");
+            double XLine = 1.0f;
+            for(int XIndex = 0;
+                ;
+                ++XIndex)
+            {
+                if(XIndex)
+                {
+                    double XCoord = log(1.0f + XLine);
+                    if(XCoord < MaxSizeCoord)
+                    {
+                        char const *Color = "#eeeeee";
+                        if((XIndex % 4) == 0)
+                        {
+                            Color = "#888888";
+                            
+                            fprintf(Out, "<text x='%f' y='%f' fill='%s' font-size='0.5' alignment-baseline='baseline'>", XCoord, MaxSpeedCoord, Color);
+                            PrintSize(Out, XLine, false, false);
+                            fprintf(Out, "</text>\n");
+                        }
+                        
+                        fprintf(Out, "<line x1='%f' y1='0' x2='%f' y2='%f' vector-effect='non-scaling-stroke' stroke='%s' stroke-width='1.0' />\n",
+                                XCoord, XCoord, MaxSpeedCoord, Color);
+                        
+                        XLine *= 2.0f;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+            }
+            
+            double YLine = 0.0f;
+            for(;;)
+            {
+                double YCoord = (MaxSpeedCoord - YLine);
+                if(YLine < MaxSpeedCoord)
+                {
+                    char const *Color = "#eeeeee";
+                    if((YLine != 0.0) && (fmod(YLine, 4.0) == 0.0))
+                    {
+                        Color = "#888888";
+                        
+                        char Label[32];
+                        sprintf(Label, "%.0fb/c", YLine);
+                        fprintf(Out, "<text x='0' y='%f' fill='#888888' font-size='0.5' alignment-baseline='hanging'>%s</text>\n", YCoord, Label);
+                    }
+                    
+                    fprintf(Out, "<line x1='0' y1='%f' x2='%f' y2='%f' vector-effect='non-scaling-stroke' stroke='%s' stroke-width='1.0' />\n",
+                            YCoord, MaxSizeCoord, YCoord, Color);
+                    
+                    YLine += 1.0f;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            fprintf(Out, "<line id='size_line' x1='0' y1='0' x2='0' y2='%f' vector-effect='non-scaling-stroke' stroke='#ffaaaa' stroke-width='3.0' />\n", MaxSpeedCoord);
+            fprintf(Out, "<line id='speed_line' x1='0' y1='0' x2='%f' y2='0' vector-effect='non-scaling-stroke' stroke='#ffaaaa' stroke-width='3.0' />\n", MaxSizeCoord);
+            
+            // NOTE: The read roofline, dashed, clipped to the top of the graph
+            {
+                fprintf(Out, "<path class='roofline' vector-effect='non-scaling-stroke' d='");
+                char Char = 'M';
+                meow_u64 RoofSize = -1;
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->ReadBPC > 0.0) && (Results->Size != RoofSize))
+                    {
+                        RoofSize = Results->Size;
+                        
+                        double SizeCoord = log(1.0f + Results->Size);
+                        double SpeedCoord = (MaxSpeedCoord - Results->ReadBPC);
+                        fprintf(Out, "%c %f %f ", Char, SizeCoord, (SpeedCoord > 0.0) ? SpeedCoord : 0.0);
+                        Char = 'L';
+                    }
+                }
+                fprintf(Out, "' stroke-width='1' stroke-dasharray='4 4' fill='none' stroke='#444444' />\n");
+            }
+
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                
+                fprintf(Out, "<path class='%s_exp gel' vector-effect='non-scaling-stroke' d='", Type.ShortName);
+                char Char = 'M';
+                char const *Color = CrappyColorTable[TypeIndex%ArrayCount(CrappyColorTable)];
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->HashType == TypeIndex) &&
+                       (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        
+                        double SizeCoord = log(1.0f + Results->Size);
+                        double SpeedCoord = (MaxSpeedCoord - Results->ExpBPC);
+                        fprintf(Out, "%c %f %f ", Char, SizeCoord, SpeedCoord);
+                        Char = 'L';
+                    }
+                }
+                fprintf(Out, "' stroke-width='1' fill='none' stroke='%s' />\n", Color);
+                
+                fprintf(Out, "<path class='%s_min gel' vector-effect='non-scaling-stroke' d='", Type.ShortName);
+                Char = 'M';
+                for(int ResultIndex = 0;
+                    ResultIndex < Tests->ResultCount;
+                    ++ResultIndex)
+                {
+                    test_results *Results = Tests->Results + ResultIndex;
+                    if((Results->HashType == TypeIndex) &&
+                       (Results->Size != LastSize))
+                    {
+                        LastSize = Results->Size;
+                        
+                        double SizeCoord = log(1.0f + Results->Size);
+                        double SpeedCoord = (MaxSpeedCoord - Results->MinBPC);
+                        fprintf(Out, "%c %f %f ", Char, SizeCoord, SpeedCoord);
+                        Char = 'L';
+                    }
+                }
+                fprintf(Out, "' stroke-width='1' fill='none' stroke='%s' />\n", Color);
+            }
+            fprintf(Out, "</g>\n");
+            
+            fprintf(Out, "</svg>\n");
+        }
+        
+        {
+            fprintf(Out, "<div style='font-family:sans-serif;overflow:auto;height:45vh;'>\n");
+            fprintf(Out, "<table style='border-spacing:0;'>\n");
+            
+            // NOTE(casey): Hash names
+            fprintf(Out, "<tr style='text-align:center'>");
+            fprintf(Out, "<td onclick='PickHash(0, 0, 0, %f)' style='padding:.5rem;'></td>", MaxSpeedCoord);
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                char const *Color = CrappyColorTable[TypeIndex%ArrayCount(CrappyColorTable)];
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(Out, "<td colspan=2 style='padding:.5rem;color:%s;'>%s</td>", Color, Type.FullName);
+            }
+            fprintf(Out, "</tr>\n");
+
+            fprintf(Out, "<tr style='background:#888888;color:#ffffff;text-align:center;'>");
+            fprintf(Out, "<td onclick='PickHash(0, 0, 0, %f)'></td>", MaxSpeedCoord);
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
                 ++TypeIndex)
             {
-                named_hash_type Type = NamedHashTypes[TypeIndex];
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(Out, "<td onclick='PickHash(0, \"%s_min\", 0, %f)' style='padding:.5rem'>Fastest</td><td onclick='PickHash(0, \"%s_exp\", 0, %f)' style='padding:.5rem'>Expected</td>", Type.ShortName, MaxSpeedCoord, Type.ShortName, MaxSpeedCoord);
+            }
+            fprintf(Out, "</tr>\n");
+
+            // NOTE(casey): Hash results
+            int RowIndex = 0;
+            int BaseResultIndex = 0;
+            while(BaseResultIndex < Tests->ResultCount)
+            {
+                test_results *BaseResult = Tests->Results + BaseResultIndex;
+                meow_u64 SizeMatch = BaseResult->Size;
+                
+                fprintf(Out, "<tr class='row%.0f' style='background:%s;text-align:center;'>", (double)SizeMatch, (RowIndex % 2) ? "#f7f7f7" : "#e6e6e6");
+                fprintf(Out, "<td onclick='PickHash(\"row%.0f\", 0, %f, %f)' style='padding:.5rem;text-align:right;'>", (double)SizeMatch, log(1.0 + SizeMatch), MaxSpeedCoord);
+                PrintSize(Out, SizeMatch, false);
+                fprintf(Out, "</td>");
+                for(int TypeIndex = 0;
+                    TypeIndex < TypeCount;
+                    ++TypeIndex)
+                {
+                    named_hash_type Type = NamedHashTypes[TypeIndex];
+                    
+                    double Min = 0;
+                    double Exp = 0;
+                    for(int ResultIndex = BaseResultIndex;
+                       ResultIndex < Tests->ResultCount;
+                       ++ResultIndex)
+                    {
+                        test_results *Results = Tests->Results + ResultIndex;
+                        
+                        if(Results->Size != SizeMatch)
+                        {
+                            break;
+                        }
+                        
+                        if(Results->HashType == TypeIndex)
+                        {
+                            Min = Results->MinBPC;
+                            Exp = Results->ExpBPC;
+                        }
+                    }
+                    
+                    fprintf(Out, "<td onclick='PickHash(\"row%.0f\", \"%s_min\", %f, %f)' class='%s_min' style='padding:.5rem;'>%f</td><td onclick='PickHash(\"row%.0f\", \"%s_exp\", %f, %f)' class='%s_exp' style='padding:.5rem;'>%f</td>",
+                            (double)SizeMatch, Type.ShortName, log(1.0 + SizeMatch), (MaxSpeedCoord - Min),
+                            Type.ShortName, Min,
+                            (double)SizeMatch, Type.ShortName, log(1.0 + SizeMatch), (MaxSpeedCoord - Exp),
+                            Type.ShortName, Exp);
+                }
+
+                while(BaseResultIndex < Tests->ResultCount)
+                {
+                    test_results *Results = Tests->Results + BaseResultIndex;
+                    if(Results->Size != SizeMatch)
+                    {
+                        break;
+                    }
+                    
+                    ++BaseResultIndex;
+                }
+
+                fprintf(Out, "</tr>\n");
+                
+                ++RowIndex;
+            }
+            
+            fprintf(Out, "</table>\n");
+            
+            // NOTE: Latency percentiles, with unstable tails highlighted
+            fprintf(Out, "<p style='padding:.5rem;'>Latency in clocks: p50 / p90 / p99 / p99.9 / max (red: p99 over %.1fx p50)</p>\n", UNSTABLE_TAIL_RATIO);
+            fprintf(Out, "<table style='border-spacing:0;'>\n");
+            fprintf(Out, "<tr style='background:#888888;color:#ffffff;text-align:center;'><td></td>");
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                named_hash_type Type = NamedHashTypes[TypeIndex];
+                fprintf(Out, "<td style='padding:.5rem'>%s</td>", Type.FullName);
+            }
+            fprintf(Out, "</tr>\n");
+            
+            RowIndex = 0;
+            BaseResultIndex = 0;
+            while(BaseResultIndex < Tests->ResultCount)
+            {
+                meow_u64 SizeMatch = Tests->Results[BaseResultIndex].Size;
+                
+                fprintf(Out, "<tr style='background:%s;text-align:center;'><td style='padding:.5rem;text-align:right;'>", (RowIndex % 2) ? "#f7f7f7" : "#e6e6e6");
+                PrintSize(Out, SizeMatch, false);
+                fprintf(Out, "</td>");
+                for(int TypeIndex = 0;
+                    TypeIndex < TypeCount;
+                    ++TypeIndex)
+                {
+                    test_results *Match = 0;
+                    for(int ResultIndex = BaseResultIndex;
+                        (ResultIndex < Tests->ResultCount) && (Tests->Results[ResultIndex].Size == SizeMatch);
+                        ++ResultIndex)
+                    {
+                        if(Tests->Results[ResultIndex].HashType == TypeIndex)
+                        {
+                            Match = Tests->Results + ResultIndex;
+                        }
+                    }
+                    
+                    if(Match)
+                    {
+                        fprintf(Out, "<td style='padding:.5rem;%s'>%.0f / %.0f / %.0f / %.0f / %.0f</td>",
+                                Match->UnstableTail ? "color:#d63636;" : "",
+                                (double)Match->P50Clocks, (double)Match->P90Clocks, (double)Match->P99Clocks,
+                                (double)Match->P999Clocks, (double)Match->MaxClocks);
+                    }
+                    else
+                    {
+                        fprintf(Out, "<td></td>");
+                    }
+                }
+                fprintf(Out, "</tr>\n");
+                
+                while((BaseResultIndex < Tests->ResultCount) &&
+                      (Tests->Results[BaseResultIndex].Size == SizeMatch))
+                {
+                    ++BaseResultIndex;
+                }
+                ++RowIndex;
+            }
+            fprintf(Out, "</table>\n");
+            
+            // NOTE: Expected throughput against the memory roofline (dashed on the graph)
+            if(Tests->ResultCount && (Tests->Results[Tests->ResultCount - 1].ReadBPC > 0.0))
+            {
+                fprintf(Out, "<p style='padding:.5rem;'>Expected throughput as a percentage of the read roofline (a plain read loop over the same input, in the same cache state; memcpy for comparison)</p>\n");
+                fprintf(Out, "<table style='border-spacing:0;'>\n");
+                fprintf(Out, "<tr style='background:#888888;color:#ffffff;text-align:center;'><td></td><td style='padding:.5rem'>Level</td><td style='padding:.5rem'>Read b/c</td><td style='padding:.5rem'>memcpy b/c</td>");
+                for(int TypeIndex = 0;
+                    TypeIndex < TypeCount;
+                    ++TypeIndex)
+                {
+                    named_hash_type Type = NamedHashTypes[TypeIndex];
+                    fprintf(Out, "<td style='padding:.5rem'>%s</td>", Type.FullName);
+                }
+                fprintf(Out, "</tr>\n");
+                
+                RowIndex = 0;
+                BaseResultIndex = 0;
+                while(BaseResultIndex < Tests->ResultCount)
+                {
+                    test_results *BaseResult = Tests->Results + BaseResultIndex;
+                    meow_u64 SizeMatch = BaseResult->Size;
+                    
+                    fprintf(Out, "<tr style='background:%s;text-align:center;'><td style='padding:.5rem;text-align:right;'>", (RowIndex % 2) ? "#f7f7f7" : "#e6e6e6");
+                    PrintSize(Out, SizeMatch, false);
+                    fprintf(Out, "</td><td>%s</td><td>%.3f</td><td>%.3f</td>",
+                            BaseResult->MemoryLevel ? BaseResult->MemoryLevel : "", BaseResult->ReadBPC, BaseResult->CopyBPC);
+                    for(int TypeIndex = 0;
+                        TypeIndex < TypeCount;
+                        ++TypeIndex)
+                    {
+                        test_results *Match = 0;
+                        for(int ResultIndex = BaseResultIndex;
+                            (ResultIndex < Tests->ResultCount) && (Tests->Results[ResultIndex].Size == SizeMatch);
+                            ++ResultIndex)
+                        {
+                            if(Tests->Results[ResultIndex].HashType == TypeIndex)
+                            {
+                                Match = Tests->Results + ResultIndex;
+                            }
+                        }
+                        
+                        if(Match && (Match->ReadBPC > 0.0))
+                        {
+                            fprintf(Out, "<td style='padding:.5rem;'>%.0f%%</td>", RooflinePercent(Match));
+                        }
+                        else
+                        {
+                            fprintf(Out, "<td></td>");
+                        }
+                    }
+                    fprintf(Out, "</tr>\n");
+                    
+                    while((BaseResultIndex < Tests->ResultCount) &&
+                          (Tests->Results[BaseResultIndex].Size == SizeMatch))
+                    {
+                        ++BaseResultIndex;
+                    }
+                    ++RowIndex;
+                }
+                fprintf(Out, "</table>\n");
+            }
+
+            // onwheel='GraphWheel()' ondrag='GraphDrag()'
+            
+            fprintf(Out, "<script>\n");
+            fprintf(Out, "var Scale = 1.0;\n");
+            fprintf(Out, "var TranslateX = 0.0;\n");
+            fprintf(Out, "var TranslateY = 0.0;\n");
+            fprintf(Out, "var DragAnchorX = 0.0;\n");
+            fprintf(Out, "var DragAnchorY = 0.0;\n");
+            fprintf(Out, "var HighCol = 0;\n");
+            fprintf(Out, "var HighRow = 0;\n");
+            fprintf(Out, "function PickHash(RowID, ColID, x, y)\n");
+            fprintf(Out, "{\n");
+            fprintf(Out, "    if(HighCol) {HighCol.remove();HighCol = 0;}\n");
+            fprintf(Out, "    if(HighRow) {HighRow.remove();HighRow = 0;}\n");
+            fprintf(Out, "    if(ColID)\n");
+            fprintf(Out, "    {\n");
+            fprintf(Out, "        HighCol = document.createElement('style');\n");
+            fprintf(Out, "        document.head.appendChild(HighCol);\n");
+            fprintf(Out, "        HighCol.innerHTML = '.gel {opacity:0.25;} .' + ColID + '{color:#aa0000;stroke-width:3;opacity:1.0;}';\n");
+            fprintf(Out, "    }\n");
+            fprintf(Out, "    if(RowID)\n");
+            fprintf(Out, "    {\n");
+            fprintf(Out, "        HighRow = document.createElement('style');\n");
+            fprintf(Out, "        document.head.appendChild(HighRow);\n");
+            fprintf(Out, "        HighRow.innerHTML = '.' + RowID + '{color:#aa0000;}';\n");
+            fprintf(Out, "    }\n");
+            fprintf(Out, "    SpeedLine = document.getElementById('speed_line');\n");
+            fprintf(Out, "    SpeedLine.setAttribute('y1', '' + y + '');\n");
+            fprintf(Out, "    SpeedLine.setAttribute('y2', '' + y + '');\n");
+            fprintf(Out, "    SizeLine = document.getElementById('size_line');\n");
+            fprintf(Out, "    SizeLine.setAttribute('x1', '' + x + '');\n");
+            fprintf(Out, "    SizeLine.setAttribute('x2', '' + x + '');\n");
+            fprintf(Out, "}\n");
+            fprintf(Out, "function GraphWheel(e)\n");
+            fprintf(Out, "{\n");
+            fprintf(Out, "    Scale *= (1.0 - 0.001*e.deltaY);\n");
+            fprintf(Out, "    Graph = document.getElementById('ViewXForm');\n");
+            fprintf(Out, "    Graph.setAttributeNS(null, 'transform', 'scale(' + Scale + ') translate(' + TranslateX + ', ' + TranslateY + ')');\n");
+            fprintf(Out, "}\n");
+            fprintf(Out, "function GraphDrag(e)\n");
+            fprintf(Out, "{\n");
+            fprintf(Out, "    var dX = e.pageX - DragAnchorX;\n");
+            fprintf(Out, "    var dY = e.pageY - DragAnchorY;\n");
+            fprintf(Out, "    DragAnchorX = e.pageX;\n");
+            fprintf(Out, "    DragAnchorY = e.pageY;\n");
+            fprintf(Out, "    if(e.buttons == 1)\n");
+            fprintf(Out, "    {\n");
+            fprintf(Out, "        TranslateX += Scale*0.01*dX;\n");
+            fprintf(Out, "        TranslateY += Scale*0.01*dY;\n");
+            fprintf(Out, "        Graph = document.getElementById('ViewXForm');\n");
+            fprintf(Out, "        Graph.setAttributeNS(null, 'transform', 'scale(' + Scale + ') translate(' + TranslateX + ', ' + TranslateY + ')');\n");
+            fprintf(Out, "    }\n");
+            fprintf(Out, "}\n");
+            fprintf(Out, "function GraphDown(e)\n");
+            fprintf(Out, "{\n");
+            fprintf(Out, "    DragAnchorX = e.pageX;\n");
+            fprintf(Out, "    DragAnchorY = e.pageY;\n");
+            fprintf(Out, "}\n");
+            fprintf(Out, "document.getElementById('Graph').addEventListener('wheel', GraphWheel);\n");
+            fprintf(Out, "document.getElementById('Graph').addEventListener('mousedown', GraphDown);\n");
+            fprintf(Out, "document.getElementById('Graph').addEventListener('mousemove', GraphDrag);\n");
+            fprintf(Out, "</script>\n");
+        }
+        
+#if 0
+        meow_u64 LastSize = 0;
+        fprintf(Out, "Input");
+        for(int ResultIndex = 0;
+            ResultIndex < Tests->ResultCount;
+            ++ResultIndex)
+        {
+            test_results *Results = Tests->Results + ResultIndex;
+            if(Results->Size != LastSize)
+            {
+                LastSize = Results->Size;
+                fprintf(Out, ",%.0f", (double)LastSize);
+            }
+        }
+        fprintf(Out, "\n");
+        
+        LastSize = 0;
+        for(int TypeIndex = 0;
+            TypeIndex < TypeCount;
+            ++TypeIndex)
+        {
+            named_hash_type Type = NamedHashTypes[TypeIndex];
+            fprintf(Out, "%s", Type.FullName);
+            for(int ResultIndex = 0;
+                ResultIndex < Tests->ResultCount;
+                ++ResultIndex)
+            {
+                test_results *Results = Tests->Results + ResultIndex;
+                if((Results->HashType == TypeIndex) &&
+                   (Results->Size != LastSize))
+                {
+                    LastSize = Results->Size;
+                    fprintf(Out, ",%f", Results->ExpBPC);
+                }
+            }
+            fprintf(Out, "\n");
+        }
+        fprintf(Out, "\n");
+        fprintf(Out, "\n");
+        for(int TypeIndex = 0;
+            TypeIndex < TypeCount;
+            ++TypeIndex)
+        {
+            named_hash_type Type = NamedHashTypes[TypeIndex];
+            fprintf(Out, "%s", Type.FullName);
+            for(int ResultIndex = 0;
+                ResultIndex < Tests->ResultCount;
+                ++ResultIndex)
+            {
+                test_results *Results = Tests->Results + ResultIndex;
+                if((Results->HashType == TypeIndex) &&
+                   (Results->Size != LastSize))
+                {
+                    LastSize = Results->Size;
+                    fprintf(Out, ",%f", Results->MinBPC);
+                }
+            }
+            fprintf(Out, "\n");
+        }
+#endif
+
+        fprintf(Out, "</body></html>\n");
+        
+        fclose(Out);
+    }
+    else
+    {
+        fprintf(stderr, "    (unable to open %s for writing)\n",
+                HTMLFileName);
+    }
+}
+
+//
+// NOTE: Results files for comparing builds
+//
+// The CSV and HTML are for looking at, but they hold one summary number per size
+// and nothing about the machine they came from, so two runs can't be compared
+// with any confidence.  The JSON results hold a fingerprint of the host and build,
+// and for every hash and size the complete latency histogram, which is every
+// per-call sample to within the histogram's resolution (about 3%).  -compare
+// reads two of those files back and runs a Mann-Whitney U test on each pair of
+// histograms, since a handful of interrupts or a slightly different median
+// shouldn't be what decides whether a change is a regression.
+//
+// The input sizes come from a fixed random series, so two runs of the same
+// benchmark with the same options test the same sizes.
+//
+
+#define JSON_RESULTS_FORMAT "meow_bench results 1"
+
+// NOTE: A difference has to be significant at this level (after a Bonferroni correction
+// for the number of sizes compared)...
+#define COMPARE_ALPHA 0.01
+// NOTE: ...and the probability that a call in one run is slower than a call in the
+// other has to be at least this far from 0.5 (0.56 is the conventional "small" effect)
+#define COMPARE_MIN_EFFECT 0.06
+
+struct host_fingerprint
+{
+    char CPU[64];
+    char Flags[128];
+    char Kernel[128];
+    char Compiler[128];
+};
+
+static void
+HostCPUID(int unsigned Leaf, int unsigned SubLeaf, int unsigned *Regs)
+{
+    Regs[0] = Regs[1] = Regs[2] = Regs[3] = 0;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    __cpuidex((int *)Regs, Leaf, SubLeaf);
+#elif defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("cpuid" : "=a"(Regs[0]), "=b"(Regs[1]), "=c"(Regs[2]), "=d"(Regs[3]) : "a"(Leaf), "c"(SubLeaf));
+#endif
+}
+
+static host_fingerprint
+GetHostFingerprint(void)
+{
+    host_fingerprint Result = {};
+    
+    int unsigned Regs[4];
+    HostCPUID(0x80000000, 0, Regs);
+    if(Regs[0] >= 0x80000004)
+    {
+        for(int unsigned Leaf = 0;
+            Leaf < 3;
+            ++Leaf)
+        {
+            HostCPUID(0x80000002 + Leaf, 0, (int unsigned *)(Result.CPU + 16*Leaf));
+        }
+    }
+    else
+    {
+        strcpy(Result.CPU, "unknown");
+    }
+    
+    HostCPUID(0, 0, Regs);
+    int unsigned MaxLeaf = Regs[0];
+    int unsigned Leaf1ECX = 0, Leaf7EBX = 0, Leaf7ECX = 0;
+    if(MaxLeaf >= 1)
+    {
+        HostCPUID(1, 0, Regs);
+        Leaf1ECX = Regs[2];
+    }
+    if(MaxLeaf >= 7)
+    {
+        HostCPUID(7, 0, Regs);
+        Leaf7EBX = Regs[1];
+        Leaf7ECX = Regs[2];
+    }
+    
+    struct
+    {
+        char const *Name;
+        int unsigned Bits;
+        int unsigned Bit;
+    } Flags[] =
+    {
+        {"pclmul", Leaf1ECX, 1},
+        {"sse4.2", Leaf1ECX, 20},
+        {"aes", Leaf1ECX, 25},
+        {"avx", Leaf1ECX, 28},
+        {"avx2", Leaf7EBX, 5},
+        {"avx512f", Leaf7EBX, 16},
+        {"sha", Leaf7EBX, 29},
+        {"vaes", Leaf7ECX, 9},
+        {"vpclmulqdq", Leaf7ECX, 10},
+    };
+    for(int FlagIndex = 0;
+        FlagIndex < ArrayCount(Flags);
+        ++FlagIndex)
+    {
+        if(Flags[FlagIndex].Bits & (1u << Flags[FlagIndex].Bit))
+        {
+            if(Result.Flags[0])
+            {
+                strcat(Result.Flags, " ");
+            }
+            strcat(Result.Flags, Flags[FlagIndex].Name);
+        }
+    }
+    
+    // NOTE: The brand string is padded with leading spaces on some CPUs
+    char *CPUName = Result.CPU;
+    while(*CPUName == ' ')
+    {
+        ++CPUName;
+    }
+    memmove(Result.CPU, CPUName, strlen(CPUName) + 1);
+    
+#if _WIN32
+    strcpy(Result.Kernel, "Windows");
+#else
+    struct utsname Name;
+    if(uname(&Name) == 0)
+    {
+        snprintf(Result.Kernel, sizeof(Result.Kernel), "%s %s %s", Name.sysname, Name.release, Name.machine);
+    }
+#endif
+    
+#if defined(__clang__)
+    snprintf(Result.Compiler, sizeof(Result.Compiler), "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(Result.Compiler, sizeof(Result.Compiler), "gcc %s", __VERSION__);
+#elif defined(_MSC_VER)
+    snprintf(Result.Compiler, sizeof(Result.Compiler), "msvc %d", _MSC_FULL_VER);
+#else
+    strcpy(Result.Compiler, "unknown");
+#endif
+    
+    return(Result);
+}
+
+static void
+WriteJSONString(FILE *Out, char const *String)
+{
+    fprintf(Out, "\"");
+    for(char const *At = String;
+        *At;
+        ++At)
+    {
+        if((*At == '"') || (*At == '\\'))
+        {
+            fprintf(Out, "\\%c", *At);
+        }
+        else if((unsigned char)*At < ' ')
+        {
+            fprintf(Out, "\\u%04x", (int unsigned)(unsigned char)*At);
+        }
+        else
+        {
+            fputc(*At, Out);
+        }
+    }
+    fprintf(Out, "\"");
+}
+
+static void
+WriteJSON(input_size_tests *Tests, host_fingerprint *Host, char const *CacheModeName, char *JSONFileName)
+{
+    FILE *Out = fopen(JSONFileName, "w");
+    if(Out)
+    {
+        fprintf(Out, "{\n\"format\": \"%s\",\n", JSON_RESULTS_FORMAT);
+        fprintf(Out, "\"version\": \"%s\",\n", MEOW_HASH_VERSION_NAME);
+        fprintf(Out, "\"host\": {\"cpu\": ");
+        WriteJSONString(Out, Host->CPU);
+        fprintf(Out, ", \"flags\": ");
+        WriteJSONString(Out, Host->Flags);
+        fprintf(Out, ", \"kernel\": ");
+        WriteJSONString(Out, Host->Kernel);
+        fprintf(Out, ", \"compiler\": ");
+        WriteJSONString(Out, Host->Compiler);
+        int Quick = 0;
+#if MEOW_TEST_BENCH_QUICK
+        Quick = 1;
+#endif
+        fprintf(Out, ", \"cache_mode\": \"%s\", \"quick\": %d},\n", CacheModeName, Quick);
+        
+        fprintf(Out, "\"results\": [");
+        for(int ResultIndex = 0;
+            ResultIndex < Tests->ResultCount;
+            ++ResultIndex)
+        {
+            test_results *Results = Tests->Results + ResultIndex;
+            named_hash_type Type = NamedHashTypes[Results->HashType];
+            
+            fprintf(Out, "%s\n{\"hash\": \"%s\", \"size_class\": \"%s\", \"size\": %.0f, ",
+                    ResultIndex ? "," : "", Type.ShortName, Results->SizeClass, (double)Results->Size);
+            fprintf(Out, "\"min\": %.0f, \"exp\": %.0f, \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f, \"samples\": %.0f, \"unreliable\": %d,\n",
+                    (double)Results->MinClocks, (double)Results->ExpClocks, (double)Results->P50Clocks,
+                    (double)Results->P99Clocks, (double)Results->MaxClocks, (double)Results->SampleCount,
+                    Results->Unreliable);
+            
+            // NOTE: [clocks, count] for every bucket that has any samples, in increasing order
+            fprintf(Out, " \"histogram\": [");
+            int Written = 0;
+            for(int BucketIndex = 0;
+                BucketIndex < HISTOGRAM_BUCKET_COUNT;
+                ++BucketIndex)
+            {
+                if(Results->Histogram[BucketIndex])
+                {
+                    fprintf(Out, "%s[%.0f,%u]", Written++ ? "," : "",
+                            (double)HistogramBucketValue(BucketIndex), Results->Histogram[BucketIndex]);
+                }
+            }
+            fprintf(Out, "]}");
+        }
+        fprintf(Out, "\n]\n}\n");
+        
+        fclose(Out);
+    }
+    else
+    {
+        fprintf(stderr, "    (unable to open %s for writing)\n", JSONFileName);
+    }
+}
+
+//
+// NOTE: Just enough of a JSON reader for the files WriteJSON writes
+//
+
+enum json_type
+{
+    Json_Null,
+    Json_Bool,
+    Json_Number,
+    Json_String,
+    Json_Array,
+    Json_Object,
+};
+
+struct json_value
+{
+    json_type Type;
+    char *Key;
+    char *String;
+    double Number;
+    json_value *FirstChild;
+    json_value *Next;
+};
+
+struct json_parser
+{
+    char *At;
+    int Error;
+};
+
+static void
+SkipJSONSpace(json_parser *Parser)
+{
+    while((*Parser->At == ' ') || (*Parser->At == '\t') || (*Parser->At == '\r') || (*Parser->At == '\n'))
+    {
+        ++Parser->At;
+    }
+}
+
+static char *
+ParseJSONString(json_parser *Parser)
+{
+    // NOTE: Strings are unescaped in place, which never makes them longer
+    char *Result = 0;
+    if(*Parser->At == '"')
+    {
+        Result = ++Parser->At;
+        char *Dest = Result;
+        while(*Parser->At && (*Parser->At != '"'))
+        {
+            char C = *Parser->At++;
+            if((C == '\\') && *Parser->At)
+            {
+                C = *Parser->At++;
+                if(C == 'n') C = '\n';
+                else if(C == 't') C = '\t';
+                else if(C == 'u')
+                {
+                    C = (char)strtol(Parser->At, 0, 16);
+                    for(int Digit = 0; (Digit < 4) && *Parser->At; ++Digit) ++Parser->At;
+                }
+            }
+            *Dest++ = C;
+        }
+        
+        if(*Parser->At == '"')
+        {
+            ++Parser->At;
+            *Dest = 0;
+        }
+        else
+        {
+            Parser->Error = 1;
+        }
+    }
+    else
+    {
+        Parser->Error = 1;
+    }
+    
+    return(Result);
+}
+
+static json_value *
+ParseJSONValue(json_parser *Parser)
+{
+    json_value *Result = (json_value *)calloc(1, sizeof(json_value));
+    
+    SkipJSONSpace(Parser);
+    char C = *Parser->At;
+    if((C == '{') || (C == '['))
+    {
+        Result->Type = (C == '{') ? Json_Object : Json_Array;
+        char Close = (C == '{') ? '}' : ']';
+        ++Parser->At;
+        
+        json_value **Link = &Result->FirstChild;
+        SkipJSONSpace(Parser);
+        while(!Parser->Error && (*Parser->At != Close))
+        {
+            char *Key = 0;
+            if(Result->Type == Json_Object)
+            {
+                Key = ParseJSONString(Parser);
+                SkipJSONSpace(Parser);
+                if(*Parser->At == ':')
+                {
+                    ++Parser->At;
+                }
+                else
+                {
+                    Parser->Error = 1;
+                }
+            }
+            
+            json_value *Child = ParseJSONValue(Parser);
+            Child->Key = Key;
+            *Link = Child;
+            Link = &Child->Next;
+            
+            SkipJSONSpace(Parser);
+            if(*Parser->At == ',')
+            {
+                ++Parser->At;
+                SkipJSONSpace(Parser);
+            }
+            else if(*Parser->At != Close)
+            {
+                Parser->Error = 1;
+            }
+        }
+        
+        if(*Parser->At == Close)
+        {
+            ++Parser->At;
+        }
+    }
+    else if(C == '"')
+    {
+        Result->Type = Json_String;
+        Result->String = ParseJSONString(Parser);
+    }
+    else if((C == '-') || ((C >= '0') && (C <= '9')))
+    {
+        Result->Type = Json_Number;
+        Result->Number = strtod(Parser->At, &Parser->At);
+    }
+    else if(strncmp(Parser->At, "true", 4) == 0)
+    {
+        Result->Type = Json_Bool;
+        Result->Number = 1;
+        Parser->At += 4;
+    }
+    else if(strncmp(Parser->At, "false", 5) == 0)
+    {
+        Result->Type = Json_Bool;
+        Parser->At += 5;
+    }
+    else if(strncmp(Parser->At, "null", 4) == 0)
+    {
+        Parser->At += 4;
+    }
+    else
+    {
+        Parser->Error = 1;
+    }
+    
+    return(Result);
+}
+
+static void
+FreeJSON(json_value *Value)
+{
+    while(Value)
+    {
+        json_value *Next = Value->Next;
+        FreeJSON(Value->FirstChild);
+        free(Value);
+        Value = Next;
+    }
+}
+
+static json_value *
+JSONMember(json_value *Object, char const *Key)
+{
+    json_value *Result = 0;
+    if(Object)
+    {
+        for(json_value *Child = Object->FirstChild;
+            Child;
+            Child = Child->Next)
+        {
+            if(Child->Key && (strcmp(Child->Key, Key) == 0))
+            {
+                Result = Child;
+                break;
+            }
+        }
+    }
+    
+    return(Result);
+}
+
+static char const *
+JSONString(json_value *Object, char const *Key)
+{
+    json_value *Member = JSONMember(Object, Key);
+    char const *Result = (Member && (Member->Type == Json_String)) ? Member->String : "";
+    return(Result);
+}
+
+static double
+JSONNumber(json_value *Object, char const *Key)
+{
+    json_value *Member = JSONMember(Object, Key);
+    double Result = (Member && (Member->Type == Json_Number)) ? Member->Number : 0.0;
+    return(Result);
+}
+
+struct results_file
+{
+    char *Contents;
+    json_value *Root;
+    json_value *Host;
+    json_value *Results;
+};
+
+static int
+LoadResultsFile(char *FileName, results_file *File)
+{
+    int Result = 0;
+    
+    memset(File, 0, sizeof(*File));
+    FILE *Source = fopen(FileName, "rb");
+    if(Source)
+    {
+        fseek(Source, 0, SEEK_END);
+        long Size = ftell(Source);
+        fseek(Source, 0, SEEK_SET);
+        
+        File->Contents = (char *)malloc(Size + 1);
+        if(File->Contents && (fread(File->Contents, Size, 1, Source) == 1))
+        {
+            File->Contents[Size] = 0;
+            
+            json_parser Parser = {File->Contents, 0};
+            File->Root = ParseJSONValue(&Parser);
+            File->Host = JSONMember(File->Root, "host");
+            File->Results = JSONMember(File->Root, "results");
+            if(!Parser.Error && File->Results &&
+               (strcmp(JSONString(File->Root, "format"), JSON_RESULTS_FORMAT) == 0))
+            {
+                Result = 1;
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: %s is not a meow_bench results file\n", FileName);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to read %s\n", FileName);
+        }
+        
+        fclose(Source);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s\n", FileName);
+    }
+    
+    return(Result);
+}
+
+static void
+FreeResultsFile(results_file *File)
+{
+    FreeJSON(File->Root);
+    free(File->Contents);
+}
+
+struct mann_whitney
+{
+    // NOTE: Probability that a call from the new run is slower than one from the base
+    // run (ties count half), so 0.5 means no difference and higher is worse
+    double SlowerProbability;
+    double PValue;
+};
+
+static int
+IsWellFormedHistogram(json_value *Histogram)
+{
+    // NOTE: MannWhitney walks the buckets without looking at them again, so they
+    // have to be [clocks, count] pairs with positive counts in increasing order
+    // of clocks, which is how WriteJSON writes them
+    int Result = (Histogram && (Histogram->Type == Json_Array));
+    double LastValue = -1.0;
+    for(json_value *Bucket = Result ? Histogram->FirstChild : 0;
+        Bucket;
+        Bucket = Bucket->Next)
+    {
+        json_value *Value = (Bucket->Type == Json_Array) ? Bucket->FirstChild : 0;
+        json_value *Count = Value ? Value->Next : 0;
+        if(!Count || Count->Next ||
+           (Value->Type != Json_Number) || (Count->Type != Json_Number) ||
+           !(Value->Number > LastValue) || !(Count->Number > 0.0) || isinf(Count->Number))
+        {
+            Result = 0;
+            break;
+        }
+        
+        LastValue = Value->Number;
+    }
+    
+    return(Result);
+}
+
+static mann_whitney
+MannWhitney(json_value *BaseHistogram, json_value *NewHistogram)
+{
+    mann_whitney Result = {0.5, 1.0};
+    
+    double BaseCount = 0.0, NewCount = 0.0;
+    for(json_value *Bucket = BaseHistogram->FirstChild; Bucket; Bucket = Bucket->Next)
+    {
+        BaseCount += Bucket->FirstChild->Next->Number;
+    }
+    for(json_value *Bucket = NewHistogram->FirstChild; Bucket; Bucket = Bucket->Next)
+    {
+        NewCount += Bucket->FirstChild->Next->Number;
+    }
+    
+    if((BaseCount > 0.0) && (NewCount > 0.0))
+    {
+        // NOTE: Walk both histograms in increasing order of clocks.  Every call in a
+        // bucket ties with every call in the same bucket of the other run.
+        double U = 0.0;
+        double TieSum = 0.0;
+        double BaseBelow = 0.0;
+        json_value *Base = BaseHistogram->FirstChild;
+        json_value *New = NewHistogram->FirstChild;
+        while(Base || New)
+        {
+            double BaseValue = Base ? Base->FirstChild->Number : 0.0;
+            double NewValue = New ? New->FirstChild->Number : 0.0;
+            double A = 0.0, B = 0.0;
+            if(Base && (!New || (BaseValue <= NewValue)))
+            {
+                A = Base->FirstChild->Next->Number;
+            }
+            if(New && (!Base || (NewValue <= BaseValue)))
+            {
+                B = New->FirstChild->Next->Number;
+            }
+            
+            U += B*(BaseBelow + 0.5*A);
+            BaseBelow += A;
+            
+            double T = A + B;
+            TieSum += T*T*T - T;
+            
+            if(A > 0.0)
+            {
+                Base = Base->Next;
+            }
+            if(B > 0.0)
+            {
+                New = New->Next;
+            }
+        }
+        
+        double N = BaseCount + NewCount;
+        double Mean = 0.5*BaseCount*NewCount;
+        double Variance = (BaseCount*NewCount/12.0)*((N + 1.0) - TieSum/(N*(N - 1.0)));
+        Result.SlowerProbability = U / (BaseCount*NewCount);
+        if(Variance > 0.0)
+        {
+            double Z = fabs(U - Mean) / sqrt(Variance);
+            Result.PValue = erfc(Z / sqrt(2.0));
+        }
+    }
+    
+    return(Result);
+}
+
+static int
+CompareResultsFiles(char *BaseFileName, char *NewFileName)
+{
+    int Result = -1;
+    
+    results_file Base, New;
+    int BaseLoaded = LoadResultsFile(BaseFileName, &Base);
+    int NewLoaded = LoadResultsFile(NewFileName, &New);
+    if(BaseLoaded && NewLoaded)
+    {
+        fprintf(stdout, "Comparing %s (new) against %s (base)\n", NewFileName, BaseFileName);
+        
+        char const *HostFields[] = {"cpu", "flags", "kernel", "compiler", "cache_mode"};
+        for(int FieldIndex = 0;
+            FieldIndex < ArrayCount(HostFields);
+            ++FieldIndex)
+        {
+            char const *BaseValue = JSONString(Base.Host, HostFields[FieldIndex]);
+            char const *NewValue = JSONString(New.Host, HostFields[FieldIndex]);
+            if(strcmp(BaseValue, NewValue) != 0)
+            {
+                fprintf(stdout, "    WARNING: %s differs: \"%s\" (base) vs. \"%s\" (new)\n",
+                        HostFields[FieldIndex], BaseValue, NewValue);
+            }
+        }
+        if(JSONNumber(Base.Host, "quick") != JSONNumber(New.Host, "quick"))
+        {
+            fprintf(stdout, "    WARNING: only one of the runs is a quick build\n");
+        }
+        
+        // NOTE: Pair up every hash and size that is in both runs
+        int CellCount = 0;
+        for(json_value *Cell = Base.Results->FirstChild; Cell; Cell = Cell->Next)
+        {
+            ++CellCount;
+        }
+        json_value **Pairs = (json_value **)calloc(2*CellCount + 1, sizeof(json_value *));
+        int PairCount = 0;
+        int UnreliableCount = 0;
+        int MalformedCount = 0;
+        for(json_value *BaseCell = Base.Results->FirstChild; BaseCell; BaseCell = BaseCell->Next)
+        {
+            for(json_value *NewCell = New.Results->FirstChild; NewCell; NewCell = NewCell->Next)
+            {
+                if((JSONNumber(BaseCell, "size") == JSONNumber(NewCell, "size")) &&
+                   (strcmp(JSONString(BaseCell, "hash"), JSONString(NewCell, "hash")) == 0) &&
+                   JSONMember(BaseCell, "histogram") && JSONMember(NewCell, "histogram"))
+                {
+                    int BaseIsWellFormed = IsWellFormedHistogram(JSONMember(BaseCell, "histogram"));
+                    int NewIsWellFormed = IsWellFormedHistogram(JSONMember(NewCell, "histogram"));
+                    if(!BaseIsWellFormed || !NewIsWellFormed)
+                    {
+                        fprintf(stderr, "ERROR: %s has a malformed histogram for %s at %.0f bytes\n",
+                                BaseIsWellFormed ? NewFileName : BaseFileName,
+                                JSONString(BaseCell, "hash"), JSONNumber(BaseCell, "size"));
+                        ++MalformedCount;
+                    }
+                    else if(JSONNumber(BaseCell, "unreliable") || JSONNumber(NewCell, "unreliable"))
+                    {
+                        ++UnreliableCount;
+                    }
+                    else
+                    {
+                        Pairs[2*PairCount + 0] = BaseCell;
+                        Pairs[2*PairCount + 1] = NewCell;
+                        ++PairCount;
+                    }
+                    break;
+                }
+            }
+        }
+        
+        fprintf(stdout, "    %d of %d sizes are in both runs\n", PairCount + UnreliableCount + MalformedCount, CellCount);
+        if(UnreliableCount)
+        {
+            fprintf(stdout, "    (skipping %d of them that are marked unreliable in either run)\n", UnreliableCount);
+        }
+        if(MalformedCount)
+        {
+            // NOTE: A damaged file can't be trusted for any of its sizes, so there's
+            // no comparison at all rather than one that quietly leaves sizes out
+            fprintf(stderr, "ERROR: Unable to compare runs with %d malformed histogram%s\n",
+                    MalformedCount, (MalformedCount == 1) ? "" : "s");
+        }
+        else if(PairCount)
+        {
+            mann_whitney *Tests = (mann_whitney *)malloc(PairCount*sizeof(mann_whitney));
+            for(int PairIndex = 0;
+                PairIndex < PairCount;
+                ++PairIndex)
+            {
+                Tests[PairIndex] = MannWhitney(JSONMember(Pairs[2*PairIndex + 0], "histogram"),
+                                               JSONMember(Pairs[2*PairIndex + 1], "histogram"));
+            }
+            
+            double Alpha = COMPARE_ALPHA / (double)PairCount;
+            int RegressionCount = 0;
+            
+            // NOTE: Report each size class and hash in the order they first appear
+            for(int PairIndex = 0;
+                PairIndex < PairCount;
+                ++PairIndex)
+            {
+                char const *SizeClass = JSONString(Pairs[2*PairIndex], "size_class");
+                char const *Hash = JSONString(Pairs[2*PairIndex], "hash");
+                
+                int SeenBefore = 0;
+                for(int EarlierIndex = 0;
+                    EarlierIndex < PairIndex;
+                    ++EarlierIndex)
+                {
+                    if((strcmp(JSONString(Pairs[2*EarlierIndex], "size_class"), SizeClass) == 0) &&
+                       (strcmp(JSONString(Pairs[2*EarlierIndex], "hash"), Hash) == 0))
+                    {
+                        SeenBefore = 1;
+                        break;
+                    }
+                }
+                if(SeenBefore)
+                {
+                    continue;
+                }
+                
+                int Sizes = 0, Slower = 0, Faster = 0;
+                double LogRatioSum = 0.0;
+                for(int MatchIndex = PairIndex;
+                    MatchIndex < PairCount;
+                    ++MatchIndex)
+                {
+                    json_value *BaseCell = Pairs[2*MatchIndex + 0];
+                    json_value *NewCell = Pairs[2*MatchIndex + 1];
+                    if((strcmp(JSONString(BaseCell, "size_class"), SizeClass) == 0) &&
+                       (strcmp(JSONString(BaseCell, "hash"), Hash) == 0))
+                    {
+                        ++Sizes;
+                        double BaseP50 = JSONNumber(BaseCell, "p50");
+                        double NewP50 = JSONNumber(NewCell, "p50");
+                        if((BaseP50 > 0.0) && (NewP50 > 0.0))
+                        {
+                            LogRatioSum += log(NewP50 / BaseP50);
+                        }
+                        
+                        mann_whitney Test = Tests[MatchIndex];
+                        if(Test.PValue < Alpha)
+                        {
+                            Slower += (Test.SlowerProbability >= (0.5 + COMPARE_MIN_EFFECT));
+                            Faster += (Test.SlowerProbability <= (0.5 - COMPARE_MIN_EFFECT));
+                        }
+                    }
+                }
+                
+                fprintf(stdout, "\n%s, %s: %d sizes, %d slower, %d faster, p50 %+0.1f%% (geometric mean)\n",
+                        SizeClass, Hash, Sizes, Slower, Faster, 100.0*(exp(LogRatioSum / (double)Sizes) - 1.0));
+                
+                for(int MatchIndex = PairIndex;
+                    Slower && (MatchIndex < PairCount);
+                    ++MatchIndex)
+                {
+                    json_value *BaseCell = Pairs[2*MatchIndex + 0];
+                    json_value *NewCell = Pairs[2*MatchIndex + 1];
+                    mann_whitney Test = Tests[MatchIndex];
+                    if((strcmp(JSONString(BaseCell, "size_class"), SizeClass) == 0) &&
+                       (strcmp(JSONString(BaseCell, "hash"), Hash) == 0) &&
+                       (Test.PValue < Alpha) &&
+                       (Test.SlowerProbability >= (0.5 + COMPARE_MIN_EFFECT)))
+                    {
+                        double BaseP50 = JSONNumber(BaseCell, "p50");
+                        double NewP50 = JSONNumber(NewCell, "p50");
+                        fprintf(stdout, "    ");
+                        PrintSize(stdout, JSONNumber(BaseCell, "size"), true);
+                        fprintf(stdout, ": SLOWER, p50 %.0f -> %.0f clocks (%+0.1f%%), P(slower) %0.2f, p = %0.2g\n",
+                                BaseP50, NewP50, BaseP50 ? 100.0*(NewP50 - BaseP50)/BaseP50 : 0.0,
+                                Test.SlowerProbability, Test.PValue);
+                    }
+                }
+                
+                RegressionCount += Slower;
+            }
+            
+            fprintf(stdout, "\n%d significant regression%s\n", RegressionCount, (RegressionCount == 1) ? "" : "s");
+            Result = RegressionCount ? 1 : 0;
+            
+            free(Tests);
+        }
+        
+        free(Pairs);
+    }
+    
+    FreeResultsFile(&Base);
+    FreeResultsFile(&New);
+    
+    return(Result);
+}
+
+//
+// NOTE: Cache state
+//
+// By default every call hashes a buffer that FuddleBuffer has just written, so
+// small inputs are always hashed out of a warm L1.  The other cache modes set the
+// buffer up the way a service usually sees a key instead:
+//
+//   flush: every line of the input is clflush'd, so it comes from DRAM
+//   llc:   the private caches are evicted by reading a buffer twice their size,
+//          leaving the input in the last-level cache (if it fits there)
+//   dram:  calls rotate through a working set several times the size of the
+//          last-level cache, which is written once up front, so each input is
+//          data the CPU hasn't touched in a long time
+//
+// The working set isn't walked in order, since the stream prefetcher would then
+// have every input in cache before it was asked for.  See NextWorkingSetSlot.
+//
+
+enum cache_mode
+{
+    CacheMode_Warm,
+    CacheMode_Flush,
+    CacheMode_LLC,
+    CacheMode_DRAM,
+};
+
+static char const *CacheModeNames[] = {"warm", "flush", "llc", "dram"};
+
+// NOTE: Flushing the input or evicting the private caches costs far more than
+// hashing a small input, so those modes run this many times fewer calls per size.
+#define COLD_MODE_RUN_DIVISOR 64
+
+#define WORKING_SET_LLC_MULTIPLE 4
+
+struct cache_sizes
+{
+    meow_u64 L1D;
+    meow_u64 L2;
+    meow_u64 LLC;
+};
+
+static cache_sizes
+GetCacheSizes(void)
+{
+    cache_sizes Result = {Kb(32), Mb(1), Mb(32)};
+    
+#if __linux__ && defined(_SC_LEVEL1_DCACHE_SIZE)
+    long L1D = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long L2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long L3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if(L1D > 0)
+    {
+        Result.L1D = L1D;
+    }
+    if(L2 > 0)
+    {
+        Result.L2 = L2;
+    }
+    if(L3 > 0)
+    {
+        Result.LLC = L3;
+    }
+    else if(L2 > 0)
+    {
+        Result.LLC = L2;
+    }
+#endif
+    
+    return(Result);
+}
+
+static void
+FlushBuffer(meow_u64 Size, void *Buffer)
+{
+    meow_u8 *At = (meow_u8 *)Buffer;
+    for(meow_u64 Offset = 0;
+        Offset < Size;
+        Offset += 64)
+    {
+        _mm_clflush(At + Offset);
+    }
+    if(Size)
+    {
+        _mm_clflush(At + Size - 1);
+    }
+    _mm_mfence();
+}
+
+// NOTE: Where the eviction reads go, so that they can't be optimized out
+static meow_u64 EvictFakeSlot;
+
+static void
+EvictPrivateCaches(meow_u64 Size, void *EvictBuffer)
+{
+    meow_u64 *At = (meow_u64 *)EvictBuffer;
+    meow_u64 Sum = 0;
+    for(meow_u64 Index = 0;
+        Index < (Size / sizeof(meow_u64));
+        Index += 64 / sizeof(meow_u64))
+    {
+        Sum += At[Index];
+    }
+    EvictFakeSlot += Sum;
+}
+
+//
+// NOTE: Working sets are split into page-sized granules, visited in an order
+// shuffled once when the set is made, so that there is no stream for the
+// prefetchers to pick up.  Each lap through the granules starts the inputs at a
+// different line within them, so a line isn't hashed again until every other
+// position in the set has been - small inputs don't end up reusing the same few
+// lines, which would still be in cache.
+//
+
+#define WORKING_SET_GRANULE 4096
+
+struct working_set
+{
+    meow_u8 *Base;
+    meow_u64 Size;
+    
+    meow_u64 GranuleSize;
+    meow_u32 GranuleCount;
+    meow_u32 *Order;
+    meow_u32 Cursor;
+    meow_u32 Lap;
+};
+
+static void
+InitWorkingSet(working_set *Set, void *Base, meow_u64 Size)
+{
+    Set->Base = (meow_u8 *)Base;
+    Set->Size = Size;
+    
+    // NOTE: Sets smaller than a couple of pages still need a few granules to shuffle
+    Set->GranuleSize = WORKING_SET_GRANULE;
+    while((Set->GranuleSize > CACHE_LINE_ALIGNMENT) && ((2*Set->GranuleSize) > Size))
+    {
+        Set->GranuleSize /= 2;
+    }
+    Set->GranuleCount = (meow_u32)(Size / Set->GranuleSize);
+    if(Set->GranuleCount == 0)
+    {
+        Set->GranuleCount = 1;
+    }
+    
+    Set->Order = (meow_u32 *)malloc(Set->GranuleCount*sizeof(meow_u32));
+    for(meow_u32 Index = 0;
+        Index < Set->GranuleCount;
+        ++Index)
+    {
+        Set->Order[Index] = Index;
+    }
+    
+    meow_u64 Series = 0x9e3779b97f4a7c15ULL ^ Size;
+    for(meow_u32 Index = Set->GranuleCount - 1;
+        Index > 0;
+        --Index)
+    {
+        meow_u32 Other = Random(&Series) % (Index + 1);
+        meow_u32 Temp = Set->Order[Index];
+        Set->Order[Index] = Set->Order[Other];
+        Set->Order[Other] = Temp;
+    }
+    
+    Set->Cursor = 0;
+    Set->Lap = 0;
+}
+
+static void
+FreeWorkingSet(working_set *Set)
+{
+    free(Set->Order);
+    Set->Order = 0;
+}
+
+static void *
+NextWorkingSetSlot(working_set *Set, meow_u64 Size)
+{
+    void *Result = Set->Base;
+    if(Size <= Set->Size)
+    {
+        // NOTE: An odd step through the lines of a granule, so consecutive laps
+        // aren't on neighbouring lines either (the adjacent-line prefetcher)
+        meow_u64 LinesPerGranule = Set->GranuleSize / CACHE_LINE_ALIGNMENT;
+        meow_u64 Offset = ((meow_u64)Set->Order[Set->Cursor]*Set->GranuleSize +
+                           ((Set->Lap*11) % LinesPerGranule)*CACHE_LINE_ALIGNMENT);
+        if(++Set->Cursor == Set->GranuleCount)
+        {
+            Set->Cursor = 0;
+            ++Set->Lap;
+        }
+        
+        // NOTE: Inputs bigger than a granule may not fit from where it starts
+        meow_u64 LastStart = Set->Size - Size;
+        if(Offset > LastStart)
+        {
+            Offset = (Offset % (LastStart + 1)) & ~(meow_u64)(CACHE_LINE_ALIGNMENT - 1);
+        }
+        
+        Result = Set->Base + Offset;
+    }
+    
+    return(Result);
+}
+
+//
+// NOTE: Where inputs come from is measured rather than assumed from the size of
+// the working set: a single load from each of the next slots is timed, and its
+// median is put against the same measurement taken on sets that sit in each
+// level of the hierarchy.
+//
+
+#define LOAD_PROBE_COUNT 2048
+
+enum memory_level
+{
+    MemoryLevel_L1,
+    MemoryLevel_L2,
+    MemoryLevel_LLC,
+    MemoryLevel_DRAM,
+    
+    MemoryLevel_Count,
+};
+
+static char const *MemoryLevelNames[] = {"L1", "L2", "LLC", "DRAM"};
+
+// NOTE: Median load clocks for each level, from CalibrateLoadLatency
+static double LevelLoadClocks[MemoryLevel_Count];
+
+// NOTE: Where the probe's loads go, so that they can't be optimized out
+static meow_u64 ProbeFakeSlot;
+
+static meow_u64
+ProbeLoadClocks(working_set *Set, meow_u64 Size)
+{
+    meow_u64 Clocks[LOAD_PROBE_COUNT];
+    for(int ProbeIndex = 0;
+        ProbeIndex < LOAD_PROBE_COUNT;
+        ++ProbeIndex)
+    {
+        volatile meow_u64 *Slot = (volatile meow_u64 *)NextWorkingSetSlot(Set, Size);
+        int unsigned Ignored;
+        
+        // NOTE: rdtscp waits for the load to complete before reading the clock
+        meow_u64 StartClock = __rdtsc();
+        ProbeFakeSlot += *Slot;
+        meow_u64 EndClock = __rdtscp(&Ignored);
+        
+        Clocks[ProbeIndex] = EndClock - StartClock;
+    }
+    
+    qsort(Clocks, LOAD_PROBE_COUNT, sizeof(meow_u64), CompareSizes);
+    meow_u64 Result = Clocks[LOAD_PROBE_COUNT / 2];
+    return(Result);
+}
+
+static void
+CalibrateLoadLatency(void *Buffer, meow_u64 BufferSize, cache_sizes Caches)
+{
+    meow_u64 LevelSizes[MemoryLevel_Count] = {Caches.L1D / 2, Caches.L2 / 2, Caches.LLC / 2, 4*Caches.LLC};
+    for(int Level = 0;
+        Level < MemoryLevel_Count;
+        ++Level)
+    {
+        meow_u64 Size = LevelSizes[Level];
+        if(Size > BufferSize)
+        {
+            Size = BufferSize;
+        }
+        
+        // NOTE: One lap first (or as much of one as is quick), so the set is
+        // resident wherever it fits before anything is timed
+        working_set Set;
+        InitWorkingSet(&Set, Buffer, Size);
+        meow_u64 WarmCount = Size / CACHE_LINE_ALIGNMENT;
+        if(WarmCount > 1024*1024)
+        {
+            WarmCount = 1024*1024;
+        }
+        for(meow_u64 Index = 0;
+            Index < WarmCount;
+            ++Index)
+        {
+            ProbeFakeSlot += *(volatile meow_u64 *)NextWorkingSetSlot(&Set, sizeof(meow_u64));
+        }
+        
+        LevelLoadClocks[Level] = (double)ProbeLoadClocks(&Set, sizeof(meow_u64));
+        FreeWorkingSet(&Set);
+    }
+}
+
+static void
+PrintLoadCalibration(FILE *Stream)
+{
+    fprintf(Stream, "Load clocks when calibrated:");
+    for(int Level = 0;
+        Level < MemoryLevel_Count;
+        ++Level)
+    {
+        fprintf(Stream, " %s %.0f", MemoryLevelNames[Level], LevelLoadClocks[Level]);
+    }
+    fprintf(Stream, "\n");
+}
+
+// NOTE: The level whose calibrated load time is closest (as a ratio) to this one
+static char const *
+MeasuredMemoryLevel(meow_u64 LoadClocks)
+{
+    int Best = MemoryLevel_DRAM;
+    double BestDistance = 0.0;
+    for(int Level = 0;
+        Level < MemoryLevel_Count;
+        ++Level)
+    {
+        double Distance = fabs(log((double)(LoadClocks + 1)) - log(LevelLoadClocks[Level] + 1.0));
+        if((Level == 0) || (Distance < BestDistance))
+        {
+            Best = Level;
+            BestDistance = Distance;
+        }
+    }
+    
+    char const *Result = MemoryLevelNames[Best];
+    return(Result);
+}
+
+struct cache_setup
+{
+    int Mode;
+    void *Buffer;
+    working_set *WorkingSet;
+    void *EvictBuffer;
+    meow_u64 EvictSize;
+};
+
+// NOTE: Puts an input of this size into the cache state the mode asks for, and returns where it is
+static void *
+PrepareInput(cache_setup *Setup, meow_u64 Size, int Seed)
+{
+    void *Result = Setup->Buffer;
+    if(Setup->Mode == CacheMode_DRAM)
+    {
+        Result = NextWorkingSetSlot(Setup->WorkingSet, Size);
+    }
+    else
+    {
+        FuddleBuffer(Size, Setup->Buffer, Seed);
+        if(Setup->Mode == CacheMode_Flush)
+        {
+            FlushBuffer(Size, Setup->Buffer);
+        }
+        else if(Setup->Mode == CacheMode_LLC)
+        {
+            EvictPrivateCaches(Setup->EvictSize, Setup->EvictBuffer);
+        }
+    }
+    
+    return(Result);
+}
+
+//
+// NOTE: The working-set sweep holds the input size fixed and grows the set of
+// buffers it rotates through, from well inside L1 to well past the last-level
+// cache, so the transitions between cache levels show up directly.
+//
+
+#define SWEEP_CALLS_PER_POINT 20000
+
+// NOTE: A fake result target, like input_size_test::FakeSlot
+static meow_u128 SweepFakeSlot;
+
+static meow_u64
+TimeHashCall(meow_hash_implementation *Imp, meow_u64 Size, void *Source)
+{
+    int Ignored[4];
+    int unsigned Ignored2;
+    CPUID(Ignored, 0);
+    meow_u64 StartClock = __rdtsc();
+    SweepFakeSlot = Imp(MeowDefaultSeed, Size, Source);
+    meow_u64 EndClock = __rdtscp(&Ignored2);
+    CPUID(Ignored, 0);
+    
+    meow_u64 Result = EndClock - StartClock;
+    return(Result);
+}
+
+static void
+RunWorkingSetSweep(void *Buffer, meow_u64 BufferSize, cache_sizes Caches, char *CSVFileName)
+{
+    meow_u64 InputSizes[] = {64, 1024, Kb(16)};
+    
+    meow_u64 MaxWorkingSet = 8*Caches.LLC;
+    if(MaxWorkingSet > BufferSize)
+    {
+        MaxWorkingSet = BufferSize;
+    }
+    
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Hash,Input size,Working set,p50 clocks,Bytes/cycle,Load clocks,Measured level\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    FuddleBuffer(MaxWorkingSet, Buffer, 1);
+    CalibrateLoadLatency(Buffer, MaxWorkingSet, Caches);
+    PrintLoadCalibration(stdout);
+    
+    meow_u32 *Histogram = (meow_u32 *)malloc(HISTOGRAM_BUCKET_COUNT*sizeof(meow_u32));
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    for(int unsigned TypeIndex = 0;
+        TypeIndex < TypeCount;
+        ++TypeIndex)
+    {
+        named_hash_type Type = NamedHashTypes[TypeIndex];
+        fprintf(stdout, "\n%s:\n", Type.FullName);
+        
+        // NOTE: Calling through a volatile pointer keeps the compiler from inlining the
+        // hash here and then hoisting it out of the timed region or dropping it.
+        meow_hash_implementation *volatile Imp = Type.Imp;
+        
+        TRY
+        {
+            for(int InputIndex = 0;
+                InputIndex < ArrayCount(InputSizes);
+                ++InputIndex)
+            {
+                meow_u64 Size = InputSizes[InputIndex];
+                fprintf(stdout, "  ");
+                PrintSize(stdout, (double)Size, false);
+                fprintf(stdout, " inputs:\n");
+                
+                for(meow_u64 WorkingSetSize = 2*Size;
+                    WorkingSetSize <= MaxWorkingSet;
+                    WorkingSetSize *= 2)
+                {
+                    memset(Histogram, 0, HISTOGRAM_BUCKET_COUNT*sizeof(meow_u32));
+                    meow_u64 MaxClocks = 0;
+                    
+                    working_set Set;
+                    InitWorkingSet(&Set, Buffer, WorkingSetSize);
+                    for(int CallIndex = 0;
+                        CallIndex < SWEEP_CALLS_PER_POINT;
+                        ++CallIndex)
+                    {
+                        void *Source = NextWorkingSetSlot(&Set, Size);
+                        meow_u64 Clocks = TimeHashCall(Imp, Size, Source);
+                        ++Histogram[HistogramBucket(Clocks)];
+                        if(MaxClocks < Clocks)
+                        {
+                            MaxClocks = Clocks;
+                        }
+                    }
+                    
+                    meow_u64 P50 = HistogramPercentile(Histogram, SWEEP_CALLS_PER_POINT, MaxClocks, 0.5);
+                    meow_u64 LoadClocks = ProbeLoadClocks(&Set, Size);
+                    char const *Level = MeasuredMemoryLevel(LoadClocks);
+                    FreeWorkingSet(&Set);
+                    
+                    fprintf(stdout, "    ");
+                    PrintSize(stdout, (double)WorkingSetSize, true);
+                    fprintf(stdout, " working set (loads %4.0f clocks, %-4s): %8.0f p50 clocks, %6.03f bytes/cycle\n",
+                            (double)LoadClocks, Level, (double)P50, P50 ? (double)Size / (double)P50 : 0.0);
+                    fflush(stdout);
+                    
+                    if(CSV)
+                    {
+                        fprintf(CSV, "%s,%.0f,%.0f,%.0f,%f,%.0f,%s\n", Type.FullName, (double)Size, (double)WorkingSetSize,
+                                (double)P50, P50 ? (double)Size / (double)P50 : 0.0, (double)LoadClocks, Level);
+                    }
+                }
+            }
+        }
+        CATCH
+        {
+            fprintf(stderr, "    (%s not supported on this CPU)\n", Type.FullName);
+        }
+    }
+    
+    free(Histogram);
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+}
+
+//
+// NOTE: Memory roofline
+//
+// Bytes/cycle alone can't say whether a hash is limited by its own arithmetic or
+// by how fast the memory system delivers the input.  Before each batch, every
+// size is also run through a plain read loop (the same 128-bit loads and, for big
+// inputs, the same prefetching the hash uses, and nothing else) and through memcpy, in the same cache state the hashes
+// will see.  The read loop is the roofline: a hash at 100% of it is memory-bound,
+// and one well under it is leaving bandwidth for prefetching or interleaving.
+//
+
+#define ROOFLINE_CALLS_PER_SIZE 64
+#define ROOFLINE_BYTES_PER_SIZE Gb(1)
+
+// NOTE: memcpy goes through this in pieces, so giant sizes don't need a second giant buffer
+#define ROOFLINE_COPY_CHUNK Mb(64)
+static meow_u8 *RooflineCopyBuffer;
+
+static meow_u128
+StreamRead(void *Seed, meow_u64 Len, void *Source)
+{
+    (void)Seed;
+    meow_u8 *At = (meow_u8 *)Source;
+    meow_u128 A = _mm_setzero_si128();
+    meow_u128 B = _mm_setzero_si128();
+    meow_u128 C = _mm_setzero_si128();
+    meow_u128 D = _mm_setzero_si128();
+    int Prefetch = (Len > 256*MEOW_PREFETCH_LIMIT);
+    while(Len >= 64)
+    {
+        if(Prefetch)
+        {
+            _mm_prefetch((char *)(At + MEOW_PREFETCH), _MM_HINT_T0);
+        }
+        A = _mm_xor_si128(A, _mm_loadu_si128((meow_u128 *)(At + 0)));
+        B = _mm_xor_si128(B, _mm_loadu_si128((meow_u128 *)(At + 16)));
+        C = _mm_xor_si128(C, _mm_loadu_si128((meow_u128 *)(At + 32)));
+        D = _mm_xor_si128(D, _mm_loadu_si128((meow_u128 *)(At + 48)));
+        At += 64;
+        Len -= 64;
+    }
+    while(Len >= 16)
+    {
+        A = _mm_xor_si128(A, _mm_loadu_si128((meow_u128 *)At));
+        At += 16;
+        Len -= 16;
+    }
+    
+    meow_u64 Tail = 0;
+    for(;
+        Len;
+        --Len)
+    {
+        Tail = (Tail << 8) | *At++;
+    }
+    A = _mm_xor_si128(A, _mm_cvtsi64_si128((long long)Tail));
+    
+    meow_u128 Result = _mm_xor_si128(_mm_xor_si128(A, B), _mm_xor_si128(C, D));
+    return(Result);
+}
+
+static meow_u128
+StreamCopy(void *Seed, meow_u64 Len, void *Source)
+{
+    (void)Seed;
+    meow_u8 *At = (meow_u8 *)Source;
+    while(Len)
+    {
+        meow_u64 Chunk = (Len < ROOFLINE_COPY_CHUNK) ? Len : ROOFLINE_COPY_CHUNK;
+        memcpy(RooflineCopyBuffer, At, Chunk);
+        At += Chunk;
+        Len -= Chunk;
+    }
+    
+    meow_u128 Result = _mm_loadu_si128((meow_u128 *)RooflineCopyBuffer);
+    return(Result);
+}
+
+// NOTE: Where an input of this size comes from in this cache mode.  Flushing and
+// evicting put inputs in a known place, but a working set is probed, since how
+// far out its inputs really are depends on what the prefetchers make of it.
+static char const *
+MemoryLevelFor(cache_setup *Setup, cache_sizes Caches, meow_u64 Size)
+{
+    int CacheMode = Setup->Mode;
+    char const *Result = "DRAM";
+    if(CacheMode == CacheMode_DRAM)
+    {
+        Result = MeasuredMemoryLevel(ProbeLoadClocks(Setup->WorkingSet, Size));
+    }
+    else if(CacheMode == CacheMode_Warm)
+    {
+        Result = ((Size <= Caches.L1D) ? "L1" :
+                  (Size <= Caches.L2) ? "L2" :
+                  (Size <= Caches.LLC) ? "LLC" :
+                  "DRAM");
+    }
+    else if((CacheMode == CacheMode_LLC) && (Size <= Caches.LLC))
+    {
+        Result = "LLC";
+    }
+    return(Result);
+}
+
+static void
+MeasureRoofline(input_size_tests *Tests, cache_setup *Setup, cache_sizes Caches)
+{
+    meow_hash_implementation *volatile Kernels[] = {StreamRead, StreamCopy};
+    
+    for(int unsigned SizeIndex = 0;
+        SizeIndex < Tests->SizeCount;
+        ++SizeIndex)
+    {
+        input_size_test *Test = Tests->Sizes + SizeIndex;
+        meow_u64 Size = Test->Size;
+        
+        meow_u64 CallCount = ROOFLINE_CALLS_PER_SIZE;
+        if(Size && ((CallCount*Size) > ROOFLINE_BYTES_PER_SIZE))
+        {
+            CallCount = ROOFLINE_BYTES_PER_SIZE / Size;
+            if(CallCount < 4)
+            {
+                CallCount = 4;
+            }
+        }
+        
+        double BPC[ArrayCount(Kernels)] = {};
+        for(int KernelIndex = 0;
+            KernelIndex < ArrayCount(Kernels);
+            ++KernelIndex)
+        {
+            meow_u64 MinClocks = (meow_u64)-1;
+            for(meow_u64 CallIndex = 0;
+                CallIndex < CallCount;
+                ++CallIndex)
+            {
+                void *Source = PrepareInput(Setup, Size, (int)CallIndex);
+                meow_u64 Clocks = TimeHashCall(Kernels[KernelIndex], Size, Source);
+                if(MinClocks > Clocks)
+                {
+                    MinClocks = Clocks;
+                }
+            }
+            
+            if(Size && MinClocks)
+            {
+                BPC[KernelIndex] = (double)Size / (double)MinClocks;
+            }
+        }
+        
+        Test->MemoryLevel = MemoryLevelFor(Setup, Caches, Size);
+        Test->ReadBPC = BPC[0];
+        Test->CopyBPC = BPC[1];
+    }
+}
+
+//
+// NOTE: Alignment sweep
+//
+// The benchmark buffer is CACHE_LINE_ALIGNMENT-aligned, but real keys start
+// wherever they happen to start.  The first half of this sweep moves the start of
+// the input through every offset within a cache line, so the cost of 16-byte loads
+// that split across two lines shows up against offset 0.  The second half moves the
+// _end_ of the input through every position within a page.  When loading the
+// residual (Len & 0xf) would read past the end of the page, MeowHash loads from
+// before it instead and shifts it into place with MeowShiftAdjust, so that
+// page-safe path is timed separately, as are inputs that straddle two pages.
+//
+
+#define ALIGNMENT_CALLS_PER_POINT 2000
+#define PAGE_END_CALLS_PER_POINT 200
+
+enum page_end_class
+{
+    PageEnd_Normal,
+    PageEnd_Crossing,
+    PageEnd_SafeResidual,
+    
+    PageEnd_Count,
+};
+
+static char const *PageEndClassNames[] = {"normal", "page-crossing", "page-safe residual"};
+
+static int
+ClassifyPageEnd(meow_u8 *Source, meow_u64 Len)
+{
+    int Result = PageEnd_Normal;
+    
+    // NOTE: This is the same test MeowHash makes before loading the residual
+    meow_u8 *Last = Source + (Len & ~0xf);
+    meow_u8 *LastOk = (meow_u8 *)((((meow_umm)(Source + Len - 1)) | (MEOW_PAGESIZE - 1)) - 16);
+    if((Len & 0xf) && (Last > LastOk))
+    {
+        Result = PageEnd_SafeResidual;
+    }
+    else if(Len && ((((meow_umm)Source) ^ ((meow_umm)(Source + Len - 1))) & ~(meow_umm)(MEOW_PAGESIZE - 1)))
+    {
+        Result = PageEnd_Crossing;
+    }
+    
+    return(Result);
+}
+
+static meow_u64
+TimeSweepPoint(meow_hash_implementation *Imp, meow_u64 Size, void *Source, int CallCount, meow_u32 *Histogram)
+{
+    memset(Histogram, 0, HISTOGRAM_BUCKET_COUNT*sizeof(meow_u32));
+    meow_u64 MaxClocks = 0;
+    for(int CallIndex = 0;
+        CallIndex < CallCount;
+        ++CallIndex)
+    {
+        meow_u64 Clocks = TimeHashCall(Imp, Size, Source);
+        ++Histogram[HistogramBucket(Clocks)];
+        if(MaxClocks < Clocks)
+        {
+            MaxClocks = Clocks;
+        }
+    }
+    
+    meow_u64 Result = HistogramPercentile(Histogram, CallCount, MaxClocks, 0.5);
+    return(Result);
+}
+
+static double
+PenaltyPercent(double Clocks, double BaseClocks)
+{
+    double Result = BaseClocks ? 100.0*(Clocks - BaseClocks) / BaseClocks : 0.0;
+    return(Result);
+}
+
+static void
+RunAlignmentSweep(void *Buffer, meow_u64 BufferSize, char *CSVFileName)
+{
+    meow_u64 OffsetSizes[] = {16, 64, 256, 1024, Kb(16)};
+    meow_u64 PageEndSizes[] = {1, 15, 17, 31, 33, 63, 255, 1023};
+    
+    // NOTE: Positions are relative to real page boundaries, wherever the allocator put the buffer
+    meow_u8 *PageBase = (meow_u8 *)(((meow_umm)Buffer + MEOW_PAGESIZE - 1) & ~(meow_umm)(MEOW_PAGESIZE - 1));
+    meow_u64 SweepSize = Kb(16) + 2*MEOW_PAGESIZE;
+    if((PageBase + SweepSize) > ((meow_u8 *)Buffer + BufferSize))
+    {
+        fprintf(stderr, "ERROR: Buffer too small for the alignment sweep\n");
+        return;
+    }
+    FuddleBuffer(SweepSize, PageBase, 1);
+    
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Hash,Sweep,Input size,Position,Class,p50 clocks\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    meow_u32 *Histogram = (meow_u32 *)malloc(HISTOGRAM_BUCKET_COUNT*sizeof(meow_u32));
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    for(int unsigned TypeIndex = 0;
+        TypeIndex < TypeCount;
+        ++TypeIndex)
+    {
+        named_hash_type Type = NamedHashTypes[TypeIndex];
+        fprintf(stdout, "\n%s:\n", Type.FullName);
+        
+        meow_hash_implementation *volatile Imp = Type.Imp;
+        
+        TRY
+        {
+            //
+            // NOTE: Start offset within a cache line
+            //
+            
+            fprintf(stdout, "  Start offset 0-63 (p50 clocks; penalty vs. offset 0):\n");
+            for(int SizeIndex = 0;
+                SizeIndex < ArrayCount(OffsetSizes);
+                ++SizeIndex)
+            {
+                meow_u64 Size = OffsetSizes[SizeIndex];
+                
+                double AlignedClocks = 0;
+                double Sum16 = 0, SumOdd = 0;
+                int Count16 = 0, CountOdd = 0;
+                meow_u64 WorstClocks = 0;
+                int WorstOffset = 0;
+                for(int Offset = 0;
+                    Offset < 64;
+                    ++Offset)
+                {
+                    meow_u64 P50 = TimeSweepPoint(Imp, Size, PageBase + Offset, ALIGNMENT_CALLS_PER_POINT, Histogram);
+                    if(Offset == 0)
+                    {
+                        AlignedClocks = (double)P50;
+                    }
+                    else if((Offset & 0xf) == 0)
+                    {
+                        Sum16 += (double)P50;
+                        ++Count16;
+                    }
+                    else
+                    {
+                        SumOdd += (double)P50;
+                        ++CountOdd;
+                    }
+                    
+                    if(WorstClocks < P50)
+                    {
+                        WorstClocks = P50;
+                        WorstOffset = Offset;
+                    }
+                    
+                    if(CSV)
+                    {
+                        fprintf(CSV, "%s,offset,%.0f,%d,%s,%.0f\n", Type.FullName, (double)Size, Offset,
+                                (Offset == 0) ? "aligned" : ((Offset & 0xf) == 0) ? "16-byte aligned" : "split",
+                                (double)P50);
+                    }
+                }
+                
+                double Clocks16 = Sum16 / (double)Count16;
+                double ClocksOdd = SumOdd / (double)CountOdd;
+                fprintf(stdout, "    ");
+                PrintSize(stdout, (double)Size, true);
+                fprintf(stdout, ": aligned %0.0f, 16-byte aligned %0.0f (%+0.1f%%), unaligned %0.0f (%+0.1f%%), worst %0.0f at offset %d\n",
+                        AlignedClocks, Clocks16, PenaltyPercent(Clocks16, AlignedClocks),
+                        ClocksOdd, PenaltyPercent(ClocksOdd, AlignedClocks),
+                        (double)WorstClocks, WorstOffset);
+                fflush(stdout);
+            }
+            
+            //
+            // NOTE: End position within a page
+            //
+            
+            fprintf(stdout, "  End position 0-%d within a page (mean p50 clocks; penalty vs. normal):\n", MEOW_PAGESIZE - 1);
+            for(int SizeIndex = 0;
+                SizeIndex < ArrayCount(PageEndSizes);
+                ++SizeIndex)
+            {
+                meow_u64 Size = PageEndSizes[SizeIndex];
+                
+                double ClassSum[PageEnd_Count] = {};
+                int ClassCount[PageEnd_Count] = {};
+                for(int EndPosition = 0;
+                    EndPosition < MEOW_PAGESIZE;
+                    ++EndPosition)
+                {
+                    meow_u8 *Source = PageBase + 2*MEOW_PAGESIZE + EndPosition - Size;
+                    int Class = ClassifyPageEnd(Source, Size);
+                    meow_u64 P50 = TimeSweepPoint(Imp, Size, Source, PAGE_END_CALLS_PER_POINT, Histogram);
+                    ClassSum[Class] += (double)P50;
+                    ++ClassCount[Class];
+                    
+                    if(CSV)
+                    {
+                        fprintf(CSV, "%s,page end,%.0f,%d,%s,%.0f\n", Type.FullName, (double)Size, EndPosition,
+                                PageEndClassNames[Class], (double)P50);
+                    }
+                }
+                
+                double NormalClocks = ClassCount[PageEnd_Normal] ? ClassSum[PageEnd_Normal] / (double)ClassCount[PageEnd_Normal] : 0.0;
+                fprintf(stdout, "    ");
+                PrintSize(stdout, (double)Size, true);
+                fprintf(stdout, ": ");
+                for(int Class = 0;
+                    Class < PageEnd_Count;
+                    ++Class)
+                {
+                    fprintf(stdout, "%s%s ", Class ? ", " : "", PageEndClassNames[Class]);
+                    if(ClassCount[Class])
+                    {
+                        double Clocks = ClassSum[Class] / (double)ClassCount[Class];
+                        fprintf(stdout, "%0.1f", Clocks);
+                        if(Class != PageEnd_Normal)
+                        {
+                            fprintf(stdout, " (%+0.1f%%)", PenaltyPercent(Clocks, NormalClocks));
+                        }
+                        fprintf(stdout, " x%d", ClassCount[Class]);
+                    }
+                    else
+                    {
+                        fprintf(stdout, "-");
+                    }
+                }
+                fprintf(stdout, "\n");
+                fflush(stdout);
+            }
+        }
+        CATCH
+        {
+            fprintf(stderr, "    (%s not supported on this CPU)\n", Type.FullName);
+        }
+    }
+    
+    free(Histogram);
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+}
+
+//
+// NOTE: TLB sweep
+//
+// The giant inputs are far bigger than the last-level cache, so they stream from
+// DRAM whatever the pages look like, but on 4kb pages they also miss the TLB about
+// once per page.  This hashes each giant size out of buffers mapped with every
+// kind of page, and takes the difference between 4kb pages and the fastest
+// mapping that really got huge pages as the share of the cost that's page walks.
+//
+
+#define TLB_SWEEP_CALLS_PER_POINT 8
+
+static void
+RunTLBSweep(meow_u64 *Sizes, int SizeCount, int *HashIsSelected, perf_counters *Perf, int Node, char *CSVFileName)
+{
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Hash,Input size,Pages,Huge page bytes,Min clocks,Bytes/cycle,dTLB misses per call\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    int HaveTLBMisses = ((Perf->EventCount > PerfEvent_DTLBMisses) && Perf->Available[PerfEvent_DTLBMisses]);
+    
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    for(int unsigned TypeIndex = 0;
+        TypeIndex < TypeCount;
+        ++TypeIndex)
+    {
+        if(!HashIsSelected[TypeIndex])
+        {
+            continue;
+        }
+        
+        named_hash_type Type = NamedHashTypes[TypeIndex];
+        fprintf(stdout, "\n%s:\n", Type.FullName);
+        
+        meow_hash_implementation *volatile Imp = Type.Imp;
+        
+        TRY
+        {
+            for(int SizeIndex = 0;
+                SizeIndex < SizeCount;
+                ++SizeIndex)
+            {
+                meow_u64 Size = Sizes[SizeIndex];
+                fprintf(stdout, "  ");
+                PrintSize(stdout, (double)Size, false);
+                fprintf(stdout, " inputs:\n");
+                
+                meow_u64 SmallClocks = 0;
+                meow_u64 BestHugeClocks = 0;
+                for(int Kind = Pages_Small;
+                    Kind < Pages_Count;
+                    ++Kind)
+                {
+                    fprintf(stdout, "    %-4s pages: ", PageKindNames[Kind]);
+                    
+                    void *Memory = AllocPages(Size, Node, (page_kind)Kind);
+                    if(!Memory)
+                    {
+                        fprintf(stdout, "not available%s\n",
+                                (Kind == Pages_Huge2MB) ? " (reserve some in /proc/sys/vm/nr_hugepages)" :
+                                (Kind == Pages_Huge1GB) ? " (reserve some in /sys/kernel/mm/hugepages/hugepages-1048576kB)" :
+                                "");
+                        continue;
+                    }
+                    
+                    // NOTE: Writing every byte faults all the pages in up front, so the
+                    // timed calls only see TLB misses, not page faults
+                    FuddleBuffer(Size, Memory, 0);
+                    meow_u64 HugeBytes = 0;
+                    int KnowHuge = GetHugePageBytes(Memory, &HugeBytes);
+                    
+                    meow_u64 MinClocks = (meow_u64)-1;
+                    meow_u64 TLBMisses = 0;
+                    TimeHashCall(Imp, Size, Memory);
+                    for(int CallIndex = 0;
+                        CallIndex < TLB_SWEEP_CALLS_PER_POINT;
+                        ++CallIndex)
+                    {
+                        perf_sample Start = {}, End = {};
+                        if(HaveTLBMisses)
+                        {
+                            ReadPerfCounters(Perf, &Start);
+                        }
+                        meow_u64 Clocks = TimeHashCall(Imp, Size, Memory);
+                        if(HaveTLBMisses)
+                        {
+                            ReadPerfCounters(Perf, &End);
+                            TLBMisses += End.Values[PerfEvent_DTLBMisses] - Start.Values[PerfEvent_DTLBMisses];
+                        }
+                        
+                        if(MinClocks > Clocks)
+                        {
+                            MinClocks = Clocks;
+                        }
+                    }
+                    
+                    double BytesPerCycle = (double)Size / (double)MinClocks;
+                    double MissesPerCall = (double)TLBMisses / (double)TLB_SWEEP_CALLS_PER_POINT;
+                    fprintf(stdout, "%6.03f bytes/cycle (%.0f min clocks)", BytesPerCycle, (double)MinClocks);
+                    if(KnowHuge)
+                    {
+                        fprintf(stdout, ", %3.0f%% huge", 100.0*(double)HugeBytes / (double)Size);
+                    }
+                    if(HaveTLBMisses)
+                    {
+                        fprintf(stdout, ", %0.1f dTLB misses/mb", MissesPerCall / ((double)Size / (double)Mb(1)));
+                    }
+                    fprintf(stdout, "\n");
+                    fflush(stdout);
+                    
+                    if(Kind == Pages_Small)
+                    {
+                        SmallClocks = MinClocks;
+                    }
+                    else if(KnowHuge && (2*HugeBytes >= Size) &&
+                            (!BestHugeClocks || (BestHugeClocks > MinClocks)))
+                    {
+                        BestHugeClocks = MinClocks;
+                    }
+                    
+                    if(CSV)
+                    {
+                        fprintf(CSV, "%s,%.0f,%s,%.0f,%.0f,%f,%.1f\n", Type.FullName, (double)Size, PageKindNames[Kind],
+                                (double)HugeBytes, (double)MinClocks, BytesPerCycle, MissesPerCall);
+                    }
+                    
+                    FreePages(Memory, Size, (page_kind)Kind);
+                }
+                
+                fprintf(stdout, "    TLB share of hashing cost: ");
+                if(SmallClocks && BestHugeClocks)
+                {
+                    double Share = ((double)SmallClocks - (double)BestHugeClocks) / (double)SmallClocks;
+                    fprintf(stdout, "%0.1f%% (4k pages vs. the fastest huge-page mapping)\n", 100.0*((Share > 0.0) ? Share : 0.0));
+                }
+                else
+                {
+                    fprintf(stdout, "unknown (no mapping got mostly huge pages)\n");
+                }
+            }
+        }
+        CATCH
+        {
+            fprintf(stderr, "    (%s not supported on this CPU)\n", Type.FullName);
+        }
+    }
+    
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+}
+
+//
+// NOTE: Workload replay
+//
+// The size batches sample sizes uniformly within each class, which says little
+// about what a service with a skewed size distribution actually spends.  Replay
+// mode takes the distribution from a file instead, one entry per line ('#' starts
+// a comment, sizes take k/m/g suffixes):
+//
+//   -histogram: <size> <count> [<alignment>]   (counts can be any weights)
+//   -trace:     <size> [<alignment>]           (one line per recorded call)
+//
+// An alignment is the input's offset within a cache line; anything larger (like
+// a recorded address) is taken mod 64.  A trace is replayed in its recorded order.
+// A histogram is replayed as a shuffled sequence with each entry in proportion to
+// its count, but never fewer than REPLAY_MIN_CALLS_PER_ENTRY times, so rare huge
+// sizes are still measured.  The totals are then projected back onto the real
+// counts: the cycles the workload would cost is the sum over entries of count
+// times the mean clocks measured for that entry.
+//
+
+#define REPLAY_HISTOGRAM_CALLS (1 << 20)
+#define REPLAY_MIN_CALLS_PER_ENTRY 16
+#define REPLAY_MAX_CALLS (1 << 24)
+
+struct replay_entry
+{
+    meow_u64 Size;
+    meow_u32 Alignment;
+    double Count;
+    
+    meow_u64 Calls;
+    double Clocks;
+};
+
+struct replay_workload
+{
+    int EntryCount;
+    replay_entry *Entries;
+    
+    meow_u64 CallCount;
+    meow_u32 *Calls;
+};
+
+static int
+CompareReplayEntries(const void *AInit, const void *BInit)
+{
+    replay_entry *A = (replay_entry *)AInit;
+    replay_entry *B = (replay_entry *)BInit;
+    int Result = ((A->Size < B->Size) ? -1 : (A->Size > B->Size) ? 1 :
+                  (A->Alignment < B->Alignment) ? -1 : (A->Alignment > B->Alignment) ? 1 : 0);
+    return(Result);
+}
+
+static int
+FindReplayEntry(replay_workload *Workload, meow_u64 Size, meow_u32 Alignment)
+{
+    int Low = 0;
+    int High = Workload->EntryCount;
+    while(Low < High)
+    {
+        int Mid = (Low + High) / 2;
+        replay_entry *Entry = Workload->Entries + Mid;
+        if((Entry->Size < Size) || ((Entry->Size == Size) && (Entry->Alignment < Alignment)))
+        {
+            Low = Mid + 1;
+        }
+        else
+        {
+            High = Mid;
+        }
+    }
+    
+    return(Low);
+}
+
+static int
+LoadReplayWorkload(char *FileName, int IsTrace, replay_workload *Workload)
+{
+    int Result = 0;
+    
+    memset(Workload, 0, sizeof(*Workload));
+    FILE *Source = fopen(FileName, "r");
+    if(Source)
+    {
+        // NOTE: Read every line as an entry first; a trace also keeps them in order as its calls
+        meow_u64 Max = 1024;
+        replay_entry *Lines = (replay_entry *)malloc(Max*sizeof(replay_entry));
+        meow_u64 LineCount = 0;
+        
+        char Line[256];
+        int LineNumber = 0;
+        Result = 1;
+        while(Result && fgets(Line, sizeof(Line), Source) && (LineCount < REPLAY_MAX_CALLS))
+        {
+            ++LineNumber;
+            char *At = Line;
+            while((*At == ' ') || (*At == '\t'))
+            {
+                ++At;
+            }
+            if((*At == '#') || (*At == '\n') || (*At == '\r') || !*At)
+            {
+                continue;
+            }
+            
+            replay_entry Entry = {};
+            char *End = At;
+            Entry.Size = ParseSize(At, &End);
+            Entry.Count = 1.0;
+            if(!IsTrace)
+            {
+                At = End;
+                Entry.Count = strtod(At, &End);
+            }
+            At = End;
+            Entry.Alignment = (meow_u32)(strtoull(At, &End, 0) % 64);
+            
+            if((End == Line) || (Entry.Size > (MAX_SIZE_TO_TEST - 64)) || !(Entry.Count >= 0.0))
+            {
+                fprintf(stderr, "ERROR: %s(%d): expected %s\n", FileName, LineNumber,
+                        IsTrace ? "<size> [<alignment>]" : "<size> <count> [<alignment>]");
+                Result = 0;
+            }
+            else
+            {
+                if(LineCount == Max)
+                {
+                    Max *= 2;
+                    Lines = (replay_entry *)realloc(Lines, Max*sizeof(replay_entry));
+                }
+                Lines[LineCount++] = Entry;
+            }
+        }
+        
+        if(LineCount == REPLAY_MAX_CALLS)
+        {
+            fprintf(stderr, "    (only replaying the first %u lines of %s)\n", REPLAY_MAX_CALLS, FileName);
+        }
+        
+        if(Result && LineCount)
+        {
+            // NOTE: Merge repeated sizes into one entry each
+            Workload->Entries = (replay_entry *)malloc(LineCount*sizeof(replay_entry));
+            memcpy(Workload->Entries, Lines, LineCount*sizeof(replay_entry));
+            qsort(Workload->Entries, LineCount, sizeof(replay_entry), CompareReplayEntries);
+            int EntryCount = 0;
+            for(meow_u64 Index = 0;
+                Index < LineCount;
+                ++Index)
+            {
+                replay_entry *Entry = Workload->Entries + Index;
+                if(EntryCount && (CompareReplayEntries(Entry, Workload->Entries + EntryCount - 1) == 0))
+                {
+                    Workload->Entries[EntryCount - 1].Count += Entry->Count;
+                }
+                else
+                {
+                    Workload->Entries[EntryCount++] = *Entry;
+                }
+            }
+            Workload->EntryCount = EntryCount;
+            
+            if(IsTrace)
+            {
+                Workload->CallCount = LineCount;
+                Workload->Calls = (meow_u32 *)malloc(LineCount*sizeof(meow_u32));
+                for(meow_u64 Index = 0;
+                    Index < LineCount;
+                    ++Index)
+                {
+                    Workload->Calls[Index] = FindReplayEntry(Workload, Lines[Index].Size, Lines[Index].Alignment);
+                }
+            }
+            else
+            {
+                double TotalCount = 0.0;
+                for(int EntryIndex = 0;
+                    EntryIndex < EntryCount;
+                    ++EntryIndex)
+                {
+                    TotalCount += Workload->Entries[EntryIndex].Count;
+                }
+                
+                meow_u64 *EntryCalls = (meow_u64 *)malloc(EntryCount*sizeof(meow_u64));
+                Workload->CallCount = 0;
+                for(int EntryIndex = 0;
+                    EntryIndex < EntryCount;
+                    ++EntryIndex)
+                {
+                    double Share = TotalCount ? Workload->Entries[EntryIndex].Count / TotalCount : 0.0;
+                    EntryCalls[EntryIndex] = (meow_u64)(Share*REPLAY_HISTOGRAM_CALLS + 0.5);
+                    if(EntryCalls[EntryIndex] < REPLAY_MIN_CALLS_PER_ENTRY)
+                    {
+                        EntryCalls[EntryIndex] = REPLAY_MIN_CALLS_PER_ENTRY;
+                    }
+                    Workload->CallCount += EntryCalls[EntryIndex];
+                }
+                
+                Workload->Calls = (meow_u32 *)malloc(Workload->CallCount*sizeof(meow_u32));
+                meow_u64 CallIndex = 0;
+                for(int EntryIndex = 0;
+                    EntryIndex < EntryCount;
+                    ++EntryIndex)
+                {
+                    for(meow_u64 Repeat = 0;
+                        Repeat < EntryCalls[EntryIndex];
+                        ++Repeat)
+                    {
+                        Workload->Calls[CallIndex++] = EntryIndex;
+                    }
+                }
+                free(EntryCalls);
+                
+                // NOTE: Fisher-Yates, so the branch predictors see the sizes mixed like the real traffic
+                meow_u64 Series = 123456789;
+                for(meow_u64 Index = Workload->CallCount - 1;
+                    Index > 0;
+                    --Index)
+                {
+                    meow_u64 Other = (((meow_u64)Random(&Series) << 32) | Random(&Series)) % (Index + 1);
+                    meow_u32 Temp = Workload->Calls[Index];
+                    Workload->Calls[Index] = Workload->Calls[Other];
+                    Workload->Calls[Other] = Temp;
+                }
+            }
+        }
+        else if(Result)
+        {
+            fprintf(stderr, "ERROR: %s has no sizes in it\n", FileName);
+            Result = 0;
+        }
+        
+        free(Lines);
+        fclose(Source);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s\n", FileName);
+    }
+    
+    return(Result);
+}
+
+static void
+FreeReplayWorkload(replay_workload *Workload)
+{
+    free(Workload->Entries);
+    free(Workload->Calls);
+}
+
+static void
+RunReplay(replay_workload *Workload, int *HashIsSelected, char *CSVFileName)
+{
+    meow_u64 MaxSize = 0;
+    double WorkloadCalls = 0.0, WorkloadBytes = 0.0;
+    for(int EntryIndex = 0;
+        EntryIndex < Workload->EntryCount;
+        ++EntryIndex)
+    {
+        replay_entry *Entry = Workload->Entries + EntryIndex;
+        if(MaxSize < Entry->Size)
+        {
+            MaxSize = Entry->Size;
+        }
+        WorkloadCalls += Entry->Count;
+        WorkloadBytes += Entry->Count*(double)Entry->Size;
+    }
+    
+    fprintf(stdout, "Workload: %d distinct sizes, %.0f calls, ", Workload->EntryCount, WorkloadCalls);
+    PrintSize(stdout, WorkloadBytes, false);
+    fprintf(stdout, " (%.0f calls per replay)\n", (double)Workload->CallCount);
+    
+    meow_u64 BufferSize = MaxSize + 64;
+    void *Buffer = aligned_alloc(CACHE_LINE_ALIGNMENT, (BufferSize + CACHE_LINE_ALIGNMENT - 1) & ~(meow_u64)(CACHE_LINE_ALIGNMENT - 1));
+    if(!Buffer)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate buffer for hashing\n");
+        return;
+    }
+    FuddleBuffer(BufferSize, Buffer, 1);
+    
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Hash,Size,Alignment,Count,Calls replayed,Mean clocks\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    // NOTE: Where the cycles go, by size band
+    meow_u64 BandLimits[] = {64, Kb(1), Kb(16), Kb(256), Mb(4), (meow_u64)-1};
+    char const *BandNames[] = {"< 64b", "64b - 1kb", "1kb - 16kb", "16kb - 256kb", "256kb - 4mb", ">= 4mb"};
+    
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    for(int unsigned TypeIndex = 0;
+        TypeIndex < TypeCount;
+        ++TypeIndex)
+    {
+        if(!HashIsSelected[TypeIndex])
+        {
+            continue;
+        }
+        
+        named_hash_type Type = NamedHashTypes[TypeIndex];
+        fprintf(stdout, "\n%s:\n", Type.FullName);
+        
+        meow_hash_implementation *volatile Imp = Type.Imp;
+        
+        TRY
+        {
+            for(int EntryIndex = 0;
+                EntryIndex < Workload->EntryCount;
+                ++EntryIndex)
+            {
+                Workload->Entries[EntryIndex].Calls = 0;
+                Workload->Entries[EntryIndex].Clocks = 0.0;
+            }
+            
+            meow_u64 ReplayClocks = 0;
+            double ReplayBytes = 0.0;
+            for(meow_u64 CallIndex = 0;
+                CallIndex < Workload->CallCount;
+                ++CallIndex)
+            {
+                replay_entry *Entry = Workload->Entries + Workload->Calls[CallIndex];
+                meow_u64 Clocks = TimeHashCall(Imp, Entry->Size, (meow_u8 *)Buffer + Entry->Alignment);
+                
+                Entry->Calls += 1;
+                Entry->Clocks += (double)Clocks;
+                ReplayClocks += Clocks;
+                ReplayBytes += (double)Entry->Size;
+            }
+            
+            double BandCalls[ArrayCount(BandLimits)] = {};
+            double BandBytes[ArrayCount(BandLimits)] = {};
+            double BandClocks[ArrayCount(BandLimits)] = {};
+            double WorkloadClocks = 0.0;
+            for(int EntryIndex = 0;
+                EntryIndex < Workload->EntryCount;
+                ++EntryIndex)
+            {
+                replay_entry *Entry = Workload->Entries + EntryIndex;
+                double MeanClocks = Entry->Calls ? Entry->Clocks / (double)Entry->Calls : 0.0;
+                double Clocks = Entry->Count*MeanClocks;
+                WorkloadClocks += Clocks;
+                
+                int Band = 0;
+                while(Entry->Size >= BandLimits[Band])
+                {
+                    ++Band;
+                }
+                BandCalls[Band] += Entry->Count;
+                BandBytes[Band] += Entry->Count*(double)Entry->Size;
+                BandClocks[Band] += Clocks;
+                
+                if(CSV)
+                {
+                    fprintf(CSV, "%s,%.0f,%u,%f,%.0f,%f\n", Type.FullName, (double)Entry->Size, Entry->Alignment,
+                            Entry->Count, (double)Entry->Calls, MeanClocks);
+                }
+            }
+            
+            fprintf(stdout, "    Replay: %.0f calls, %.0f clocks, %0.03f bytes/cycle, %0.1f clocks/call\n",
+                    (double)Workload->CallCount, (double)ReplayClocks,
+                    ReplayClocks ? ReplayBytes / (double)ReplayClocks : 0.0,
+                    (double)ReplayClocks / (double)Workload->CallCount);
+            fprintf(stdout, "    Workload: %.0f clocks, %0.03f bytes/cycle weighted, %0.1f clocks/call\n",
+                    WorkloadClocks, WorkloadClocks ? WorkloadBytes / WorkloadClocks : 0.0,
+                    WorkloadCalls ? WorkloadClocks / WorkloadCalls : 0.0);
+            fprintf(stdout, "    %-14s %8s %8s %8s\n", "Sizes", "calls", "bytes", "clocks");
+            for(int Band = 0;
+                Band < ArrayCount(BandLimits);
+                ++Band)
+            {
+                if(BandCalls[Band] > 0.0)
+                {
+                    fprintf(stdout, "    %-14s %7.1f%% %7.1f%% %7.1f%%\n", BandNames[Band],
+                            WorkloadCalls ? 100.0*BandCalls[Band] / WorkloadCalls : 0.0,
+                            WorkloadBytes ? 100.0*BandBytes[Band] / WorkloadBytes : 0.0,
+                            WorkloadClocks ? 100.0*BandClocks[Band] / WorkloadClocks : 0.0);
+                }
+            }
+            fflush(stdout);
+        }
+        CATCH
+        {
+            fprintf(stderr, "    (%s not supported on this CPU)\n", Type.FullName);
+        }
+    }
+    
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+    free(Buffer);
+}
+
+//
+// NOTE: Scaling mode
+//
+// The single-threaded sweep above can't see what limits a machine running many
+// hashing threads at once: memory bandwidth, AVX frequency licensing, and SMT
+// siblings sharing AES units.  Scaling mode runs each hash on 1..N threads, each
+// pinned to its own processor (in the order the OS enumerates them, so SMT
+// siblings come in wherever the OS numbers them), either on a private buffer per
+// thread or all on one shared buffer.  Buffers default to larger than a typical
+// last-level cache, so the private case is what shows memory bandwidth running out.
+//
+
+#define SCALE_DEFAULT_BUFFER_SIZE Mb(32)
+#define SCALE_SECONDS_PER_POINT 0.5
+#define SCALE_KNEE_FRACTION 0.9
+
+struct scale_thread
+{
+    meow_thread Thread;
+    named_hash_type Type;
+    int ThreadIndex;
+    int Processor;
+    
+    void *Buffer;
+    meow_u64 Size;
+    int OwnsBuffer;
+    
+    volatile meow_u32 *ReadyCount;
+    volatile meow_u32 *Go;
+    volatile meow_u32 *Stop;
+    
+    meow_u64 Bytes;
+    meow_u64 Clocks;
+    meow_u128 FakeSlot;
+};
+
+struct scale_point
+{
+    int ThreadCount;
+    double GBPerSecond;
+    double BPCPerThread;
+};
+
+static void
+ScaleThreadProc(void *Param)
+{
+    scale_thread *Thread = (scale_thread *)Param;
+    Thread->Processor = PinCurrentThread(Thread->ThreadIndex);
+    
+    // NOTE: Private buffers are allocated by the thread that will hash them, once it
+    // is pinned, and bound to its NUMA node, so no thread ever hashes remote memory.
+    if(Thread->OwnsBuffer)
+    {
+        Thread->Buffer = NUMAAlloc(Thread->Size, GetCurrentNUMANode());
+        if(Thread->Buffer)
+        {
+            FuddleBuffer(Thread->Size, Thread->Buffer, Thread->ThreadIndex);
+        }
+    }
+    
+    AtomicIncrement(Thread->ReadyCount);
+    while(!AtomicLoad(Thread->Go))
+    {
+    }
+    
+    meow_u64 Bytes = 0;
+    meow_u128 FakeSlot = {};
+    meow_u64 StartClock = __rdtsc();
+    while(Thread->Buffer && !AtomicLoad(Thread->Stop))
+    {
+        FakeSlot = Thread->Type.Imp(MeowDefaultSeed, Thread->Size, Thread->Buffer);
+        Bytes += Thread->Size;
+    }
+    meow_u64 EndClock = __rdtsc();
+    
+    Thread->FakeSlot = FakeSlot;
+    Thread->Bytes = Bytes;
+    Thread->Clocks = EndClock - StartClock;
+}
+
+static int
+RunScalePoint(named_hash_type Type, int ThreadCount, int Shared, void *SharedBuffer,
+              meow_u64 Size, scale_thread *Threads, scale_point *Point)
+{
+    int Result = 1;
+    
+    volatile meow_u32 ReadyCount = 0;
+    volatile meow_u32 Go = 0;
+    volatile meow_u32 Stop = 0;
+    
+    int StartedCount = 0;
+    for(int ThreadIndex = 0;
+        ThreadIndex < ThreadCount;
+        ++ThreadIndex)
+    {
+        scale_thread *Thread = Threads + ThreadIndex;
+        Thread->Type = Type;
+        Thread->ThreadIndex = ThreadIndex;
+        Thread->Size = Size;
+        Thread->OwnsBuffer = !Shared;
+        Thread->Buffer = Shared ? SharedBuffer : 0;
+        Thread->ReadyCount = &ReadyCount;
+        Thread->Go = &Go;
+        Thread->Stop = &Stop;
+        Thread->Bytes = 0;
+        Thread->Clocks = 0;
+        
+        if(StartThread(&Thread->Thread, ScaleThreadProc, Thread))
+        {
+            ++StartedCount;
+        }
+        else
+        {
+            Result = 0;
+            break;
+        }
+    }
+    
+    // NOTE: If any thread failed to start, the rest are released immediately
+    if(Result)
+    {
+        while(AtomicLoad(&ReadyCount) != (meow_u32)ThreadCount)
+        {
+        }
+    }
+    else
+    {
+        AtomicStore(&Stop, 1);
+    }
+    
+    double StartTime = GetWallClock();
+    AtomicStore(&Go, 1);
+    if(Result)
+    {
+        SleepSeconds(SCALE_SECONDS_PER_POINT);
+    }
+    AtomicStore(&Stop, 1);
+    
+    for(int ThreadIndex = 0;
+        ThreadIndex < StartedCount;
+        ++ThreadIndex)
+    {
+        JoinThread(Threads[ThreadIndex].Thread);
+    }
+    double Seconds = GetWallClock() - StartTime;
+    
+    for(int ThreadIndex = 0;
+        ThreadIndex < StartedCount;
+        ++ThreadIndex)
+    {
+        if(!Threads[ThreadIndex].Buffer)
+        {
+            fprintf(stderr, "ERROR: Unable to allocate a buffer for thread %d\n", ThreadIndex);
+            Result = 0;
+        }
+    }
+    
+    double TotalBytes = 0;
+    double TotalBPC = 0;
+    for(int ThreadIndex = 0;
+        ThreadIndex < ThreadCount;
+        ++ThreadIndex)
+    {
+        scale_thread *Thread = Threads + ThreadIndex;
+        TotalBytes += (double)Thread->Bytes;
+        if(Thread->Clocks)
+        {
+            TotalBPC += (double)Thread->Bytes / (double)Thread->Clocks;
+        }
+        if(!Shared && (ThreadIndex < StartedCount))
+        {
+            NUMAFree(Thread->Buffer, Thread->Size);
+        }
+        Thread->Buffer = 0;
+    }
+    
+    Point->ThreadCount = ThreadCount;
+    Point->GBPerSecond = TotalBytes / Seconds / (double)Gb(1);
+    Point->BPCPerThread = TotalBPC / (double)ThreadCount;
+    
+    return(Result);
+}
+
+static int
+FindScaleKnee(scale_point *Points, int PointCount)
+{
+    // NOTE: The knee is the first thread count that gets within SCALE_KNEE_FRACTION
+    // of the best aggregate throughput; adding threads past it buys little.
+    double Peak = 0;
+    for(int PointIndex = 0;
+        PointIndex < PointCount;
+        ++PointIndex)
+    {
+        if(Peak < Points[PointIndex].GBPerSecond)
+        {
+            Peak = Points[PointIndex].GBPerSecond;
+        }
+    }
+    
+    int Result = 0;
+    for(int PointIndex = 0;
+        PointIndex < PointCount;
+        ++PointIndex)
+    {
+        if(Points[PointIndex].GBPerSecond >= SCALE_KNEE_FRACTION*Peak)
+        {
+            Result = PointIndex;
+            break;
+        }
+    }
+    
+    return(Result);
+}
+
+static void
+RunScaling(int MaxThreadCount, meow_u64 Size, char *CSVFileName)
+{
+    fprintf(stdout, "Scaling: 1..%d threads, ", MaxThreadCount);
+    PrintSize(stdout, (double)Size, false);
+    fprintf(stdout, " per buffer, %0.1fs per point\n", SCALE_SECONDS_PER_POINT);
+    
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Hash,Buffers,Threads,GB/s,Bytes/cycle per thread\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    // NOTE: aligned_alloc wants a size that's a multiple of the alignment
+    meow_u64 SharedSize = (Size + CACHE_LINE_ALIGNMENT - 1) & ~(meow_u64)(CACHE_LINE_ALIGNMENT - 1);
+    meow_u64 ThreadsSize = (MaxThreadCount*sizeof(scale_thread) + 15) & ~(meow_u64)15;
+    scale_thread *Threads = (scale_thread *)aligned_alloc(16, ThreadsSize);
+    scale_point *Points = (scale_point *)malloc(MaxThreadCount*sizeof(scale_point));
+    void *SharedBuffer = aligned_alloc(CACHE_LINE_ALIGNMENT, SharedSize ? SharedSize : CACHE_LINE_ALIGNMENT);
+    if(Threads && Points && SharedBuffer)
+    {
+        memset(Threads, 0, ThreadsSize);
+        FuddleBuffer(Size, SharedBuffer, 0);
+        
+        // NOTE: Only known once some point has actually run threads
+        int RanAnyPoint = 0;
+        int Unpinned = 0;
+        
+        int unsigned TypeCount = ArrayCount(NamedHashTypes);
+        for(int unsigned TypeIndex = 0;
+            TypeIndex < TypeCount;
+            ++TypeIndex)
+        {
+            named_hash_type Type = NamedHashTypes[TypeIndex];
+            fprintf(stdout, "\n%s:\n", Type.FullName);
+            
+            // NOTE: Threads can't report an unsupported instruction, so check up front
+            int Supported = 1;
+            TRY
+            {
+                Threads[0].FakeSlot = Type.Imp(MeowDefaultSeed, 64, SharedBuffer);
+            }
+            CATCH
+            {
+                fprintf(stderr, "    (%s not supported on this CPU)\n", Type.FullName);
+                Supported = 0;
+            }
+            
+            for(int Shared = 0;
+                Supported && (Shared <= 1);
+                ++Shared)
+            {
+                char const *BufferName = Shared ? "shared" : "private";
+                fprintf(stdout, "  %s buffers:\n", BufferName);
+                
+                int PointCount = 0;
+                for(int ThreadCount = 1;
+                    ThreadCount <= MaxThreadCount;
+                    ++ThreadCount)
+                {
+                    scale_point *Point = Points + PointCount;
+                    if(RunScalePoint(Type, ThreadCount, Shared, SharedBuffer, Size, Threads, Point))
+                    {
+                        ++PointCount;
+                        RanAnyPoint = 1;
+                        if(Threads[0].Processor < 0)
+                        {
+                            Unpinned = 1;
+                        }
+                        
+                        double Efficiency = Point->GBPerSecond / (ThreadCount*Points[0].GBPerSecond);
+                        fprintf(stdout, "    %3d threads: %8.2f GB/s (%6.03f bytes/cycle per thread, %3.0f%% scaling)\n",
+                                ThreadCount, Point->GBPerSecond, Point->BPCPerThread, 100.0*Efficiency);
+                        fflush(stdout);
+                        
+                        if(CSV)
+                        {
+                            fprintf(CSV, "%s,%s,%d,%f,%f\n", Type.FullName, BufferName,
+                                    ThreadCount, Point->GBPerSecond, Point->BPCPerThread);
+                        }
+                    }
+                    else
+                    {
+                        fprintf(stderr, "ERROR: Unable to start %d threads\n", ThreadCount);
+                        break;
+                    }
+                }
+                
+                if(PointCount)
+                {
+                    scale_point *Knee = Points + FindScaleKnee(Points, PointCount);
+                    fprintf(stdout, "    Knee: %d threads (%0.2f GB/s, the first to reach %0.0f%% of peak)\n",
+                            Knee->ThreadCount, Knee->GBPerSecond, 100.0*SCALE_KNEE_FRACTION);
+                }
+            }
+        }
+        
+        if(!RanAnyPoint)
+        {
+            fprintf(stderr, "\nERROR: No hash type could be run for scaling on this CPU\n");
+        }
+        else if(Unpinned)
+        {
+            fprintf(stdout, "\nWARNING: Threads could not be pinned on this OS, so results may be noisy\n");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate buffers for scaling\n");
+    }
+    
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+    free(SharedBuffer);
+    free(Points);
+    free(Threads);
+}
+
+//
+// NOTE: Hash-table workload
+//
+// Hashing one buffer over and over says little about a hash used to index a
+// table, where keys are short, lookups often depend on the one before, and the
+// quality of the output decides how far each probe has to walk.  Table mode
+// builds a flat open-addressed table (linear probing, power-of-two size, each
+// slot holding the truncated hash and a key index) over millions of keys of a
+// few realistic kinds, then times inserts, independent hits, dependent hits
+// (each key found decides the next one looked up, so nothing overlaps) and
+// misses.  Every hash runs with its output truncated to 64 and to 32 bits; the
+// table index comes from the low bits either way, and the stored hash is
+// checked before the key is compared, so a narrow truncation shows up as
+// "false matches" - stored hashes that match a different key.
+//
+
+#define TABLE_DEFAULT_KEY_COUNT 2000000
+#define TABLE_MAX_LOAD 0.7
+
+struct key_set
+{
+    char const *Name;
+    meow_u64 Count;
+    meow_u64 *Offsets;
+    meow_u32 *Lengths;
+    meow_u8 *Data;
+    meow_u64 DataSize;
+    meow_u64 DataMax;
+};
+
+struct table_slot
+{
+    meow_u64 Hash;
+    
+    // NOTE: One more than the key's index in the key set, so zero is an empty slot
+    meow_u32 Key;
+    meow_u32 Pad;
+};
+
+struct hash_table
+{
+    table_slot *Slots;
+    meow_u64 Mask;
+    
+    named_hash_type Type;
+    int Bits;
+    key_set *Keys;
+    
+    meow_u64 ProbeCount;
+    meow_u64 MaxProbes;
+    meow_u64 FalseMatchCount;
+};
+
+static void
+PushKey(key_set *Set, void const *Key, meow_u32 Len)
+{
+    if((Set->DataSize + Len) > Set->DataMax)
+    {
+        Set->DataMax = 2*(Set->DataSize + Len);
+        Set->Data = (meow_u8 *)realloc(Set->Data, Set->DataMax);
+    }
+    
+    Set->Offsets[Set->Count] = Set->DataSize;
+    Set->Lengths[Set->Count] = Len;
+    memcpy(Set->Data + Set->DataSize, Key, Len);
+    Set->DataSize += Len;
+    ++Set->Count;
+}
+
+// NOTE: A bijection on 64-bit values (the splitmix64 finalizer), so distinct indices make distinct keys
+static meow_u64
+MixKeyIndex(meow_u64 Value)
+{
+    Value ^= Value >> 30;
+    Value *= 0xbf58476d1ce4e5b9ULL;
+    Value ^= Value >> 27;
+    Value *= 0x94d049bb133111ebULL;
+    Value ^= Value >> 31;
+    return(Value);
+}
+
+// NOTE: A bijection on [0, 2^Bits), for shuffling small indices without repeats
+static meow_u64
+PermuteKeyIndex(meow_u64 Value, int Bits)
+{
+    meow_u64 Mask = (Bits < 64) ? ((1ULL << Bits) - 1) : ~0ULL;
+    Value = (Value*0x9e3779b97f4a7c15ULL) & Mask;
+    Value ^= Value >> ((Bits + 1) / 2);
+    Value = (Value*0xbf58476d1ce4e5b9ULL) & Mask;
+    return(Value);
+}
+
+// NOTE: Spells Index in bijective base-64 syllables, so every index gets a different word
+static int
+MakeWord(meow_u64 Index, char *Dest)
+{
+    static char const Consonants[] = "bcdfghklmnprstvz";
+    static char const Vowels[] = "aeio";
+    
+    int Len = 0;
+    meow_u64 Value = Index + 1;
+    while(Value)
+    {
+        --Value;
+        int Syllable = (int)(Value % 64);
+        Dest[Len++] = Consonants[Syllable >> 2];
+        Dest[Len++] = Vowels[Syllable & 3];
+        Value /= 64;
+    }
+    
+    return(Len);
+}
+
+static int
+LoadWordKeys(char *FileName, key_set *Set, meow_u64 MaxCount)
+{
+    int Result = 0;
+    
+    FILE *File = fopen(FileName, "r");
+    if(File)
+    {
+        char Line[1024];
+        while((Set->Count < MaxCount) && fgets(Line, sizeof(Line), File))
+        {
+            meow_u32 Len = (meow_u32)strlen(Line);
+            while(Len && ((Line[Len - 1] == '\n') || (Line[Len - 1] == '\r')))
+            {
+                --Len;
+            }
+            if(Len)
+            {
+                PushKey(Set, Line, Len);
+            }
+        }
+        fclose(File);
+        
+        Result = (Set->Count >= 2);
+    }
+    
+    return(Result);
+}
+
+enum key_kind
+{
+    KeyKind_Words,
+    KeyKind_UUIDs,
+    KeyKind_Integers,
+    KeyKind_URLs,
+    
+    KeyKind_Count,
+};
+
+static char const *KeyKindNames[] = {"words", "uuids", "integers", "urls"};
+
+// NOTE: Makes Count keys of the given kind, all different.  The first half get
+// inserted and the second half are the misses, so a word list is shuffled first.
+static void
+MakeKeySet(key_set *Set, int Kind, meow_u64 Count, char *WordFileName)
+{
+    memset(Set, 0, sizeof(*Set));
+    Set->Name = KeyKindNames[Kind];
+    Set->Offsets = (meow_u64 *)malloc(Count*sizeof(meow_u64));
+    Set->Lengths = (meow_u32 *)malloc(Count*sizeof(meow_u32));
+    
+    if((Kind == KeyKind_Words) && WordFileName)
+    {
+        if(LoadWordKeys(WordFileName, Set, Count))
+        {
+            meow_u64 Series = 1234567;
+            for(meow_u64 Index = Set->Count - 1;
+                Index > 0;
+                --Index)
+            {
+                meow_u64 Other = (((meow_u64)Random(&Series) << 32) | Random(&Series)) % (Index + 1);
+                meow_u64 Offset = Set->Offsets[Index];
+                meow_u32 Length = Set->Lengths[Index];
+                Set->Offsets[Index] = Set->Offsets[Other];
+                Set->Lengths[Index] = Set->Lengths[Other];
+                Set->Offsets[Other] = Offset;
+                Set->Lengths[Other] = Length;
+            }
+            return;
+        }
+        
+        fprintf(stderr, "    (unable to read words from %s, using made-up words)\n", WordFileName);
+        Set->Count = 0;
+        Set->DataSize = 0;
+    }
+    
+    int IndexBits = 1;
+    while((1ULL << IndexBits) < Count)
+    {
+        ++IndexBits;
+    }
+    
+    for(meow_u64 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        meow_u64 Mixed = MixKeyIndex(Index);
+        char Key[256];
+        int Len = 0;
+        switch(Kind)
+        {
+            case KeyKind_Words:
+            {
+                // NOTE: Short words, like a dictionary's, in no particular order
+                Len = MakeWord(PermuteKeyIndex(Index, IndexBits), Key);
+            } break;
+            
+            case KeyKind_UUIDs:
+            {
+                meow_u64 High = Mixed;
+                meow_u64 Low = MixKeyIndex(Mixed ^ 0x5555555555555555ULL);
+                High = (High & ~0xf000ULL) | 0x4000ULL;
+                Low = (Low & ~(3ULL << 62)) | (2ULL << 62);
+                Len = sprintf(Key, "%08x-%04x-%04x-%04x-%012llx",
+                              (meow_u32)(High >> 32), (meow_u32)(High >> 16) & 0xffff, (meow_u32)High & 0xffff,
+                              (meow_u32)(Low >> 48), (unsigned long long)(Low & 0xffffffffffffULL));
+            } break;
+            
+            case KeyKind_Integers:
+            {
+                memcpy(Key, &Mixed, sizeof(Mixed));
+                Len = sizeof(Mixed);
+            } break;
+            
+            case KeyKind_URLs:
+            {
+                char Host[32], Section[32];
+                int HostLen = MakeWord(Mixed % 4096, Host);
+                int SectionLen = MakeWord((Mixed >> 12) % 256, Section);
+                Len = sprintf(Key, "https://www.%.*s.com/%.*s/item?id=%llu",
+                              HostLen, Host, SectionLen, Section, (unsigned long long)Index);
+            } break;
+        }
+        
+        PushKey(Set, Key, (meow_u32)Len);
+    }
+}
+
+static void
+FreeKeySet(key_set *Set)
+{
+    free(Set->Offsets);
+    free(Set->Lengths);
+    free(Set->Data);
+}
+
+static meow_u64
+HashTableKey(hash_table *Table, meow_u64 KeyIndex)
+{
+    meow_u128 Hash = Table->Type.Imp(MeowDefaultSeed, Table->Keys->Lengths[KeyIndex],
+                                     Table->Keys->Data + Table->Keys->Offsets[KeyIndex]);
+    meow_u64 Result = (Table->Bits == 32) ? (meow_u64)MeowU32From(Hash, 0) : (meow_u64)MeowU64From(Hash, 0);
+    return(Result);
+}
+
+static int
+TableKeysAreEqual(key_set *Keys, meow_u64 A, meow_u64 B)
+{
+    int Result = ((Keys->Lengths[A] == Keys->Lengths[B]) &&
+                  (memcmp(Keys->Data + Keys->Offsets[A], Keys->Data + Keys->Offsets[B], Keys->Lengths[A]) == 0));
+    return(Result);
+}
+
+// NOTE: Returns the slot holding the key (or where it would go), counting probes and false matches
+static table_slot *
+FindTableSlot(hash_table *Table, meow_u64 KeyIndex, meow_u64 Hash)
+{
+    meow_u64 SlotIndex = Hash & Table->Mask;
+    meow_u64 Probes = 1;
+    table_slot *Result = Table->Slots + SlotIndex;
+    while(Result->Key)
+    {
+        if(Result->Hash == Hash)
+        {
+            if(TableKeysAreEqual(Table->Keys, Result->Key - 1, KeyIndex))
+            {
+                break;
+            }
+            ++Table->FalseMatchCount;
+        }
+        
+        SlotIndex = (SlotIndex + 1) & Table->Mask;
+        Result = Table->Slots + SlotIndex;
+        ++Probes;
+    }
+    
+    Table->ProbeCount += Probes;
+    if(Table->MaxProbes < Probes)
+    {
+        Table->MaxProbes = Probes;
+    }
+    
+    return(Result);
+}
+
+struct table_phase
+{
+    double NanosecondsPerOp;
+    double ProbesPerOp;
+    meow_u64 MaxProbes;
+    meow_u64 FalseMatchCount;
+    double PerfPerOp[PERF_MAX_EVENTS];
+    
+    double StartTime;
+    perf_sample StartSample;
+};
+
+static void
+BeginTablePhase(hash_table *Table, table_phase *Phase, perf_counters *Perf)
+{
+    Table->ProbeCount = 0;
+    Table->MaxProbes = 0;
+    Table->FalseMatchCount = 0;
+    if(Perf->EventCount)
+    {
+        ReadPerfCounters(Perf, &Phase->StartSample);
+    }
+    Phase->StartTime = GetWallClock();
+}
+
+static void
+EndTablePhase(hash_table *Table, table_phase *Phase, perf_counters *Perf, meow_u64 OpCount)
+{
+    double EndTime = GetWallClock();
+    perf_sample EndSample = {};
+    if(Perf->EventCount)
+    {
+        ReadPerfCounters(Perf, &EndSample);
+    }
+    
+    Phase->NanosecondsPerOp = 1.0e9*(EndTime - Phase->StartTime) / (double)OpCount;
+    Phase->ProbesPerOp = (double)Table->ProbeCount / (double)OpCount;
+    Phase->MaxProbes = Table->MaxProbes;
+    Phase->FalseMatchCount = Table->FalseMatchCount;
+    for(int EventIndex = 0;
+        EventIndex < PERF_MAX_EVENTS;
+        ++EventIndex)
+    {
+        Phase->PerfPerOp[EventIndex] = 0.0;
+        if(EventIndex < Perf->EventCount)
+        {
+            Phase->PerfPerOp[EventIndex] = (double)(EndSample.Values[EventIndex] - Phase->StartSample.Values[EventIndex]) / (double)OpCount;
+        }
+    }
+}
+
+static void
+PrintTablePhase(char const *Name, table_phase *Phase, double IdealProbes, perf_counters *Perf)
+{
+    fprintf(stdout, "    %-14s %8.1f ns/op, %5.2f probes", Name, Phase->NanosecondsPerOp, Phase->ProbesPerOp);
+    if(IdealProbes > 0.0)
+    {
+        fprintf(stdout, " (%4.2f ideal)", IdealProbes);
+    }
+    fprintf(stdout, ", %3.0f max, %.0f false matches", (double)Phase->MaxProbes, (double)Phase->FalseMatchCount);
+    for(int EventIndex = PerfEvent_L1DMisses;
+        EventIndex < Perf->EventCount;
+        ++EventIndex)
+    {
+        if(Perf->Available[EventIndex])
+        {
+            fprintf(stdout, ", %0.2f %s", Phase->PerfPerOp[EventIndex], Perf->Specs[EventIndex].Name);
+        }
+    }
+    fprintf(stdout, "\n");
+}
+
+// NOTE: Where lookup results go, so that they can't be optimized out
+static meow_u64 TableFakeSlot;
+
+static void
+RunTableWorkload(meow_u64 KeyCount, char *WordFileName, int *HashIsSelected, perf_counters *Perf, char *CSVFileName)
+{
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Keys,Hash,Bits,Key count,Load,Phase,ns/op,Probes/op,Ideal probes/op,Max probes,False matches");
+            for(int EventIndex = PerfEvent_L1DMisses;
+                EventIndex < Perf->EventCount;
+                ++EventIndex)
+            {
+                fprintf(CSV, ",%s/op", Perf->Specs[EventIndex].Name);
+            }
+            fprintf(CSV, "\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+    
+    for(int Kind = 0;
+        Kind < KeyKind_Count;
+        ++Kind)
+    {
+        key_set Keys;
+        MakeKeySet(&Keys, Kind, 2*KeyCount, WordFileName);
+        
+        meow_u64 InsertCount = Keys.Count / 2;
+        meow_u64 MissCount = Keys.Count - InsertCount;
+        meow_u64 SlotCount = 1;
+        while(SlotCount < (meow_u64)((double)InsertCount / TABLE_MAX_LOAD))
+        {
+            SlotCount *= 2;
+        }
+        double Load = (double)InsertCount / (double)SlotCount;
+        
+        // NOTE: Knuth's expected probe counts for linear probing with a uniform hash
+        double IdealHit = 0.5*(1.0 + 1.0/(1.0 - Load));
+        double IdealMiss = 0.5*(1.0 + 1.0/((1.0 - Load)*(1.0 - Load)));
+        
+        fprintf(stdout, "\n%s (%s, %.0f inserted + %.0f missing, %.1f bytes on average), %.0f slots, load %.2f:\n",
+                Keys.Name, ((Kind == KeyKind_Words) && WordFileName) ? WordFileName : "generated",
+                (double)InsertCount, (double)MissCount, (double)Keys.DataSize / (double)Keys.Count,
+                (double)SlotCount, Load);
+        
+        // NOTE: Independent hits go in a random order; dependent hits follow one
+        // random cycle through all the inserted keys, so each lookup needs the last
+        meow_u32 *Order = (meow_u32 *)malloc(InsertCount*sizeof(meow_u32));
+        meow_u32 *Chain = (meow_u32 *)malloc(InsertCount*sizeof(meow_u32));
+        meow_u64 Series = 987654321;
+        for(meow_u64 Index = 0;
+            Index < InsertCount;
+            ++Index)
+        {
+            Order[Index] = (meow_u32)Index;
+        }
+        for(meow_u64 Index = InsertCount - 1;
+            Index > 0;
+            --Index)
+        {
+            meow_u64 Other = (((meow_u64)Random(&Series) << 32) | Random(&Series)) % (Index + 1);
+            meow_u32 Temp = Order[Index];
+            Order[Index] = Order[Other];
+            Order[Other] = Temp;
+        }
+        for(meow_u64 Index = 0;
+            Index < InsertCount;
+            ++Index)
+        {
+            Chain[Order[Index]] = Order[(Index + 1) % InsertCount];
+        }
+        
+        table_slot *Slots = (table_slot *)aligned_alloc(CACHE_LINE_ALIGNMENT, SlotCount*sizeof(table_slot));
+        
+        int unsigned TypeCount = ArrayCount(NamedHashTypes);
+        for(int unsigned TypeIndex = 0;
+            Order && Chain && Slots && (TypeIndex < TypeCount);
+            ++TypeIndex)
+        {
+            if(!HashIsSelected[TypeIndex])
+            {
+                continue;
+            }
+            
+            int Bits[] = {64, 32};
+            for(int BitsIndex = 0;
+                BitsIndex < ArrayCount(Bits);
+                ++BitsIndex)
+            {
+                hash_table Table = {};
+                Table.Slots = Slots;
+                Table.Mask = SlotCount - 1;
+                Table.Type = NamedHashTypes[TypeIndex];
+                Table.Bits = Bits[BitsIndex];
+                Table.Keys = &Keys;
+                memset(Slots, 0, SlotCount*sizeof(table_slot));
                 
-                fprintf(Out, "<path class='%s_exp gel' vector-effect='non-scaling-stroke' d='", Type.ShortName);
-                char Char = 'M';
-                char const *Color = CrappyColorTable[TypeIndex%ArrayCount(CrappyColorTable)];
-                for(int ResultIndex = 0;
-                    ResultIndex < Tests->ResultCount;
-                    ++ResultIndex)
+                fprintf(stdout, "  %s, truncated to %d bits:\n", Table.Type.FullName, Table.Bits);
+                
+                TRY
                 {
-                    test_results *Results = Tests->Results + ResultIndex;
-                    if((Results->HashType == TypeIndex) &&
-                       (Results->Size != LastSize))
+                    table_phase Phases[4] = {};
+                    char const *PhaseNames[] = {"insert", "hit", "dependent hit", "miss"};
+                    double IdealProbes[] = {IdealHit, IdealHit, IdealHit, IdealMiss};
+                    
+                    BeginTablePhase(&Table, Phases + 0, Perf);
+                    for(meow_u64 KeyIndex = 0;
+                        KeyIndex < InsertCount;
+                        ++KeyIndex)
                     {
-                        LastSize = Results->Size;
-                        
-                        double SizeCoord = log(1.0f + Results->Size);
-                        double SpeedCoord = (MaxSpeedCoord - Results->ExpBPC);
-                        fprintf(Out, "%c %f %f ", Char, SizeCoord, SpeedCoord);
-                        Char = 'L';
+                        meow_u64 Hash = HashTableKey(&Table, KeyIndex);
+                        table_slot *Slot = FindTableSlot(&Table, KeyIndex, Hash);
+                        Slot->Hash = Hash;
+                        Slot->Key = (meow_u32)(KeyIndex + 1);
                     }
-                }
-                fprintf(Out, "' stroke-width='1' fill='none' stroke='%s' />\n", Color);
-                
-                fprintf(Out, "<path class='%s_min gel' vector-effect='non-scaling-stroke' d='", Type.ShortName);
-                Char = 'M';
-                for(int ResultIndex = 0;
-                    ResultIndex < Tests->ResultCount;
-                    ++ResultIndex)
-                {
-                    test_results *Results = Tests->Results + ResultIndex;
-                    if((Results->HashType == TypeIndex) &&
-                       (Results->Size != LastSize))
+                    EndTablePhase(&Table, Phases + 0, Perf, InsertCount);
+                    
+                    meow_u64 FoundSum = 0;
+                    BeginTablePhase(&Table, Phases + 1, Perf);
+                    for(meow_u64 Index = 0;
+                        Index < InsertCount;
+                        ++Index)
                     {
-                        LastSize = Results->Size;
+                        meow_u64 KeyIndex = Order[Index];
+                        FoundSum += FindTableSlot(&Table, KeyIndex, HashTableKey(&Table, KeyIndex))->Key;
+                    }
+                    EndTablePhase(&Table, Phases + 1, Perf, InsertCount);
+                    
+                    meow_u64 KeyIndex = Order[0];
+                    BeginTablePhase(&Table, Phases + 2, Perf);
+                    for(meow_u64 Index = 0;
+                        Index < InsertCount;
+                        ++Index)
+                    {
+                        table_slot *Slot = FindTableSlot(&Table, KeyIndex, HashTableKey(&Table, KeyIndex));
+                        KeyIndex = Chain[Slot->Key - 1];
+                    }
+                    EndTablePhase(&Table, Phases + 2, Perf, InsertCount);
+                    FoundSum += KeyIndex;
+                    
+                    BeginTablePhase(&Table, Phases + 3, Perf);
+                    for(meow_u64 Index = 0;
+                        Index < MissCount;
+                        ++Index)
+                    {
+                        meow_u64 MissIndex = InsertCount + Index;
+                        FoundSum += FindTableSlot(&Table, MissIndex, HashTableKey(&Table, MissIndex))->Key;
+                    }
+                    EndTablePhase(&Table, Phases + 3, Perf, MissCount);
+                    
+                    // NOTE: Word lists can repeat a word, which then "hits" instead of missing
+                    TableFakeSlot += FoundSum;
+                    
+                    for(int PhaseIndex = 0;
+                        PhaseIndex < ArrayCount(Phases);
+                        ++PhaseIndex)
+                    {
+                        table_phase *Phase = Phases + PhaseIndex;
+                        PrintTablePhase(PhaseNames[PhaseIndex], Phase, IdealProbes[PhaseIndex], Perf);
                         
-                        double SizeCoord = log(1.0f + Results->Size);
-                        double SpeedCoord = (MaxSpeedCoord - Results->MinBPC);
-                        fprintf(Out, "%c %f %f ", Char, SizeCoord, SpeedCoord);
-                        Char = 'L';
+                        if(CSV)
+                        {
+                            fprintf(CSV, "%s,%s,%d,%.0f,%f,%s,%f,%f,%f,%.0f,%.0f", Keys.Name, Table.Type.FullName, Table.Bits,
+                                    (double)InsertCount, Load, PhaseNames[PhaseIndex], Phase->NanosecondsPerOp,
+                                    Phase->ProbesPerOp, IdealProbes[PhaseIndex], (double)Phase->MaxProbes,
+                                    (double)Phase->FalseMatchCount);
+                            for(int EventIndex = PerfEvent_L1DMisses;
+                                EventIndex < Perf->EventCount;
+                                ++EventIndex)
+                            {
+                                fprintf(CSV, ",%f", Phase->PerfPerOp[EventIndex]);
+                            }
+                            fprintf(CSV, "\n");
+                        }
                     }
+                    fflush(stdout);
+                }
+                CATCH
+                {
+                    fprintf(stderr, "    (%s not supported on this CPU)\n", Table.Type.FullName);
                 }
-                fprintf(Out, "' stroke-width='1' fill='none' stroke='%s' />\n", Color);
             }
-            fprintf(Out, "</g>\n");
-            
-            fprintf(Out, "</svg>\n");
         }
         
+        if(!Order || !Chain || !Slots)
         {
-            fprintf(Out, "<div style='font-family:sans-serif;overflow:auto;height:45vh;'>\n");
-            fprintf(Out, "<table style='border-spacing:0;'>\n");
-            
-            // NOTE(casey): Hash names
-            fprintf(Out, "<tr style='text-align:center'>");
-            fprintf(Out, "<td onclick='PickHash(0, 0, 0, %f)' style='padding:.5rem;'></td>", MaxSpeedCoord);
-            for(int TypeIndex = 0;
-                TypeIndex < TypeCount;
-                ++TypeIndex)
-            {
-                char const *Color = CrappyColorTable[TypeIndex%ArrayCount(CrappyColorTable)];
-                named_hash_type Type = NamedHashTypes[TypeIndex];
-                fprintf(Out, "<td colspan=2 style='padding:.5rem;color:%s;'>%s</td>", Color, Type.FullName);
-            }
-            fprintf(Out, "</tr>\n");
+            fprintf(stderr, "ERROR: Unable to allocate a table for %.0f keys\n", (double)InsertCount);
+        }
+        
+        free(Slots);
+        free(Chain);
+        free(Order);
+        FreeKeySet(&Keys);
+    }
+    
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+}
+
+//
+// NOTE: Per-stage timing
+//
+// For small inputs, Meow's fixed cost (the residual load, the length append and
+// the twelve MEOW_SHUFFLE rounds of the mix-down) is most of the call.  Built with
+// -DMEOW_TIME_STAGES=1, the hash stamps the TSC between its stages into a
+// thread-local ring, and -stages hashes each size enough times to fill the ring,
+// then reports the median ticks of each stage, less the cost of a stamp, and what
+// share of the total is the mix-down.  The stamps are fenced, so the stages can't
+// overlap the way they do in the real hash; the shares are right, the total is
+// higher than a normal build's.
+//
+
+#if MEOW_TIME_STAGES
+static char const *MeowStageNames[] =
+{
+    "blocks",
+    "residuals",
+    "lanes",
+    "mix-down",
+};
+
+static meow_u64
+MedianStageCycles(meow_u64 *Values, int Count)
+{
+    qsort(Values, Count, sizeof(meow_u64), CompareSizes);
+    meow_u64 Result = Values[Count / 2];
+    return(Result);
+}
+
+static void
+RunStageTiming(meow_u64 *Sizes, int SizeCount, char *CSVFileName)
+{
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Input size,Blocks,Residuals,Lanes,Mix-down,Total,Mix-down share,Stamp overhead\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+
+    meow_u64 *Values = (meow_u64 *)malloc(MEOW_STAGE_RING_SIZE*sizeof(meow_u64));
+
+    // NOTE: Each stage is bracketed by two stamps, so each one pays for one stamp
+    for(int Index = 0;
+        Index < MEOW_STAGE_RING_SIZE;
+        ++Index)
+    {
+        meow_u64 Start = MeowStageClock();
+        Values[Index] = MeowStageClock() - Start;
+    }
+    meow_u64 Overhead = MedianStageCycles(Values, MEOW_STAGE_RING_SIZE);
+
+    meow_u64 MaxSize = 0;
+    for(int SizeIndex = 0;
+        SizeIndex < SizeCount;
+        ++SizeIndex)
+    {
+        if(MaxSize < Sizes[SizeIndex])
+        {
+            MaxSize = Sizes[SizeIndex];
+        }
+    }
+    meow_u8 *Buffer = (meow_u8 *)aligned_alloc(CACHE_LINE_ALIGNMENT, MaxSize + CACHE_LINE_ALIGNMENT);
+    for(meow_u64 Index = 0;
+        Index < MaxSize;
+        ++Index)
+    {
+        Buffer[Index] = (meow_u8)(Index*2654435761u >> 7);
+    }
 
-            fprintf(Out, "<tr style='background:#888888;color:#ffffff;text-align:center;'>");
-            fprintf(Out, "<td onclick='PickHash(0, 0, 0, %f)'></td>", MaxSpeedCoord);
-            for(int TypeIndex = 0;
-                TypeIndex < TypeCount;
-                ++TypeIndex)
+    fprintf(stdout, "Median TSC ticks per stage of %s (less %llu per stamp):\n", MEOW_HASH_VERSION_NAME, Overhead);
+    fprintf(stdout, "  %10s", "size");
+    for(int Stage = 0;
+        Stage < MeowStage_Count;
+        ++Stage)
+    {
+        fprintf(stdout, " %10s", MeowStageNames[Stage]);
+    }
+    fprintf(stdout, " %10s %15s\n", "total", "mix-down share");
+
+    meow_u64 volatile Sink = 0;
+    for(int SizeIndex = 0;
+        SizeIndex < SizeCount;
+        ++SizeIndex)
+    {
+        meow_u64 Size = Sizes[SizeIndex];
+
+        // NOTE: Fill the ring twice over, so it only holds warm calls at this size
+        for(int Call = 0;
+            Call < 2*MEOW_STAGE_RING_SIZE;
+            ++Call)
+        {
+            meow_u128 Hash = MeowHash(MeowDefaultSeed, Size, Buffer);
+            Sink += MeowU64From(Hash, 0);
+        }
+
+        meow_u64 Median[MeowStage_Count];
+        meow_u64 Total = 0;
+        for(int Stage = 0;
+            Stage < MeowStage_Count;
+            ++Stage)
+        {
+            for(int Index = 0;
+                Index < MEOW_STAGE_RING_SIZE;
+                ++Index)
             {
-                named_hash_type Type = NamedHashTypes[TypeIndex];
-                fprintf(Out, "<td onclick='PickHash(0, \"%s_min\", 0, %f)' style='padding:.5rem'>Fastest</td><td onclick='PickHash(0, \"%s_exp\", 0, %f)' style='padding:.5rem'>Expected</td>", Type.ShortName, MaxSpeedCoord, Type.ShortName, MaxSpeedCoord);
+                Values[Index] = MeowStageRing.Samples[Index].Cycles[Stage];
             }
-            fprintf(Out, "</tr>\n");
 
-            // NOTE(casey): Hash results
-            int RowIndex = 0;
-            int BaseResultIndex = 0;
-            while(BaseResultIndex < Tests->ResultCount)
-            {
-                test_results *BaseResult = Tests->Results + BaseResultIndex;
-                meow_u64 SizeMatch = BaseResult->Size;
-                
-                fprintf(Out, "<tr class='row%.0f' style='background:%s;text-align:center;'>", (double)SizeMatch, (RowIndex % 2) ? "#f7f7f7" : "#e6e6e6");
-                fprintf(Out, "<td onclick='PickHash(\"row%.0f\", 0, %f, %f)' style='padding:.5rem;text-align:right;'>", (double)SizeMatch, log(1.0 + SizeMatch), MaxSpeedCoord);
-                PrintSize(Out, SizeMatch, false);
-                fprintf(Out, "</td>");
-                for(int TypeIndex = 0;
-                    TypeIndex < TypeCount;
-                    ++TypeIndex)
-                {
-                    named_hash_type Type = NamedHashTypes[TypeIndex];
-                    
-                    double Min = 0;
-                    double Exp = 0;
-                    for(int ResultIndex = BaseResultIndex;
-                       ResultIndex < Tests->ResultCount;
-                       ++ResultIndex)
-                    {
-                        test_results *Results = Tests->Results + ResultIndex;
-                        
-                        if(Results->Size != SizeMatch)
-                        {
-                            break;
-                        }
-                        
-                        if(Results->HashType == TypeIndex)
-                        {
-                            Min = Results->MinBPC;
-                            Exp = Results->ExpBPC;
-                        }
-                    }
-                    
-                    fprintf(Out, "<td onclick='PickHash(\"row%.0f\", \"%s_min\", %f, %f)' class='%s_min' style='padding:.5rem;'>%f</td><td onclick='PickHash(\"row%.0f\", \"%s_exp\", %f, %f)' class='%s_exp' style='padding:.5rem;'>%f</td>",
-                            (double)SizeMatch, Type.ShortName, log(1.0 + SizeMatch), (MaxSpeedCoord - Min),
-                            Type.ShortName, Min,
-                            (double)SizeMatch, Type.ShortName, log(1.0 + SizeMatch), (MaxSpeedCoord - Exp),
-                            Type.ShortName, Exp);
-                }
+            meow_u64 Cycles = MedianStageCycles(Values, MEOW_STAGE_RING_SIZE);
+            Median[Stage] = (Cycles > Overhead) ? (Cycles - Overhead) : 0;
+            Total += Median[Stage];
+        }
+        double Share = Total ? ((double)Median[MeowStage_MixDown] / (double)Total) : 0.0;
 
-                while(BaseResultIndex < Tests->ResultCount)
+        fprintf(stdout, "  ");
+        PrintSize(stdout, (double)Size, true);
+        for(int Stage = 0;
+            Stage < MeowStage_Count;
+            ++Stage)
+        {
+            fprintf(stdout, " %10llu", Median[Stage]);
+        }
+        fprintf(stdout, " %10llu %14.1f%%\n", Total, 100.0*Share);
+
+        if(CSV)
+        {
+            fprintf(CSV, "%llu,%llu,%llu,%llu,%llu,%llu,%f,%llu\n", Size,
+                    Median[MeowStage_Blocks], Median[MeowStage_Residuals], Median[MeowStage_Lanes],
+                    Median[MeowStage_MixDown], Total, Share, Overhead);
+        }
+    }
+
+    free(Buffer);
+    free(Values);
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+}
+#endif
+
+int
+main(int ArgCount, char **Args)
+{
+#if __aarch64__
+    enable_pmu(0x008);
+#endif
+    
+    InitializeHashesThatNeedInitializers();
+    
+    int ScaleMode = 0;
+    int ScaleThreadCount = GetProcessorCount();
+    meow_u64 ScaleSize = SCALE_DEFAULT_BUFFER_SIZE;
+    int UsePerf = 1;
+    char *PerfRawEvents = 0;
+    int CacheMode = CacheMode_Warm;
+    meow_u64 WorkingSetSize = 0;
+    int WorkingSetSweep = 0;
+    int AlignmentSweep = 0;
+    char *CompareBaseName = 0;
+    char *CompareNewName = 0;
+    char *HashList = 0;
+    meow_u64 *SelectedSizes = (meow_u64 *)malloc(MAX_SELECTED_SIZES*sizeof(meow_u64));
+    int SelectedSizeCount = 0;
+    double CellBudgetSeconds = 0.0;
+    double ConvergeTolerance = 0.0;
+    char *ReplayFileName = 0;
+    int ReplayIsTrace = 0;
+    runner Runner = {};
+    int RunnerProcessor = -1;
+    char *NUMAModeName = 0;
+    int PageKind = Pages_Default;
+    int TLBSweep = 0;
+    int UseRoofline = 1;
+    int TableMode = 0;
+    int StageMode = 0;
+    meow_u64 TableKeyCount = TABLE_DEFAULT_KEY_COUNT;
+    char *WordFileName = 0;
+    double NoisePercent = RUNNER_DEFAULT_NOISE_PERCENT;
+    char *OutputBaseName = 0;
+    for(int ArgIndex = 1;
+        ArgIndex < ArgCount;
+        ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if(strcmp(Arg, "-scale") == 0)
+        {
+            ScaleMode = 1;
+        }
+        else if(strcmp(Arg, "-table") == 0)
+        {
+            TableMode = 1;
+        }
+        else if(strcmp(Arg, "-stages") == 0)
+        {
+            StageMode = 1;
+        }
+        else if((strcmp(Arg, "-table-keys") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            TableKeyCount = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-words") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            WordFileName = Args[++ArgIndex];
+        }
+        else if((strcmp(Arg, "-threads") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ScaleThreadCount = atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Arg, "-scale-size") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ScaleSize = Kb(strtoull(Args[++ArgIndex], 0, 10));
+        }
+        else if((strcmp(Arg, "-cache") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            char *ModeName = Args[++ArgIndex];
+            CacheMode = -1;
+            for(int ModeIndex = 0;
+                ModeIndex < ArrayCount(CacheModeNames);
+                ++ModeIndex)
+            {
+                if(strcmp(ModeName, CacheModeNames[ModeIndex]) == 0)
                 {
-                    test_results *Results = Tests->Results + BaseResultIndex;
-                    if(Results->Size != SizeMatch)
-                    {
-                        break;
-                    }
-                    
-                    ++BaseResultIndex;
+                    CacheMode = ModeIndex;
                 }
-
-                fprintf(Out, "</tr>\n");
-                
-                ++RowIndex;
             }
-            
-            fprintf(Out, "</table>\n");
-
-            // onwheel='GraphWheel()' ondrag='GraphDrag()'
-            
-            fprintf(Out, "<script>\n");
-            fprintf(Out, "var Scale = 1.0;\n");
-            fprintf(Out, "var TranslateX = 0.0;\n");
-            fprintf(Out, "var TranslateY = 0.0;\n");
-            fprintf(Out, "var DragAnchorX = 0.0;\n");
-            fprintf(Out, "var DragAnchorY = 0.0;\n");
-            fprintf(Out, "var HighCol = 0;\n");
-            fprintf(Out, "var HighRow = 0;\n");
-            fprintf(Out, "function PickHash(RowID, ColID, x, y)\n");
-            fprintf(Out, "{\n");
-            fprintf(Out, "    if(HighCol) {HighCol.remove();HighCol = 0;}\n");
-            fprintf(Out, "    if(HighRow) {HighRow.remove();HighRow = 0;}\n");
-            fprintf(Out, "    if(ColID)\n");
-            fprintf(Out, "    {\n");
-            fprintf(Out, "        HighCol = document.createElement('style');\n");
-            fprintf(Out, "        document.head.appendChild(HighCol);\n");
-            fprintf(Out, "        HighCol.innerHTML = '.gel {opacity:0.25;} .' + ColID + '{color:#aa0000;stroke-width:3;opacity:1.0;}';\n");
-            fprintf(Out, "    }\n");
-            fprintf(Out, "    if(RowID)\n");
-            fprintf(Out, "    {\n");
-            fprintf(Out, "        HighRow = document.createElement('style');\n");
-            fprintf(Out, "        document.head.appendChild(HighRow);\n");
-            fprintf(Out, "        HighRow.innerHTML = '.' + RowID + '{color:#aa0000;}';\n");
-            fprintf(Out, "    }\n");
-            fprintf(Out, "    SpeedLine = document.getElementById('speed_line');\n");
-            fprintf(Out, "    SpeedLine.setAttribute('y1', '' + y + '');\n");
-            fprintf(Out, "    SpeedLine.setAttribute('y2', '' + y + '');\n");
-            fprintf(Out, "    SizeLine = document.getElementById('size_line');\n");
-            fprintf(Out, "    SizeLine.setAttribute('x1', '' + x + '');\n");
-            fprintf(Out, "    SizeLine.setAttribute('x2', '' + x + '');\n");
-            fprintf(Out, "}\n");
-            fprintf(Out, "function GraphWheel(e)\n");
-            fprintf(Out, "{\n");
-            fprintf(Out, "    Scale *= (1.0 - 0.001*e.deltaY);\n");
-            fprintf(Out, "    Graph = document.getElementById('ViewXForm');\n");
-            fprintf(Out, "    Graph.setAttributeNS(null, 'transform', 'scale(' + Scale + ') translate(' + TranslateX + ', ' + TranslateY + ')');\n");
-            fprintf(Out, "}\n");
-            fprintf(Out, "function GraphDrag(e)\n");
-            fprintf(Out, "{\n");
-            fprintf(Out, "    var dX = e.pageX - DragAnchorX;\n");
-            fprintf(Out, "    var dY = e.pageY - DragAnchorY;\n");
-            fprintf(Out, "    DragAnchorX = e.pageX;\n");
-            fprintf(Out, "    DragAnchorY = e.pageY;\n");
-            fprintf(Out, "    if(e.buttons == 1)\n");
-            fprintf(Out, "    {\n");
-            fprintf(Out, "        TranslateX += Scale*0.01*dX;\n");
-            fprintf(Out, "        TranslateY += Scale*0.01*dY;\n");
-            fprintf(Out, "        Graph = document.getElementById('ViewXForm');\n");
-            fprintf(Out, "        Graph.setAttributeNS(null, 'transform', 'scale(' + Scale + ') translate(' + TranslateX + ', ' + TranslateY + ')');\n");
-            fprintf(Out, "    }\n");
-            fprintf(Out, "}\n");
-            fprintf(Out, "function GraphDown(e)\n");
-            fprintf(Out, "{\n");
-            fprintf(Out, "    DragAnchorX = e.pageX;\n");
-            fprintf(Out, "    DragAnchorY = e.pageY;\n");
-            fprintf(Out, "}\n");
-            fprintf(Out, "document.getElementById('Graph').addEventListener('wheel', GraphWheel);\n");
-            fprintf(Out, "document.getElementById('Graph').addEventListener('mousedown', GraphDown);\n");
-            fprintf(Out, "document.getElementById('Graph').addEventListener('mousemove', GraphDrag);\n");
-            fprintf(Out, "</script>\n");
         }
-        
-#if 0
-        meow_u64 LastSize = 0;
-        fprintf(Out, "Input");
-        for(int ResultIndex = 0;
-            ResultIndex < Tests->ResultCount;
-            ++ResultIndex)
+        else if((strcmp(Arg, "-working-set") == 0) && ((ArgIndex + 1) < ArgCount))
         {
-            test_results *Results = Tests->Results + ResultIndex;
-            if(Results->Size != LastSize)
+            WorkingSetSize = Kb(strtoull(Args[++ArgIndex], 0, 10));
+        }
+        else if(strcmp(Arg, "-working-set-sweep") == 0)
+        {
+            WorkingSetSweep = 1;
+        }
+        else if(strcmp(Arg, "-alignment-sweep") == 0)
+        {
+            AlignmentSweep = 1;
+        }
+        else if((strcmp(Arg, "-hash") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            HashList = Args[++ArgIndex];
+        }
+        else if((strcmp(Arg, "-size") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            SelectedSizeCount = ParseSizeList(Args[++ArgIndex], SelectedSizes, MAX_SELECTED_SIZES);
+            if(SelectedSizeCount <= 0)
             {
-                LastSize = Results->Size;
-                fprintf(Out, ",%.0f", (double)LastSize);
+                fprintf(stderr, "ERROR: -size takes a list like 64,100-200:4,1k-1m (at most %s per size)\n",
+                        MAX_SIZE_TO_TEST == Gb(1) ? "1g" : "2g");
+                return(-1);
             }
         }
-        fprintf(Out, "\n");
-        
-        LastSize = 0;
-        for(int TypeIndex = 0;
-            TypeIndex < TypeCount;
-            ++TypeIndex)
+        else if((strcmp(Arg, "-budget") == 0) && ((ArgIndex + 1) < ArgCount))
         {
-            named_hash_type Type = NamedHashTypes[TypeIndex];
-            fprintf(Out, "%s", Type.FullName);
-            for(int ResultIndex = 0;
-                ResultIndex < Tests->ResultCount;
-                ++ResultIndex)
+            CellBudgetSeconds = atof(Args[++ArgIndex]);
+        }
+        else if((strcmp(Arg, "-converge") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ConvergeTolerance = 0.01*atof(Args[++ArgIndex]);
+        }
+        else if(strcmp(Arg, "-isolate") == 0)
+        {
+            Runner.Enabled = 1;
+        }
+        else if((strcmp(Arg, "-pin") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            Runner.Enabled = 1;
+            RunnerProcessor = atoi(Args[++ArgIndex]);
+        }
+        else if(strcmp(Arg, "-fifo") == 0)
+        {
+            Runner.Enabled = 1;
+            Runner.FIFO = 1;
+        }
+        else if((strcmp(Arg, "-numa") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            NUMAModeName = Args[++ArgIndex];
+        }
+        else if((strcmp(Arg, "-pages") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            char *KindName = Args[++ArgIndex];
+            PageKind = -1;
+            for(int KindIndex = 0;
+                KindIndex < Pages_Count;
+                ++KindIndex)
             {
-                test_results *Results = Tests->Results + ResultIndex;
-                if((Results->HashType == TypeIndex) &&
-                   (Results->Size != LastSize))
+                if(strcmp(KindName, PageKindNames[KindIndex]) == 0)
                 {
-                    LastSize = Results->Size;
-                    fprintf(Out, ",%f", Results->ExpBPC);
+                    PageKind = KindIndex;
                 }
             }
-            fprintf(Out, "\n");
         }
-        fprintf(Out, "\n");
-        fprintf(Out, "\n");
-        for(int TypeIndex = 0;
+        else if(strcmp(Arg, "-tlb-sweep") == 0)
+        {
+            TLBSweep = 1;
+        }
+        else if((strcmp(Arg, "-noise") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            NoisePercent = atof(Args[++ArgIndex]);
+        }
+        else if(((strcmp(Arg, "-histogram") == 0) || (strcmp(Arg, "-trace") == 0)) && ((ArgIndex + 1) < ArgCount))
+        {
+            ReplayIsTrace = (strcmp(Arg, "-trace") == 0);
+            ReplayFileName = Args[++ArgIndex];
+        }
+        else if(((strcmp(Arg, "-compare") == 0) || (strcmp(Arg, "--compare") == 0)) && ((ArgIndex + 2) < ArgCount))
+        {
+            CompareBaseName = Args[++ArgIndex];
+            CompareNewName = Args[++ArgIndex];
+        }
+        else if(strcmp(Arg, "-no-perf") == 0)
+        {
+            UsePerf = 0;
+        }
+        else if(strcmp(Arg, "-no-roofline") == 0)
+        {
+            UseRoofline = 0;
+        }
+        else if((strcmp(Arg, "-perf-raw") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            PerfRawEvents = Args[++ArgIndex];
+        }
+        else if((Arg[0] != '-') && !OutputBaseName)
+        {
+            OutputBaseName = Arg;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-scale [-threads <count>] [-scale-size <kb>]] [-no-perf] [-perf-raw <hex>[,<hex>...]] [-no-roofline]\n"
+                    "       [-cache warm|flush|llc|dram [-working-set <kb>]] [-working-set-sweep] [-alignment-sweep]\n"
+                    "       [output base name]\n", Args[0]);
+            fprintf(stderr, "       [-hash <name>[,<name>...]] [-size <list>] [-budget <seconds>] [-converge <percent>]\n"
+                    "       [-histogram <file> | -trace <file>] [-isolate [-pin <processor>] [-fifo] [-noise <percent>]]\n"
+                    "       [-numa local|remote|<node>] [-pages default|4k|thp|2m|1g] [-tlb-sweep]\n"
+                    "       [-table [-table-keys <count>] [-words <file>]] [-stages]\n");
+            fprintf(stderr, "       %s -compare <base>.json <new>.json\n", Args[0]);
+            fprintf(stderr, "    Writes <output base name>.csv, .html and .json if a base name is given\n");
+            fprintf(stderr, "    -scale: measure throughput on 1..count pinned threads (default: every processor)\n");
+            fprintf(stderr, "            with private and shared buffers of the given size (default 32mb)\n");
+            fprintf(stderr, "    -table: insert and look up keys (words, UUIDs, integers, URLs) in a flat hash table\n");
+            fprintf(stderr, "            with each hash truncated to 64 and 32 bits (default %d keys; -words\n", TABLE_DEFAULT_KEY_COUNT);
+            fprintf(stderr, "            takes words one per line instead of making them up)\n");
+            fprintf(stderr, "    -stages: time each stage of Meow at small sizes (or the -size list) and report\n");
+            fprintf(stderr, "             the mix-down's share (needs a build with -DMEOW_TIME_STAGES=1)\n");
+            fprintf(stderr, "    -no-perf: don't read hardware performance counters around each hash call\n");
+            fprintf(stderr, "    -perf-raw: also count these raw, model-specific events (e.g. port utilization)\n");
+            fprintf(stderr, "    -no-roofline: don't time a plain read loop and memcpy at each size to compare\n");
+            fprintf(stderr, "                  the hashes against\n");
+            fprintf(stderr, "    -cache: cache state of each input: warm (just written, the default), flush (clflush'd),\n");
+            fprintf(stderr, "            llc (private caches evicted), or dram (rotating through a working set,\n");
+            fprintf(stderr, "            by default %dx the last-level cache)\n", WORKING_SET_LLC_MULTIPLE);
+            fprintf(stderr, "    -working-set-sweep: hash fixed sizes while growing the working set past the caches\n");
+            fprintf(stderr, "    -alignment-sweep: hash fixed sizes at every start offset in a cache line and every\n");
+            fprintf(stderr, "                      end position in a page\n");
+            fprintf(stderr, "    -hash: only run these hashes (short names, e.g. Meow128)\n");
+            fprintf(stderr, "    -size: only run these sizes: a comma-separated list of sizes (64, 4k, 1m), ranges\n");
+            fprintf(stderr, "           (1k-64k, %d sizes spaced geometrically) and stepped ranges (16-256:16)\n", SIZE_COUNT_PER_BATCH);
+            fprintf(stderr, "    -budget: stop timing a hash at a size after this many seconds\n");
+            fprintf(stderr, "    -converge: stop timing a hash at a size once the 95%% confidence interval\n");
+            fprintf(stderr, "               on its median is within this many percent\n");
+            fprintf(stderr, "    -histogram: replay a size distribution (lines of <size> <count> [<alignment>])\n");
+            fprintf(stderr, "    -trace: replay recorded calls in order (lines of <size> [<alignment>])\n");
+            fprintf(stderr, "    -isolate: pin to one processor, warm up until the core clock settles, and throw away\n");
+            fprintf(stderr, "              timing windows where the clock changed or the thread was switched out\n");
+            fprintf(stderr, "    -pin: the processor to pin to (default: the last one allowed)\n");
+            fprintf(stderr, "    -fifo: also run with SCHED_FIFO real-time priority (needs privileges)\n");
+            fprintf(stderr, "    -noise: mark results unreliable if more than this percent of windows are\n");
+            fprintf(stderr, "            thrown away (default %.0f)\n", RUNNER_DEFAULT_NOISE_PERCENT);
+            fprintf(stderr, "    -numa: bind the buffer to the NUMA node the benchmark runs on, to another node,\n");
+            fprintf(stderr, "           or to a given node (the benchmark is pinned to the processor it starts on)\n");
+            fprintf(stderr, "    -pages: map the buffer with 4kb pages only, transparent huge pages, or reserved\n");
+            fprintf(stderr, "            2mb or 1gb huge pages (see /proc/sys/vm/nr_hugepages)\n");
+            fprintf(stderr, "    -tlb-sweep: hash giant inputs (or the -size list) with every kind of page and\n");
+            fprintf(stderr, "                estimate how much of the cost is TLB misses\n");
+            fprintf(stderr, "    -compare: report sizes that got significantly slower between two .json results\n");
+            fprintf(stderr, "              (exits with 1 if there are any)\n");
+            return(-1);
+        }
+    }
+    
+    if(CompareBaseName)
+    {
+        int Result = CompareResultsFiles(CompareBaseName, CompareNewName);
+        return(Result);
+    }
+    
+    int unsigned TypeCount = ArrayCount(NamedHashTypes);
+    int HashIsSelected[ArrayCount(NamedHashTypes)];
+    for(int unsigned TypeIndex = 0;
+        TypeIndex < TypeCount;
+        ++TypeIndex)
+    {
+        HashIsSelected[TypeIndex] = (HashList == 0);
+    }
+    
+    for(char *Name = HashList ? strtok(HashList, ",") : 0;
+        Name;
+        Name = strtok(0, ","))
+    {
+        int Found = 0;
+        for(int unsigned TypeIndex = 0;
             TypeIndex < TypeCount;
             ++TypeIndex)
         {
-            named_hash_type Type = NamedHashTypes[TypeIndex];
-            fprintf(Out, "%s", Type.FullName);
-            for(int ResultIndex = 0;
-                ResultIndex < Tests->ResultCount;
-                ++ResultIndex)
+            if(strcmp(Name, NamedHashTypes[TypeIndex].ShortName) == 0)
             {
-                test_results *Results = Tests->Results + ResultIndex;
-                if((Results->HashType == TypeIndex) &&
-                   (Results->Size != LastSize))
-                {
-                    LastSize = Results->Size;
-                    fprintf(Out, ",%f", Results->MinBPC);
-                }
+                HashIsSelected[TypeIndex] = 1;
+                Found = 1;
             }
-            fprintf(Out, "\n");
         }
-#endif
-
-        fprintf(Out, "</body></html>\n");
         
-        fclose(Out);
+        if(!Found)
+        {
+            fprintf(stderr, "ERROR: No hash named %s; this benchmark has:", Name);
+            for(int unsigned TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                fprintf(stderr, " %s", NamedHashTypes[TypeIndex].ShortName);
+            }
+            fprintf(stderr, "\n");
+            return(-1);
+        }
     }
-    else
+    
+    Runner.NoiseThreshold = 0.01*NoisePercent;
+    
+    if((CellBudgetSeconds < 0.0) || (ConvergeTolerance < 0.0))
     {
-        fprintf(stderr, "    (unable to open %s for writing)\n",
-                HTMLFileName);
+        fprintf(stderr, "ERROR: -budget and -converge can't be negative\n");
+        return(-1);
+    }
+    
+    if(PageKind < 0)
+    {
+        fprintf(stderr, "ERROR: -pages must be one of default, 4k, thp, 2m or 1g\n");
+        return(-1);
+    }
+    
+    if(CacheMode < 0)
+    {
+        fprintf(stderr, "ERROR: -cache must be one of warm, flush, llc or dram\n");
+        return(-1);
+    }
+    
+#if !MEOW_TIME_STAGES
+    if(StageMode)
+    {
+        fprintf(stderr, "ERROR: -stages needs the stage timers compiled in (./build.sh -DMEOW_TIME_STAGES=1)\n");
+        return(-1);
     }
-}
-
-int
-main(int ArgCount, char **Args)
-{
-#if __aarch64__
-    enable_pmu(0x008);
 #endif
     
-    InitializeHashesThatNeedInitializers();
+    if((TableKeyCount < 1) || (TableKeyCount > 0x7fffffff))
+    {
+        fprintf(stderr, "ERROR: -table-keys must be between 1 and %u\n", 0x7fffffff);
+        return(-1);
+    }
+    
+    if((ScaleThreadCount < 1) || (ScaleSize == 0))
+    {
+        fprintf(stderr, "ERROR: -threads and -scale-size must be positive\n");
+        return(-1);
+    }
     
     char *HTMLFileName = 0;
     char *CSVFileName = 0;
-    if(ArgCount == 2)
+    char *JSONFileName = 0;
+    if(OutputBaseName)
     {
-        size_t AllocSize = strlen(Args[1]) + 16;
+        size_t AllocSize = strlen(OutputBaseName) + 16;
         
         CSVFileName = (char *)aligned_alloc(16, AllocSize);
         HTMLFileName = (char *)aligned_alloc(16, AllocSize);
+        JSONFileName = (char *)aligned_alloc(16, AllocSize);
         
-        sprintf(CSVFileName, "%s.csv", Args[1]);
-        sprintf(HTMLFileName, "%s.html", Args[1]);
+        sprintf(CSVFileName, "%s.csv", OutputBaseName);
+        sprintf(HTMLFileName, "%s.html", OutputBaseName);
+        sprintf(JSONFileName, "%s.json", OutputBaseName);
     }
     
     fprintf(stdout, "\n");
@@ -827,18 +5945,275 @@ main(int ArgCount, char **Args)
     Tests->SizeSeries = 123456789;
     Tests->ResultCount = 0;
     
-    int unsigned TypeCount = ArrayCount(NamedHashTypes);
     for(int unsigned TypeIndex = 0;
         TypeIndex < TypeCount;
         ++TypeIndex)
     {
         named_hash_type Type = NamedHashTypes[TypeIndex];
-        fprintf(stdout, "    %d. %s\n", TypeIndex + 1, Type.FullName);
+        fprintf(stdout, "    %d. %s%s\n", TypeIndex + 1, Type.FullName, HashIsSelected[TypeIndex] ? "" : " (not selected)");
     }
     fprintf(stdout, "\n");
     
-    void *Buffer = aligned_alloc(CACHE_LINE_ALIGNMENT, MAX_SIZE_TO_TEST);
-    if(Buffer)
+    perf_counters Perf = {};
+    if(UsePerf && !ScaleMode)
+    {
+        InitPerfCounters(&Perf, PerfRawEvents);
+        CalibratePerfCounters(&Perf);
+        PrintPerfCounters(&Perf, stdout);
+    }
+    
+    if(ScaleMode)
+    {
+        RunScaling(ScaleThreadCount, ScaleSize, CSVFileName);
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+    if(ReplayFileName)
+    {
+        replay_workload Workload;
+        if(LoadReplayWorkload(ReplayFileName, ReplayIsTrace, &Workload))
+        {
+            RunReplay(&Workload, HashIsSelected, CSVFileName);
+        }
+        FreeReplayWorkload(&Workload);
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+    if(TableMode)
+    {
+        RunTableWorkload(TableKeyCount, WordFileName, HashIsSelected, &Perf, CSVFileName);
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+#if MEOW_TIME_STAGES
+    if(StageMode)
+    {
+        meow_u64 DefaultSizes[] = {0, 1, 15, 16, 31, 32, 64, 100, 128, 255, 256, Kb(1), Kb(4), Kb(64)};
+        if(SelectedSizeCount)
+        {
+            RunStageTiming(SelectedSizes, SelectedSizeCount, CSVFileName);
+        }
+        else
+        {
+            RunStageTiming(DefaultSizes, ArrayCount(DefaultSizes), CSVFileName);
+        }
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+#endif
+    
+    cache_sizes Caches = GetCacheSizes();
+    
+    // NOTE: Pin before choosing a NUMA node, so that "local" stays local
+    if(Runner.Enabled)
+    {
+        if(!InitRunner(&Runner, RunnerProcessor, &Perf))
+        {
+            return(-1);
+        }
+    }
+    else if(NUMAModeName)
+    {
+        PinToProcessor(GetCurrentProcessor());
+    }
+    
+    int NUMANode = NUMA_NODE_ANY;
+    int NUMANodeCount = GetNUMANodeCount();
+    int LocalNUMANode = GetCurrentNUMANode();
+    if(NUMAModeName)
+    {
+        if(strcmp(NUMAModeName, "local") == 0)
+        {
+            NUMANode = LocalNUMANode;
+        }
+        else if(strcmp(NUMAModeName, "remote") == 0)
+        {
+            if(NUMANodeCount < 2)
+            {
+                fprintf(stderr, "ERROR: -numa remote needs more than one NUMA node, and this machine has one\n");
+                return(-1);
+            }
+            NUMANode = (LocalNUMANode + 1) % NUMANodeCount;
+        }
+        else
+        {
+            NUMANode = atoi(NUMAModeName);
+            if((NUMANode < 0) || (NUMANode >= NUMANodeCount))
+            {
+                fprintf(stderr, "ERROR: -numa takes local, remote, or a node from 0 to %d\n", NUMANodeCount - 1);
+                return(-1);
+            }
+        }
+    }
+    
+    if(TLBSweep)
+    {
+        meow_u64 DefaultSizes[] = {Mb(32), Mb(128), Mb(512)};
+        int DefaultSizeCount = ArrayCount(DefaultSizes);
+#if MEOW_TEST_BENCH_QUICK
+        DefaultSizeCount = 1;
+#endif
+        if(SelectedSizeCount)
+        {
+            RunTLBSweep(SelectedSizes, SelectedSizeCount, HashIsSelected, &Perf, NUMANode, CSVFileName);
+        }
+        else
+        {
+            RunTLBSweep(DefaultSizes, DefaultSizeCount, HashIsSelected, &Perf, NUMANode, CSVFileName);
+        }
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+    meow_u64 BufferSize = MAX_SIZE_TO_TEST;
+    if(SelectedSizeCount && !WorkingSetSweep && !AlignmentSweep)
+    {
+        // NOTE: Only allocate (and page in) what the selected sizes need
+        BufferSize = SelectedSizes[SelectedSizeCount - 1];
+        if(CacheMode == CacheMode_DRAM)
+        {
+            meow_u64 DefaultWorkingSet = WorkingSetSize ? WorkingSetSize : WORKING_SET_LLC_MULTIPLE*Caches.LLC;
+            if(BufferSize < DefaultWorkingSet)
+            {
+                BufferSize = DefaultWorkingSet;
+            }
+        }
+        if(BufferSize < Kb(64))
+        {
+            BufferSize = Kb(64);
+        }
+        if(BufferSize > MAX_SIZE_TO_TEST)
+        {
+            BufferSize = MAX_SIZE_TO_TEST;
+        }
+    }
+    void *Buffer = AllocPages(BufferSize, NUMANode, (page_kind)PageKind);
+    if(!Buffer && (PageKind != Pages_Default))
+    {
+        fprintf(stderr, "ERROR: Unable to map %.0f bytes with %s pages%s\n", (double)BufferSize, PageKindNames[PageKind],
+                ((PageKind == Pages_Huge2MB) || (PageKind == Pages_Huge1GB)) ? " (is the huge page pool big enough? try -size)" : "");
+        return(-1);
+    }
+    
+    fprintf(stdout, "Caches: ");
+    PrintSize(stdout, (double)Caches.L1D, false);
+    fprintf(stdout, " L1D, ");
+    PrintSize(stdout, (double)Caches.L2, false);
+    fprintf(stdout, " L2, ");
+    PrintSize(stdout, (double)Caches.LLC, false);
+    fprintf(stdout, " LLC\n");
+    
+    if(Buffer && (NUMAModeName || (NUMANodeCount > 1)))
+    {
+        // NOTE: Touch the buffer so it has a page to ask about, and report where it really went
+        *(meow_u8 *)Buffer = 0;
+        fprintf(stdout, "NUMA: %d node%s, running on node %d, buffer on node %d%s\n",
+                NUMANodeCount, (NUMANodeCount == 1) ? "" : "s", LocalNUMANode, GetMemoryNUMANode(Buffer),
+                (NUMANode == NUMA_NODE_ANY) ? " (first touch)" : (NUMANode == LocalNUMANode) ? " (local)" : " (remote)");
+    }
+    
+    if(Buffer && (PageKind != Pages_Default))
+    {
+        // NOTE: Fault the whole buffer in now, so it's known what it got and no
+        // timed call pays for a page fault
+        memset(Buffer, 0, BufferSize);
+        meow_u64 HugeBytes = 0;
+        fprintf(stdout, "Pages: %s", PageKindNames[PageKind]);
+        if(GetHugePageBytes(Buffer, &HugeBytes))
+        {
+            fprintf(stdout, " (%.0f%% of the buffer is on huge pages)", 100.0*(double)HugeBytes / (double)BufferSize);
+        }
+        fprintf(stdout, "\n");
+    }
+    
+    if(Buffer && WorkingSetSweep)
+    {
+        RunWorkingSetSweep(Buffer, MAX_SIZE_TO_TEST, Caches, CSVFileName);
+        FreePages(Buffer, BufferSize, (page_kind)PageKind);
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+    if(Buffer && AlignmentSweep)
+    {
+        RunAlignmentSweep(Buffer, MAX_SIZE_TO_TEST, CSVFileName);
+        FreePages(Buffer, BufferSize, (page_kind)PageKind);
+        
+#if __aarch64__
+        disable_pmu(0x008);
+#endif
+        return(0);
+    }
+    
+    fprintf(stdout, "Cache mode: %s\n", CacheModeNames[CacheMode]);
+    
+    host_fingerprint Host = GetHostFingerprint();
+    fprintf(stdout, "Host: %s (%s), %s, %s\n", Host.CPU, Host.Flags, Host.Kernel, Host.Compiler);
+    
+    void *EvictBuffer = 0;
+    meow_u64 EvictSize = 2*(Caches.L1D + Caches.L2);
+    if(CacheMode == CacheMode_LLC)
+    {
+        EvictBuffer = aligned_alloc(CACHE_LINE_ALIGNMENT, EvictSize);
+        FuddleBuffer(EvictSize, EvictBuffer, 0);
+    }
+    
+    if((CacheMode == CacheMode_Flush) || (CacheMode == CacheMode_LLC))
+    {
+        MaxClockCount /= COLD_MODE_RUN_DIVISOR;
+    }
+    
+    working_set WorkingSet = {};
+    if(Buffer && (CacheMode == CacheMode_DRAM))
+    {
+        meow_u64 Size = WorkingSetSize ? WorkingSetSize : WORKING_SET_LLC_MULTIPLE*Caches.LLC;
+        if(Size > BufferSize)
+        {
+            Size = BufferSize;
+        }
+        FuddleBuffer(Size, Buffer, 0);
+        CalibrateLoadLatency(Buffer, Size, Caches);
+        InitWorkingSet(&WorkingSet, Buffer, Size);
+        
+        fprintf(stdout, "Working set: ");
+        PrintSize(stdout, (double)WorkingSet.Size, false);
+        fprintf(stdout, " (inputs larger than that are hashed from the start of the buffer)\n");
+        
+        // NOTE: Probed on a copy, so the benchmark itself starts at the beginning of the order
+        working_set Probe = WorkingSet;
+        meow_u64 LoadClocks = ProbeLoadClocks(&Probe, 64);
+        PrintLoadCalibration(stdout);
+        fprintf(stdout, "Loads from the working set: %.0f clocks (%s)\n", (double)LoadClocks, MeasuredMemoryLevel(LoadClocks));
+    }
+    
+    cache_setup CacheSetup = {CacheMode, Buffer, &WorkingSet, EvictBuffer, EvictSize};
+    if(UseRoofline)
+    {
+        RooflineCopyBuffer = (meow_u8 *)aligned_alloc(CACHE_LINE_ALIGNMENT, ROOFLINE_COPY_CHUNK);
+    }
+    
+    if(Buffer && ((CacheMode != CacheMode_LLC) || EvictBuffer))
     {
         int unsigned SizePattern[] =
         {
@@ -861,18 +6236,73 @@ main(int ArgCount, char **Args)
                         58,
                         59,
         };
+        if(Runner.Enabled)
+        {
+            WarmUpRunner(&Runner, &Perf, Buffer, BufferSize);
+        }
+        
+        meow_u64 BudgetClocks = 0;
+        if(CellBudgetSeconds > 0.0)
+        {
+            BudgetClocks = (meow_u64)(CellBudgetSeconds*EstimateTimestampFrequency());
+        }
+        
+        int unsigned BatchCount = SIZE_TYPE_COUNT;
+        if(SelectedSizeCount)
+        {
+            BatchCount = (SelectedSizeCount + SIZE_COUNT_PER_BATCH - 1) / SIZE_COUNT_PER_BATCH;
+        }
+        
         for(int unsigned SizeIndex = 0;
-            SizeIndex < SIZE_TYPE_COUNT;
+            SizeIndex < BatchCount;
             ++SizeIndex)
         {
-            int unsigned TestCount = ArrayCount(Tests->Sizes);
+            if(SelectedSizeCount)
+            {
+                int unsigned First = SizeIndex*SIZE_COUNT_PER_BATCH;
+                int unsigned Count = SelectedSizeCount - First;
+                if(Count > SIZE_COUNT_PER_BATCH)
+                {
+                    Count = SIZE_COUNT_PER_BATCH;
+                }
+                InitializeSelectedTests(Tests, SelectedSizes + First, Count, SizeIndex, MaxClockCount);
+            }
+            else
+            {
+                int unsigned SizeType = SizePattern[SizeIndex];
+                InitializeTests(Tests, SizeType, MaxClockCount);
+            }
+            int unsigned TestCount = Tests->SizeCount;
             
-            int unsigned SizeType = SizePattern[SizeIndex];
-            InitializeTests(Tests, SizeType, MaxClockCount);
             fprintf(stdout, "\n----------------------------------------------------\n");
-            fprintf(stdout, "\n[%u / %u] %s\n", SizeIndex + 1, SIZE_TYPE_COUNT, Tests->Name);
+            fprintf(stdout, "\n[%u / %u] %s\n", SizeIndex + 1, BatchCount, Tests->Name);
             fprintf(stdout, "\n----------------------------------------------------\n");
             
+            for(int unsigned TestIndex = 0;
+                TestIndex < TestCount;
+                ++TestIndex)
+            {
+                Tests->Sizes[TestIndex].MemoryLevel = 0;
+                Tests->Sizes[TestIndex].ReadBPC = 0.0;
+                Tests->Sizes[TestIndex].CopyBPC = 0.0;
+            }
+            
+            if(Buffer && RooflineCopyBuffer)
+            {
+                MeasureRoofline(Tests, &CacheSetup, Caches);
+                
+                fprintf(stdout, "\nRoofline (read / memcpy):\n");
+                for(int unsigned TestIndex = 0;
+                    TestIndex < TestCount;
+                    ++TestIndex)
+                {
+                    input_size_test *Test = Tests->Sizes + TestIndex;
+                    fprintf(stdout, "  ");
+                    PrintSize(stdout, (double)Test->Size, true);
+                    fprintf(stdout, " %-4s: %6.03f / %6.03f bytes/cycle\n", Test->MemoryLevel, Test->ReadBPC, Test->CopyBPC);
+                }
+            }
+            
             //
             // NOTE(casey): Run the test sizes through each hash, "randomizing" the order to hopefully thwart the branch predictors as much as possible
             //
@@ -885,69 +6315,128 @@ main(int ArgCount, char **Args)
                     TypeIndex < TypeCount;
                     ++TypeIndex)
                 {
+                    if(!HashIsSelected[TypeIndex])
+                    {
+                        continue;
+                    }
+                    
                     named_hash_type Type = NamedHashTypes[TypeIndex];
                     fprintf(stdout, "\n%s:\n", Type.FullName);
                     
                     // NOTE(casey): Clear the clock count
                     for(int unsigned SizeIndex = 0;
-                        SizeIndex < ArrayCount(Tests->Sizes);
+                        SizeIndex < TestCount;
                         ++SizeIndex)
                     {
                         Tests->Sizes[SizeIndex].ClockCount = 0;
                         Tests->Sizes[SizeIndex].ClockAccum = 0;
                         Tests->Sizes[SizeIndex].ClockExp = -1ULL;
                         Tests->Sizes[SizeIndex].ClockMin = -1ULL;
+                        Tests->Sizes[SizeIndex].ClockMax = 0;
+                        Tests->Sizes[SizeIndex].SampleCount = 0;
+                        memset(Tests->Sizes[SizeIndex].Histogram, 0, sizeof(Tests->Sizes[SizeIndex].Histogram));
+                        Tests->Sizes[SizeIndex].PerfCount = 0;
+                        memset(Tests->Sizes[SizeIndex].PerfAccum, 0, sizeof(Tests->Sizes[SizeIndex].PerfAccum));
+                        Tests->Sizes[SizeIndex].SpentClocks = 0;
+                        Tests->Sizes[SizeIndex].StopReason = Stop_None;
+                        Tests->Sizes[SizeIndex].NextConvergeCheck = CONVERGE_MIN_SAMPLES;
+                    }
+                    
+                    if(Runner.Enabled)
+                    {
+                        BeginRunnerHash(&Runner, &Perf);
                     }
                     
                     TRY
                     {
                         meow_u64 ClocksSinceLastStatus = 0;
                         meow_u64 TestRand = TestRandSeed;
+                        int unsigned StoppedCount = 0;
                         for(int unsigned RunIndex = 0;
-                            RunIndex < Tests->RunsPerHashImplementation;
+                            (RunIndex < Tests->RunsPerHashImplementation) && (StoppedCount < TestCount);
                             ++RunIndex)
                         {
-                            int unsigned UseIndex = Random(&TestRand);
-                            input_size_test *Test = Tests->Sizes + (UseIndex % TestCount);
+                            meow_u64 IterationStartClock = __rdtsc();
+                            
+                            // NOTE: Sizes that have stopped hand their runs to the next one that hasn't
+                            int unsigned UseIndex = Random(&TestRand) % TestCount;
+                            while(Tests->Sizes[UseIndex].StopReason != Stop_None)
+                            {
+                                UseIndex = (UseIndex + 1) % TestCount;
+                            }
+                            input_size_test *Test = Tests->Sizes + UseIndex;
                             
                             meow_u64 Size = Test->Size;
                             
                             // NOTE(casey): Write junk into the buffer to try to thwart the optimizer from removing the actual function call.
                             // This should also warm the cache so that small inputs will be read from cache instead of from memory.
-                            FuddleBuffer(Size, Buffer, RunIndex);
+                            // NOTE: ...unless a colder cache mode was asked for, which then undoes that
+                            void *Source = PrepareInput(&CacheSetup, Size, RunIndex);
+                            
+                            // NOTE: The counters are read outside the serialized TSC window, so
+                            // reading them doesn't change the TSC numbers.
+                            perf_sample StartSample = {}, EndSample = {};
+                            if(Perf.EventCount)
+                            {
+                                ReadPerfCounters(&Perf, &StartSample);
+                            }
                             
                             int Ignored[4];
                             int unsigned Ignored2;
                             CPUID(Ignored, 0);
                             meow_u64 StartClock = __rdtsc();
-                            Test->FakeSlot = Type.Imp(MeowDefaultSeed, Size, Buffer);
+                            Test->FakeSlot = Type.Imp(MeowDefaultSeed, Size, Source);
                             meow_u64 EndClock = __rdtscp(&Ignored2);
                             CPUID(Ignored, 0);
                             
-                            meow_u64 Clocks = EndClock - StartClock;
-                            Test->ClockCount += 1;
-                            Test->ClockAccum += Clocks;
+                            meow_u64 PerfDeltas[PERF_MAX_EVENTS] = {};
+                            if(Perf.EventCount)
+                            {
+                                ReadPerfCounters(&Perf, &EndSample);
+                                for(int EventIndex = 0;
+                                    EventIndex < Perf.EventCount;
+                                    ++EventIndex)
+                                {
+                                    meow_u64 Delta = EndSample.Values[EventIndex] - StartSample.Values[EventIndex];
+                                    if(Delta > Perf.Overhead[EventIndex])
+                                    {
+                                        PerfDeltas[EventIndex] = Delta - Perf.Overhead[EventIndex];
+                                    }
+                                }
+                            }
                             
-                            if(Test->ClockMin > Clocks)
+                            meow_u64 Clocks = EndClock - StartClock;
+                            if(Runner.Enabled)
+                            {
+                                window_sample *Sample = Runner.Samples + Runner.SampleCount++;
+                                Sample->TestIndex = UseIndex;
+                                Sample->Clocks = Clocks;
+                                memcpy(Sample->PerfDeltas, PerfDeltas, sizeof(PerfDeltas));
+                            }
+                            else
                             {
-                                Test->ClockMin = Clocks;
+                                RecordSample(Test, Clocks, PerfDeltas, Perf.EventCount, Tests->ClocksPerAvg);
                             }
                             
-                            int ClocksPerAvg = Tests->ClocksPerAvg;
-                            if(Test->ClockCount == ClocksPerAvg)
+                            Test->SpentClocks += __rdtsc() - IterationStartClock;
+                            if(!Runner.Enabled)
+                            {
+                                StoppedCount += CheckForStop(Test, BudgetClocks, ConvergeTolerance);
+                            }
+                            else if(RunnerWindowIsDone(&Runner))
                             {
-                                meow_u64 ExpClocks = Test->ClockAccum / Test->ClockCount;
-                                if(Test->ClockExp > ExpClocks)
+                                // NOTE: Sizes only get their samples, and so can only stop, once their window is kept
+                                EndRunnerWindow(&Runner, &Perf, Tests);
+                                for(int unsigned TestIndex = 0;
+                                    TestIndex < TestCount;
+                                    ++TestIndex)
                                 {
-                                    Test->ClockExp = ExpClocks;
+                                    StoppedCount += CheckForStop(Tests->Sizes + TestIndex, BudgetClocks, ConvergeTolerance);
                                 }
-                                
-                                Test->ClockAccum = 0;
-                                Test->ClockCount = 0;
                             }
                             
                             ClocksSinceLastStatus += Clocks;
-                            if((RunIndex == (RunsPerHashImplementation - 1)) ||
+                            if((RunIndex == (RunsPerHashImplementation - 1)) || (StoppedCount == TestCount) ||
                                (ClocksSinceLastStatus > 1000000000ULL))
                             {
                                 ClocksSinceLastStatus = 0;
@@ -959,19 +6448,76 @@ main(int ArgCount, char **Args)
                         }
                         fprintf(stdout, "\n");
                         
+                        int Unreliable = 0;
+                        if(Runner.Enabled)
+                        {
+                            if(Runner.SampleCount)
+                            {
+                                EndRunnerWindow(&Runner, &Perf, Tests);
+                            }
+                            
+                            double RejectedFraction = RunnerRejectedFraction(&Runner);
+                            Unreliable = (RejectedFraction > Runner.NoiseThreshold);
+                            fprintf(stdout, "    Windows: %.0f, %.0f rejected (%.0f clock changes, %.0f context switches)",
+                                    (double)Runner.WindowCount, (double)(Runner.RejectedFrequency + Runner.RejectedSwitched),
+                                    (double)Runner.RejectedFrequency, (double)Runner.RejectedSwitched);
+                            if(Runner.MaxRatio > 0.0)
+                            {
+                                fprintf(stdout, ", kept core clock %.3f-%.3fx", Runner.MinRatio, Runner.MaxRatio);
+                            }
+                            fprintf(stdout, "\n");
+                            if(Unreliable)
+                            {
+                                fprintf(stdout, "    UNRELIABLE: %.1f%% of windows rejected (threshold %.1f%%)\n",
+                                        100.0*RejectedFraction, 100.0*Runner.NoiseThreshold);
+                            }
+                        }
+                        
                         for(int TestIndex = 0;
                             TestIndex < TestCount;
                             ++TestIndex)
                         {
                             input_size_test *Test = Tests->Sizes + TestIndex;
                             test_results *Results = CommitResults(TypeIndex, Test, Tests);
-                            if(Results)
+                            if(Results && Unreliable)
+                            {
+                                Results->Unreliable = 1;
+                                fprintf(stdout, "    ");
+                                PrintSize(stdout, Test->Size, true);
+                                fprintf(stdout, ": UNRELIABLE (%.0f calls kept)\n", (double)Test->SampleCount);
+                            }
+                            else if(Results)
                             {
                                 fprintf(stdout, "    ");
                                 PrintSize(stdout, Test->Size, true);
                                 
-                                fprintf(stdout, ": %0.03f bytes/cycle (%0.0f min, %0.0f exp)\n",
-                                        (double)Results->ExpBPC, (double)Results->MinClocks, (double)Results->ExpClocks);
+                                fprintf(stdout, ": %0.03f bytes/cycle (%0.0f min, %0.0f exp, %0.0f p50, %0.0f p99, %0.0f p99.9)%s",
+                                        (double)Results->ExpBPC, (double)Results->MinClocks, (double)Results->ExpClocks,
+                                        (double)Results->P50Clocks, (double)Results->P99Clocks, (double)Results->P999Clocks,
+                                        Results->UnstableTail ? " UNSTABLE TAIL" : "");
+                                if(Test->StopReason != Stop_None)
+                                {
+                                    fprintf(stdout, " [%s after %.0f calls]", StopReasonNames[Test->StopReason], (double)Test->SampleCount);
+                                }
+                                if(Results->CoreBPC > 0.0)
+                                {
+                                    fprintf(stdout, ", %0.03f bytes/core-cycle, %0.02f IPC",
+                                            Results->CoreBPC, Results->IPC);
+                                }
+                                if(Results->ReadBPC > 0.0)
+                                {
+                                    fprintf(stdout, ", %0.0f%% of %s roofline", RooflinePercent(Results), Results->MemoryLevel);
+                                }
+                                for(int EventIndex = PerfEvent_L1DMisses;
+                                    EventIndex < Perf.EventCount;
+                                    ++EventIndex)
+                                {
+                                    if(Perf.Available[EventIndex])
+                                    {
+                                        fprintf(stdout, ", %0.1f %s", Results->PerfPerCall[EventIndex], Perf.Specs[EventIndex].Name);
+                                    }
+                                }
+                                fprintf(stdout, "\n");
                             }
                             else
                             {
@@ -1005,20 +6551,35 @@ main(int ArgCount, char **Args)
                 {
                     WriteHTML(Tests, HTMLFileName);
                 }
+                
+                if(JSONFileName)
+                {
+                    WriteJSON(Tests, &Host, CacheModeNames[CacheMode], JSONFileName);
+                }
             }
             
             fprintf(stdout, "\n");
             fflush(stdout);
             fflush(stderr);
         }
-        
-        free(Buffer);
     }
     else
     {
         fprintf(stderr, "ERROR: Unable to allocate buffer for hashing\n");
     }
     
+    FreeWorkingSet(&WorkingSet);
+    FreePages(Buffer, BufferSize, (page_kind)PageKind);
+    if(EvictBuffer)
+    {
+        free(EvictBuffer);
+    }
+    if(RooflineCopyBuffer)
+    {
+        free(RooflineCopyBuffer);
+    }
+    free(SelectedSizes);
+    
 #if __aarch64__
     disable_pmu(0x008);
 #endif
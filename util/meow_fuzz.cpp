@@ -0,0 +1,705 @@
+/* ========================================================================
+
+   meow_fuzz.cpp - differential fuzzer for Meow hash implementations
+   (C) Copyright 2018-2019 by Molly Rocket, Inc. (https://mollyrocket.com)
+
+   See https://mollyrocket.com/meowhash for details.
+
+   ======================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#if !_WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "meow_test.h"
+
+//
+// NOTE: Every entry in NamedHashTypes that has a Reference is checked against it:
+// the one-shot Imp on a source placed at a fuzzed alignment, or flush against a
+// guard page on either side, and (if the type streams) Begin/Absorb/End with
+// fuzzed split points, all against the Reference run on a plain aligned copy.  A
+// new kernel only has to be added to NamedHashTypes with MeowHash as its Reference
+// to be covered.
+//
+// Built normally, this is a standalone driver: it runs random cases for a while
+// (-runs, -seconds), or replays case files given on the command line, and when a
+// case fails it shrinks it to a minimal one and writes it out.  Built with
+//
+//     clang++ -g -O1 -fsanitize=fuzzer,address -DMEOW_FUZZ_LIBFUZZER=1 -I. -mavx -maes util/meow_fuzz.cpp
+//
+// it is a coverage-guided libFuzzer target instead (use libFuzzer's own
+// -minimize_crash=1 on what it finds).  Case files are the same either way.  All
+// the buffers hashed are mapped directly rather than malloc'd, since Meow may read
+// past the end of its input within the last page, which AddressSanitizer would
+// otherwise report.
+//
+// A case is laid out as:
+//
+//   byte 0       which hash type (modulo the number with a Reference)
+//   byte 1       seed: 0 default, 1 zero, 2 the next 128 bytes, 3 expanded from the next 8
+//   byte 2       source offset from a 128-byte boundary (low 7 bits), and placement
+//                in the top bit: flush against a guard page before or after the source
+//   byte 3       repeat: the data is tiled 1 << (byte % 8) times, to reach the prefetching loop
+//   byte 4       split count (modulo 17), followed by that many 2-byte split lengths
+//   the rest     the data
+//
+
+#define FUZZ_DEFAULT_MAX_LEN 4096
+#define FUZZ_MAX_SPLITS 16
+
+struct fuzz_reader
+{
+    meow_u8 *At;
+    size_t Remaining;
+};
+
+static meow_u8
+TakeByte(fuzz_reader *Reader)
+{
+    meow_u8 Result = 0;
+    if(Reader->Remaining)
+    {
+        Result = *Reader->At++;
+        --Reader->Remaining;
+    }
+    return(Result);
+}
+
+static void
+TakeBytes(fuzz_reader *Reader, meow_u8 *Dest, size_t Count)
+{
+    for(size_t Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        Dest[Index] = TakeByte(Reader);
+    }
+}
+
+//
+// NOTE: Page-guarded buffers
+//
+
+#if _WIN32
+#include <windows.h>
+#define FUZZ_PAGE_SIZE 4096
+#else
+#define FUZZ_PAGE_SIZE ((size_t)sysconf(_SC_PAGESIZE))
+#endif
+
+struct guarded_buffer
+{
+    meow_u8 *Base;
+    size_t TotalSize;
+    meow_u8 *Data; // NOTE: Size bytes, page-aligned, with an inaccessible page on each side
+    size_t Size;
+};
+
+static int
+AllocGuarded(guarded_buffer *Buffer, size_t Size)
+{
+    size_t PageSize = FUZZ_PAGE_SIZE;
+    Buffer->Size = (Size + PageSize - 1) & ~(PageSize - 1);
+    if(Buffer->Size == 0)
+    {
+        Buffer->Size = PageSize;
+    }
+    Buffer->TotalSize = Buffer->Size + 2*PageSize;
+
+#if _WIN32
+    Buffer->Base = (meow_u8 *)VirtualAlloc(0, Buffer->TotalSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    int Result = (Buffer->Base != 0);
+    if(Result)
+    {
+        DWORD Ignored;
+        VirtualProtect(Buffer->Base, PageSize, PAGE_NOACCESS, &Ignored);
+        VirtualProtect(Buffer->Base + PageSize + Buffer->Size, PageSize, PAGE_NOACCESS, &Ignored);
+    }
+#else
+    Buffer->Base = (meow_u8 *)mmap(0, Buffer->TotalSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    int Result = (Buffer->Base != MAP_FAILED);
+    if(Result)
+    {
+        mprotect(Buffer->Base, PageSize, PROT_NONE);
+        mprotect(Buffer->Base + PageSize + Buffer->Size, PageSize, PROT_NONE);
+    }
+    else
+    {
+        Buffer->Base = 0;
+    }
+#endif
+    Buffer->Data = Result ? (Buffer->Base + PageSize) : 0;
+
+    return(Result);
+}
+
+static void
+FreeGuarded(guarded_buffer *Buffer)
+{
+    if(Buffer->Base)
+    {
+#if _WIN32
+        VirtualFree(Buffer->Base, 0, MEM_RELEASE);
+#else
+        munmap(Buffer->Base, Buffer->TotalSize);
+#endif
+        Buffer->Base = 0;
+    }
+}
+
+//
+// NOTE: Checking one case
+//
+
+static int
+GetFuzzableTypeCount(void)
+{
+    int Result = 0;
+    for(int TypeIndex = 0;
+        TypeIndex < ArrayCount(NamedHashTypes);
+        ++TypeIndex)
+    {
+        Result += (NamedHashTypes[TypeIndex].Reference != 0);
+    }
+    return(Result);
+}
+
+static named_hash_type *
+GetFuzzableType(int Index)
+{
+    named_hash_type *Result = 0;
+    for(int TypeIndex = 0;
+        TypeIndex < ArrayCount(NamedHashTypes);
+        ++TypeIndex)
+    {
+        if(NamedHashTypes[TypeIndex].Reference && (Index-- == 0))
+        {
+            Result = NamedHashTypes + TypeIndex;
+            break;
+        }
+    }
+    return(Result);
+}
+
+// NOTE: Returns 1 if every implementation agrees with the reference, otherwise 0,
+// with what disagreed written to Failure
+static int
+CheckCase(meow_u8 *Case, size_t CaseSize, char *Failure, size_t FailureSize)
+{
+    int Result = 1;
+
+    fuzz_reader Reader = {Case, CaseSize};
+    named_hash_type *Type = GetFuzzableType(TakeByte(&Reader) % GetFuzzableTypeCount());
+
+    meow_u8 Seed128[128] = {};
+    int SeedMode = TakeByte(&Reader) % 4;
+    if(SeedMode == 0)
+    {
+        memcpy(Seed128, MeowDefaultSeed, sizeof(Seed128));
+    }
+    else if(SeedMode == 2)
+    {
+        TakeBytes(&Reader, Seed128, sizeof(Seed128));
+    }
+    else if(SeedMode == 3)
+    {
+        meow_u8 Short[8];
+        TakeBytes(&Reader, Short, sizeof(Short));
+        MeowExpandSeed(sizeof(Short), Short, Seed128);
+    }
+
+    meow_u8 Placement = TakeByte(&Reader);
+    int Offset = Placement & 0x7f;
+    int AgainstGuard = (Placement & 0x80) ? (1 + (Offset & 1)) : 0; // NOTE: 1 = guard after, 2 = guard before
+    int Repeat = 1 << (TakeByte(&Reader) % 8);
+
+    int SplitCount = TakeByte(&Reader) % (FUZZ_MAX_SPLITS + 1);
+    meow_u32 Splits[FUZZ_MAX_SPLITS];
+    for(int SplitIndex = 0;
+        SplitIndex < SplitCount;
+        ++SplitIndex)
+    {
+        Splits[SplitIndex] = TakeByte(&Reader);
+        Splits[SplitIndex] |= (meow_u32)TakeByte(&Reader) << 8;
+    }
+
+    size_t Len = Reader.Remaining*Repeat;
+    guarded_buffer Canonical = {};
+    guarded_buffer Placed = {};
+    if(AllocGuarded(&Canonical, Len + CACHE_LINE_ALIGNMENT) && AllocGuarded(&Placed, Len + CACHE_LINE_ALIGNMENT))
+    {
+        for(int Tile = 0;
+            Tile < Repeat;
+            ++Tile)
+        {
+            memcpy(Canonical.Data + Tile*Reader.Remaining, Reader.At, Reader.Remaining);
+        }
+
+        meow_u8 *Source = ((AgainstGuard == 1) ? (Placed.Data + Placed.Size - Len) :
+                           (AgainstGuard == 2) ? Placed.Data :
+                           (Placed.Data + Offset));
+        memcpy(Source, Canonical.Data, Len);
+
+        meow_u128 Expected = Type->Reference(Seed128, Len, Canonical.Data);
+        char const *Placements[] = {"offset", "against the end guard page", "against the start guard page"};
+
+        meow_u128 ImpHash = Type->Imp(Seed128, Len, Source);
+        if(!MeowHashesAreEqual(Expected, ImpHash))
+        {
+            snprintf(Failure, FailureSize, "%s: one-shot hash of %llu bytes (%s %d) doesn't match the reference",
+                     Type->FullName, (meow_u64)Len, Placements[AgainstGuard], AgainstGuard ? 0 : Offset);
+            Result = 0;
+        }
+
+        if(Result && Type->Absorb)
+        {
+            // NOTE: Big enough for any of the streaming states
+            meow_u8 StateBuffer[1024];
+            Type->Begin(StateBuffer, Seed128);
+
+            size_t At = 0;
+            for(int SplitIndex = 0;
+                SplitIndex <= SplitCount;
+                ++SplitIndex)
+            {
+                size_t Amount = (SplitIndex < SplitCount) ? (Splits[SplitIndex] % (Len + 1)) : Len;
+                if(Amount > (Len - At))
+                {
+                    Amount = Len - At;
+                }
+
+                Type->Absorb(StateBuffer, Amount, Source + At);
+                At += Amount;
+            }
+
+            meow_u128 StreamHash = Type->End(StateBuffer, 0);
+            if(!MeowHashesAreEqual(Expected, StreamHash))
+            {
+                snprintf(Failure, FailureSize, "%s: streaming hash of %llu bytes in %d splits doesn't match the reference",
+                         Type->FullName, (meow_u64)Len, SplitCount + 1);
+                Result = 0;
+            }
+        }
+    }
+    FreeGuarded(&Placed);
+    FreeGuarded(&Canonical);
+
+    return(Result);
+}
+
+#if MEOW_FUZZ_LIBFUZZER
+
+extern "C" int
+LLVMFuzzerTestOneInput(const meow_u8 *Data, size_t Size)
+{
+    char Failure[256];
+    if(!CheckCase((meow_u8 *)Data, Size, Failure, sizeof(Failure)))
+    {
+        fprintf(stderr, "MISMATCH: %s\n", Failure);
+        abort();
+    }
+
+    return(0);
+}
+
+#else
+
+//
+// NOTE: Standalone driver
+//
+
+static meow_u64
+NextRandom(meow_u64 *Series)
+{
+    // NOTE: splitmix64
+    meow_u64 Z = (*Series += 0x9e3779b97f4a7c15ull);
+    Z = (Z ^ (Z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    Z = (Z ^ (Z >> 27)) * 0x94d049bb133111ebull;
+    Z = (Z ^ (Z >> 31));
+    return(Z);
+}
+
+static size_t
+MakeRandomCase(meow_u64 *Series, meow_u8 *Case, size_t MaxLen)
+{
+    // NOTE: Mostly short data, since that's where the residual and lane code is
+    meow_u64 Class = NextRandom(Series) % 10;
+    size_t DataLen = ((Class < 4) ? (NextRandom(Series) % 65) :
+                      (Class < 7) ? (NextRandom(Series) % 1025) :
+                      (NextRandom(Series) % (MaxLen + 1)));
+
+    size_t Size = 0;
+    Case[Size++] = (meow_u8)NextRandom(Series);
+    Case[Size++] = (meow_u8)NextRandom(Series);
+    Case[Size++] = (meow_u8)NextRandom(Series);
+
+    // NOTE: Mostly no repeat, so that the big tiled inputs don't dominate the run time
+    Case[Size++] = (NextRandom(Series) % 8) ? 0 : (meow_u8)NextRandom(Series);
+
+    int SeedMode = Case[1] % 4;
+    size_t SeedBytes = (SeedMode == 2) ? 128 : (SeedMode == 3) ? 8 : 0;
+    int SplitCount = (int)(NextRandom(Series) % (FUZZ_MAX_SPLITS + 1));
+
+    // NOTE: The seed bytes go between the seed mode and the placement, as CheckCase reads them
+    memmove(Case + 2 + SeedBytes, Case + 2, 2);
+    for(size_t Index = 0;
+        Index < SeedBytes;
+        ++Index)
+    {
+        Case[2 + Index] = (meow_u8)NextRandom(Series);
+    }
+    Size += SeedBytes;
+
+    Case[Size++] = (meow_u8)SplitCount;
+    for(int SplitIndex = 0;
+        SplitIndex < SplitCount;
+        ++SplitIndex)
+    {
+        meow_u64 Split = NextRandom(Series) % (DataLen + 1);
+        Case[Size++] = (meow_u8)Split;
+        Case[Size++] = (meow_u8)(Split >> 8);
+    }
+
+    for(size_t Index = 0;
+        Index < DataLen;
+        ++Index)
+    {
+        Case[Size++] = (meow_u8)NextRandom(Series);
+    }
+
+    return(Size);
+}
+
+static int
+StillFails(meow_u8 *Case, size_t Size)
+{
+    char Failure[256];
+    int Result = !CheckCase(Case, Size, Failure, sizeof(Failure));
+    return(Result);
+}
+
+// NOTE: Removes Count bytes at At if the case still fails without them
+static size_t
+TryRemove(meow_u8 *Case, size_t Size, size_t At, size_t Count)
+{
+    size_t Result = Size;
+
+    meow_u8 *Trial = (meow_u8 *)malloc(Size);
+    memcpy(Trial, Case, At);
+    memcpy(Trial + At, Case + At + Count, Size - At - Count);
+    if(StillFails(Trial, Size - Count))
+    {
+        memcpy(Case, Trial, Size - Count);
+        Result = Size - Count;
+    }
+    free(Trial);
+
+    return(Result);
+}
+
+static size_t
+MinimizeCase(meow_u8 *Case, size_t Size)
+{
+    // NOTE: Go back to the default seed if it fails with that too...
+    int SeedMode = (Size > 1) ? (Case[1] % 4) : 0;
+    if(SeedMode)
+    {
+        size_t SeedBytes = (SeedMode == 2) ? 128 : (SeedMode == 3) ? 8 : 0;
+        meow_u8 Was = Case[1];
+        Case[1] = 0;
+        size_t NewSize = (SeedBytes && ((2 + SeedBytes) <= Size)) ? TryRemove(Case, Size, 2, SeedBytes) : Size;
+        if((NewSize != Size) || (!SeedBytes && StillFails(Case, Size)))
+        {
+            SeedMode = 0;
+        }
+        else
+        {
+            Case[1] = Was;
+        }
+        Size = NewSize;
+    }
+
+    // NOTE: Find where the splits and the data start, the same way CheckCase reads them
+    size_t RepeatAt = 3 + ((SeedMode == 2) ? 128 : (SeedMode == 3) ? 8 : 0);
+    size_t SplitCountAt = RepeatAt + 1;
+    if(Size > SplitCountAt)
+    {
+        // NOTE: ...and drop the splits and the tiling if it fails without them...
+        size_t SplitBytes = 2*(Case[SplitCountAt] % (FUZZ_MAX_SPLITS + 1));
+        if(SplitBytes && ((SplitCountAt + 1 + SplitBytes) <= Size))
+        {
+            meow_u8 Was = Case[SplitCountAt];
+            Case[SplitCountAt] = 0;
+            size_t NewSize = TryRemove(Case, Size, SplitCountAt + 1, SplitBytes);
+            if(NewSize == Size)
+            {
+                Case[SplitCountAt] = Was;
+            }
+            Size = NewSize;
+        }
+
+        meow_u8 Repeat = Case[RepeatAt];
+        Case[RepeatAt] = 0;
+        if(!StillFails(Case, Size))
+        {
+            Case[RepeatAt] = Repeat;
+        }
+
+        // NOTE: ...then cut the data to the shortest length that still fails, since
+        // a lot of what can go wrong depends only on the length...
+        size_t DataAt = SplitCountAt + 1 + 2*(Case[SplitCountAt] % (FUZZ_MAX_SPLITS + 1));
+        for(size_t NewSize = DataAt;
+            NewSize < Size;
+            ++NewSize)
+        {
+            if(StillFails(Case, NewSize))
+            {
+                Size = NewSize;
+                break;
+            }
+        }
+
+        // NOTE: ...then cut out ever smaller chunks of what's left of it...
+        for(size_t Chunk = (Size - DataAt) / 2;
+            Chunk >= 1;
+            Chunk /= 2)
+        {
+            size_t At = DataAt;
+            while((At + Chunk) <= Size)
+            {
+                size_t NewSize = TryRemove(Case, Size, At, Chunk);
+                if(NewSize == Size)
+                {
+                    At += Chunk;
+                }
+                Size = NewSize;
+            }
+        }
+    }
+
+    // NOTE: ...and zero whatever bytes it doesn't need
+    for(size_t At = 0;
+        At < Size;
+        ++At)
+    {
+        meow_u8 Was = Case[At];
+        if(Was)
+        {
+            Case[At] = 0;
+            if(!StillFails(Case, Size))
+            {
+                Case[At] = Was;
+            }
+        }
+    }
+
+    return(Size);
+}
+
+static int
+ReportFailure(meow_u8 *Case, size_t Size, char *OutDirectory)
+{
+    char Failure[256];
+    CheckCase(Case, Size, Failure, sizeof(Failure));
+    printf("MISMATCH: %s\n", Failure);
+
+    size_t MinimalSize = MinimizeCase(Case, Size);
+    CheckCase(Case, MinimalSize, Failure, sizeof(Failure));
+    printf("Minimized from %llu to %llu bytes: %s\n", (meow_u64)Size, (meow_u64)MinimalSize, Failure);
+
+    meow_u128 Name = MeowHash(MeowDefaultSeed, MinimalSize, Case);
+    char FileName[4096];
+    snprintf(FileName, sizeof(FileName), "%s/meow_fuzz_mismatch_%08x", OutDirectory, MeowU32From(Name, 0));
+    FILE *File = fopen(FileName, "wb");
+    if(File)
+    {
+        fwrite(Case, MinimalSize, 1, File);
+        fclose(File);
+        printf("Wrote %s (replay with: meow_fuzz %s)\n", FileName, FileName);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to write %s\n", FileName);
+    }
+
+    return(1);
+}
+
+static int
+ReplayCaseFile(char *FileName, char *OutDirectory)
+{
+    int Result = 0;
+
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        size_t Size = (size_t)ftell(File);
+        fseek(File, 0, SEEK_SET);
+
+        meow_u8 *Case = (meow_u8 *)malloc(Size ? Size : 1);
+        if((Size == 0) || (fread(Case, Size, 1, File) == 1))
+        {
+            char Failure[256];
+            if(CheckCase(Case, Size, Failure, sizeof(Failure)))
+            {
+                printf("%s: ok\n", FileName);
+            }
+            else
+            {
+                printf("%s: ", FileName);
+                Result = ReportFailure(Case, Size, OutDirectory);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to read %s\n", FileName);
+            Result = 1;
+        }
+
+        free(Case);
+        fclose(File);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s\n", FileName);
+        Result = 1;
+    }
+
+    return(Result);
+}
+
+int
+main(int ArgCount, char **Args)
+{
+    meow_u64 RunCount = 0;
+    double Seconds = 0.0;
+    meow_u64 Seed = 0;
+    int HaveSeed = 0;
+    size_t MaxLen = FUZZ_DEFAULT_MAX_LEN;
+    char *OutDirectory = (char *)".";
+    char **Files = (char **)malloc(ArgCount*sizeof(char *));
+    int FileCount = 0;
+    int ArgsOk = 1;
+    for(int ArgIndex = 1;
+        ArgIndex < ArgCount;
+        ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if((strcmp(Arg, "-runs") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            RunCount = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-seconds") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            Seconds = atof(Args[++ArgIndex]);
+        }
+        else if((strcmp(Arg, "-seed") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            Seed = strtoull(Args[++ArgIndex], 0, 0);
+            HaveSeed = 1;
+        }
+        else if((strcmp(Arg, "-max-len") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            MaxLen = (size_t)strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-out") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            OutDirectory = Args[++ArgIndex];
+        }
+        else if(Arg[0] != '-')
+        {
+            Files[FileCount++] = Arg;
+        }
+        else
+        {
+            ArgsOk = 0;
+        }
+    }
+
+    if(!ArgsOk || (MaxLen > 0xffff) || (Seconds < 0.0))
+    {
+        fprintf(stderr, "Usage: %s [-runs <count>] [-seconds <seconds>] [-seed <number>] [-max-len <bytes>]\n"
+                "       [-out <directory>] [case file ...]\n", Args[0]);
+        fprintf(stderr, "    Checks every hash implementation with a reference against it, on random cases\n");
+        fprintf(stderr, "    (default: 100000 of them), or on the given case files\n");
+        fprintf(stderr, "    -seed: start the random cases from this seed, to repeat a run\n");
+        fprintf(stderr, "    -max-len: longest data in a random case before it is tiled (default %d, at most 65535)\n", FUZZ_DEFAULT_MAX_LEN);
+        fprintf(stderr, "    -out: where to write minimized failing cases (default: here)\n");
+        return(-1);
+    }
+
+    printf("meow_fuzz %s - differential fuzzer for Meow hash implementations\n", MEOW_HASH_VERSION_NAME);
+    printf("Implementations checked against their reference:\n");
+    for(int Index = 0;
+        Index < GetFuzzableTypeCount();
+        ++Index)
+    {
+        named_hash_type *Type = GetFuzzableType(Index);
+        printf("    %s%s\n", Type->FullName, Type->Absorb ? " (one-shot and streaming)" : "");
+    }
+
+    int Result = 0;
+    if(FileCount)
+    {
+        for(int FileIndex = 0;
+            FileIndex < FileCount;
+            ++FileIndex)
+        {
+            Result |= ReplayCaseFile(Files[FileIndex], OutDirectory);
+        }
+    }
+    else
+    {
+        if(!HaveSeed)
+        {
+            Seed = (meow_u64)(GetWallClock()*1000000.0);
+        }
+        if(!RunCount && (Seconds == 0.0))
+        {
+            RunCount = 100000;
+        }
+        printf("Seed: %llu\n", Seed);
+        fflush(stdout);
+
+        meow_u8 *Case = (meow_u8 *)malloc(MaxLen + 256 + 2*FUZZ_MAX_SPLITS);
+        meow_u64 Series = Seed;
+        double StartTime = GetWallClock();
+        meow_u64 Run = 0;
+        while(((RunCount == 0) || (Run < RunCount)) &&
+              ((Seconds == 0.0) || ((GetWallClock() - StartTime) < Seconds)))
+        {
+            size_t Size = MakeRandomCase(&Series, Case, MaxLen);
+            char Failure[256];
+            if(!CheckCase(Case, Size, Failure, sizeof(Failure)))
+            {
+                printf("Case %llu: ", Run);
+                Result = ReportFailure(Case, Size, OutDirectory);
+                break;
+            }
+
+            ++Run;
+            if((Run % 10000) == 0)
+            {
+                fprintf(stderr, "\r%llu cases   ", Run);
+            }
+        }
+        fprintf(stderr, "\r");
+
+        if(!Result)
+        {
+            printf("%llu cases passed in %0.1f seconds\n", Run, GetWallClock() - StartTime);
+        }
+        free(Case);
+    }
+
+    free(Files);
+    return(Result);
+}
+
+#endif
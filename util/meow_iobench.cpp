@@ -0,0 +1,992 @@
+/* ========================================================================
+
+   meow_iobench.cpp - file I/O strategy benchmark for hashing files on disk
+   (C) Copyright 2018-2019 by Molly Rocket, Inc. (https://mollyrocket.com)
+
+   See https://mollyrocket.com/meowhash for details.
+
+   ======================================================================== */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory.h>
+#include <errno.h>
+#if !_WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#if __linux__
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#include "meow_test.h"
+
+//
+// NOTE: Hashing a file is as fast as the slower of the hash and the path the bytes
+// take off the disk, and the second one depends a lot on how they're asked for.
+// This hashes every file in a directory with each of these strategies, once with
+// the page cache emptied of them first (posix_fadvise DONTNEED, so each run starts
+// from the disk) and once warm, and reports end-to-end throughput and the CPU time
+// each strategy costs on top of the hash:
+//
+//   fread:           read the whole file into a fresh buffer (what meow_search does)
+//   mmap:            map the file and hash the mapping, faulting pages in as it goes
+//   mmap populate:   ...with MAP_POPULATE, so it's all read in before hashing starts
+//   mmap sequential: ...with MADV_SEQUENTIAL, so the kernel reads further ahead
+//   pread:           stream the file through one reusable buffer, with MeowAbsorb
+//   O_DIRECT:        ...bypassing the page cache (so it's never warm)
+//   io_uring:        ...keeping several reads in flight at once
+//
+// Every strategy has to produce the same hashes as fread, or it's reported.
+//
+
+#if _WIN32
+
+int
+main(int ArgCount, char **Args)
+{
+    fprintf(stderr, "meow_iobench only supports POSIX systems (io_uring and O_DIRECT need Linux)\n");
+    return(-1);
+}
+
+#else
+
+#define Kb(x) ((meow_u64)(x)*(meow_u64)1024)
+#define Mb(x) ((meow_u64)(x)*(meow_u64)1024*(meow_u64)1024)
+
+#define IOBENCH_DEFAULT_CHUNK_KB 1024
+#define IOBENCH_DEFAULT_DEPTH 8
+#define IOBENCH_DIRECT_ALIGNMENT 4096
+
+#define IOBENCH_DEFAULT_LARGE_COUNT 4
+#define IOBENCH_DEFAULT_LARGE_MB 256
+#define IOBENCH_DEFAULT_SMALL_COUNT 2048
+#define IOBENCH_DEFAULT_SMALL_KB 16
+
+enum io_strategy
+{
+    IO_FRead,
+    IO_MMap,
+    IO_MMapPopulate,
+    IO_MMapSequential,
+    IO_PRead,
+    IO_Direct,
+    IO_Uring,
+
+    IO_StrategyCount,
+};
+
+static char const *IOStrategyNames[] =
+{
+    "fread",
+    "mmap",
+    "mmap populate",
+    "mmap sequential",
+    "pread",
+    "O_DIRECT",
+    "io_uring",
+};
+
+struct bench_file
+{
+    char *Path;
+    meow_u64 Size;
+    meow_u128 Hash;
+};
+
+//
+// NOTE: io_uring, straight from the system calls, so there's no liburing dependency
+//
+
+#if __linux__
+struct io_ring
+{
+    int FD;
+    meow_u32 Entries;
+
+    meow_u32 *SQHead;
+    meow_u32 *SQTail;
+    meow_u32 *SQMask;
+    meow_u32 *SQArray;
+    io_uring_sqe *SQEs;
+
+    meow_u32 *CQHead;
+    meow_u32 *CQTail;
+    meow_u32 *CQMask;
+    io_uring_cqe *CQEs;
+
+    void *SQRing;
+    size_t SQRingSize;
+    void *CQRing;
+    size_t CQRingSize;
+    size_t SQEsSize;
+};
+
+static int
+OpenIORing(io_ring *Ring, meow_u32 Entries)
+{
+    int Result = 0;
+
+    memset(Ring, 0, sizeof(*Ring));
+    io_uring_params Params = {};
+    Ring->FD = (int)syscall(__NR_io_uring_setup, Entries, &Params);
+    if(Ring->FD >= 0)
+    {
+        Ring->Entries = Params.sq_entries;
+        Ring->SQRingSize = Params.sq_off.array + Params.sq_entries*sizeof(meow_u32);
+        Ring->CQRingSize = Params.cq_off.cqes + Params.cq_entries*sizeof(io_uring_cqe);
+        Ring->SQEsSize = Params.sq_entries*sizeof(io_uring_sqe);
+
+        // NOTE: Newer kernels map both rings with one mmap
+        int SingleMap = (Params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(SingleMap && (Ring->CQRingSize > Ring->SQRingSize))
+        {
+            Ring->SQRingSize = Ring->CQRingSize;
+        }
+
+        Ring->SQRing = mmap(0, Ring->SQRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->FD, IORING_OFF_SQ_RING);
+        Ring->CQRing = SingleMap ? Ring->SQRing :
+            mmap(0, Ring->CQRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->FD, IORING_OFF_CQ_RING);
+        Ring->SQEs = (io_uring_sqe *)mmap(0, Ring->SQEsSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->FD, IORING_OFF_SQES);
+        if((Ring->SQRing != MAP_FAILED) && (Ring->CQRing != MAP_FAILED) && (Ring->SQEs != MAP_FAILED))
+        {
+            meow_u8 *SQ = (meow_u8 *)Ring->SQRing;
+            meow_u8 *CQ = (meow_u8 *)Ring->CQRing;
+            Ring->SQHead = (meow_u32 *)(SQ + Params.sq_off.head);
+            Ring->SQTail = (meow_u32 *)(SQ + Params.sq_off.tail);
+            Ring->SQMask = (meow_u32 *)(SQ + Params.sq_off.ring_mask);
+            Ring->SQArray = (meow_u32 *)(SQ + Params.sq_off.array);
+            Ring->CQHead = (meow_u32 *)(CQ + Params.cq_off.head);
+            Ring->CQTail = (meow_u32 *)(CQ + Params.cq_off.tail);
+            Ring->CQMask = (meow_u32 *)(CQ + Params.cq_off.ring_mask);
+            Ring->CQEs = (io_uring_cqe *)(CQ + Params.cq_off.cqes);
+            Result = 1;
+        }
+        else
+        {
+            close(Ring->FD);
+            Ring->FD = -1;
+        }
+    }
+
+    return(Result);
+}
+
+static void
+CloseIORing(io_ring *Ring)
+{
+    if(Ring->FD >= 0)
+    {
+        munmap(Ring->SQEs, Ring->SQEsSize);
+        if(Ring->CQRing != Ring->SQRing)
+        {
+            munmap(Ring->CQRing, Ring->CQRingSize);
+        }
+        munmap(Ring->SQRing, Ring->SQRingSize);
+        close(Ring->FD);
+        Ring->FD = -1;
+    }
+}
+
+static void
+QueueIORingRead(io_ring *Ring, int FD, void *Dest, meow_u32 Size, meow_u64 Offset, meow_u64 UserData)
+{
+    meow_u32 Tail = *Ring->SQTail;
+    meow_u32 Index = Tail & *Ring->SQMask;
+    io_uring_sqe *SQE = Ring->SQEs + Index;
+    memset(SQE, 0, sizeof(*SQE));
+    SQE->opcode = IORING_OP_READ;
+    SQE->fd = FD;
+    SQE->addr = (meow_u64)Dest;
+    SQE->len = Size;
+    SQE->off = Offset;
+    SQE->user_data = UserData;
+    Ring->SQArray[Index] = Index;
+
+    // NOTE: The kernel must see the entry before it sees the new tail
+    __atomic_store_n(Ring->SQTail, Tail + 1, __ATOMIC_RELEASE);
+}
+#endif
+
+//
+// NOTE: Per-strategy hashing
+//
+
+struct io_context
+{
+    meow_u64 ChunkSize;
+    meow_u32 Depth;
+    meow_u8 *Buffers;
+#if __linux__
+    io_ring Ring;
+    int RingOk;
+    int *ChunkResults;
+    int *ChunkReady;
+#endif
+};
+
+static int
+HashByFRead(bench_file *File, meow_u128 *Hash)
+{
+    int Result = 0;
+
+    FILE *Handle = fopen(File->Path, "rb");
+    if(Handle)
+    {
+        void *Contents = aligned_alloc(CACHE_LINE_ALIGNMENT, File->Size ? File->Size : 1);
+        if(Contents)
+        {
+            if((File->Size == 0) || (fread(Contents, File->Size, 1, Handle) == 1))
+            {
+                *Hash = MeowHash(MeowDefaultSeed, File->Size, Contents);
+                Result = 1;
+            }
+            free(Contents);
+        }
+        fclose(Handle);
+    }
+
+    return(Result);
+}
+
+static int
+HashByMMap(bench_file *File, int Strategy, meow_u128 *Hash)
+{
+    int Result = 0;
+
+    int FD = open(File->Path, O_RDONLY);
+    if(FD >= 0)
+    {
+        if(File->Size == 0)
+        {
+            *Hash = MeowHash(MeowDefaultSeed, 0, 0);
+            Result = 1;
+        }
+        else
+        {
+            int Flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if(Strategy == IO_MMapPopulate)
+            {
+                Flags |= MAP_POPULATE;
+            }
+#endif
+            // NOTE: The hash may read past the end of the file, but only within its
+            // last page, and a mapping's last page reads as zeroes past the end
+            void *Mapped = mmap(0, File->Size, PROT_READ, Flags, FD, 0);
+            if(Mapped != MAP_FAILED)
+            {
+                if(Strategy == IO_MMapSequential)
+                {
+                    madvise(Mapped, File->Size, MADV_SEQUENTIAL);
+                }
+                *Hash = MeowHash(MeowDefaultSeed, File->Size, Mapped);
+                munmap(Mapped, File->Size);
+                Result = 1;
+            }
+        }
+        close(FD);
+    }
+
+    return(Result);
+}
+
+static int
+HashByPRead(bench_file *File, io_context *Context, int Direct, meow_u128 *Hash)
+{
+    int Result = 0;
+
+    int Flags = O_RDONLY;
+#ifdef O_DIRECT
+    if(Direct)
+    {
+        Flags |= O_DIRECT;
+    }
+#endif
+    int FD = open(File->Path, Flags);
+    if(FD >= 0)
+    {
+        meow_state State;
+        MeowBegin(&State, MeowDefaultSeed);
+
+        // NOTE: O_DIRECT needs aligned offsets, sizes and buffers; the chunk size and
+        // the buffer are both aligned, so only the last read comes back short
+        Result = 1;
+        meow_u64 Offset = 0;
+        while(Offset < File->Size)
+        {
+            ssize_t Amount = pread(FD, Context->Buffers, Context->ChunkSize, Offset);
+            if(Amount <= 0)
+            {
+                Result = 0;
+                break;
+            }
+
+            MeowAbsorb(&State, Amount, Context->Buffers);
+            Offset += Amount;
+        }
+
+        if(Result)
+        {
+            *Hash = MeowEnd(&State, 0);
+        }
+        close(FD);
+    }
+
+    return(Result);
+}
+
+#if __linux__
+static int
+HashByIOUring(bench_file *File, io_context *Context, meow_u128 *Hash)
+{
+    int Result = 0;
+
+    io_ring *Ring = &Context->Ring;
+    int FD = open(File->Path, O_RDONLY);
+    if(Context->RingOk && (FD >= 0))
+    {
+        meow_state State;
+        MeowBegin(&State, MeowDefaultSeed);
+
+        // NOTE: Chunk N is read into buffer N % Depth, and chunks can complete in any
+        // order, but they have to be absorbed in order; a buffer is only reused once
+        // its chunk has been absorbed.
+        meow_u64 ChunkCount = (File->Size + Context->ChunkSize - 1) / Context->ChunkSize;
+        meow_u64 NextSubmit = 0;
+        meow_u64 NextAbsorb = 0;
+        meow_u32 InFlight = 0;
+        memset(Context->ChunkReady, 0, Context->Depth*sizeof(int));
+
+        Result = 1;
+        while(Result && (NextAbsorb < ChunkCount))
+        {
+            meow_u32 Submitted = 0;
+            while((NextSubmit < ChunkCount) && (NextSubmit < (NextAbsorb + Context->Depth)))
+            {
+                meow_u64 Offset = NextSubmit*Context->ChunkSize;
+                meow_u64 Remaining = File->Size - Offset;
+                meow_u32 Size = (meow_u32)((Remaining < Context->ChunkSize) ? Remaining : Context->ChunkSize);
+                meow_u8 *Dest = Context->Buffers + (NextSubmit % Context->Depth)*Context->ChunkSize;
+                QueueIORingRead(Ring, FD, Dest, Size, Offset, NextSubmit);
+                ++NextSubmit;
+                ++Submitted;
+                ++InFlight;
+            }
+
+            if(syscall(__NR_io_uring_enter, Ring->FD, Submitted, 1, IORING_ENTER_GETEVENTS, 0, 0) < 0)
+            {
+                Result = 0;
+                break;
+            }
+
+            meow_u32 Head = *Ring->CQHead;
+            while(Head != __atomic_load_n(Ring->CQTail, __ATOMIC_ACQUIRE))
+            {
+                io_uring_cqe *CQE = Ring->CQEs + (Head & *Ring->CQMask);
+                meow_u32 Slot = (meow_u32)(CQE->user_data % Context->Depth);
+                Context->ChunkResults[Slot] = CQE->res;
+                Context->ChunkReady[Slot] = 1;
+                ++Head;
+                --InFlight;
+            }
+            __atomic_store_n(Ring->CQHead, Head, __ATOMIC_RELEASE);
+
+            while((NextAbsorb < ChunkCount) && Context->ChunkReady[NextAbsorb % Context->Depth])
+            {
+                meow_u32 Slot = (meow_u32)(NextAbsorb % Context->Depth);
+                meow_u64 Offset = NextAbsorb*Context->ChunkSize;
+                meow_u64 Remaining = File->Size - Offset;
+                meow_u64 Expected = (Remaining < Context->ChunkSize) ? Remaining : Context->ChunkSize;
+                if((meow_u64)Context->ChunkResults[Slot] != Expected)
+                {
+                    // NOTE: Errors and short reads (the file changed, most likely) both fail the file
+                    Result = 0;
+                    break;
+                }
+
+                MeowAbsorb(&State, Expected, Context->Buffers + Slot*Context->ChunkSize);
+                Context->ChunkReady[Slot] = 0;
+                ++NextAbsorb;
+            }
+        }
+
+        // NOTE: Don't let reads still in flight land in buffers after we've moved on.
+        // Chunks that completed but weren't absorbed (after a failed one) aren't in
+        // flight, so only the submitted-but-unreaped reads are waited for.
+        while(InFlight)
+        {
+            if((syscall(__NR_io_uring_enter, Ring->FD, 0, 1, IORING_ENTER_GETEVENTS, 0, 0) < 0) &&
+               (errno != EINTR))
+            {
+                // NOTE: Their completions could land in a later file's reads, so the ring
+                // can't be used again
+                fprintf(stderr, "ERROR: io_uring_enter failed with reads in flight (%s)\n", strerror(errno));
+                Context->RingOk = 0;
+                Result = 0;
+                break;
+            }
+
+            meow_u32 Head = *Ring->CQHead;
+            while(Head != __atomic_load_n(Ring->CQTail, __ATOMIC_ACQUIRE))
+            {
+                ++Head;
+                --InFlight;
+            }
+            __atomic_store_n(Ring->CQHead, Head, __ATOMIC_RELEASE);
+        }
+
+        if(Result)
+        {
+            *Hash = MeowEnd(&State, 0);
+        }
+    }
+
+    if(FD >= 0)
+    {
+        close(FD);
+    }
+
+    return(Result);
+}
+#endif
+
+static int
+HashFileWith(int Strategy, io_context *Context, bench_file *File, meow_u128 *Hash)
+{
+    int Result = 0;
+    switch(Strategy)
+    {
+        case IO_FRead: {Result = HashByFRead(File, Hash);} break;
+        case IO_MMap:
+        case IO_MMapPopulate:
+        case IO_MMapSequential: {Result = HashByMMap(File, Strategy, Hash);} break;
+        case IO_PRead: {Result = HashByPRead(File, Context, 0, Hash);} break;
+        case IO_Direct: {Result = HashByPRead(File, Context, 1, Hash);} break;
+#if __linux__
+        case IO_Uring: {Result = HashByIOUring(File, Context, Hash);} break;
+#endif
+    }
+
+    return(Result);
+}
+
+static int
+StrategyIsAvailable(int Strategy, io_context *Context, bench_file *Files, int FileCount)
+{
+    int Result = 1;
+    if(Strategy == IO_Direct)
+    {
+#ifdef O_DIRECT
+        // NOTE: Some filesystems (tmpfs, for one) refuse O_DIRECT
+        int FD = FileCount ? open(Files[0].Path, O_RDONLY|O_DIRECT) : -1;
+        Result = (FD >= 0);
+        if(FD >= 0)
+        {
+            close(FD);
+        }
+#else
+        Result = 0;
+#endif
+    }
+    else if(Strategy == IO_Uring)
+    {
+#if __linux__
+        Result = Context->RingOk;
+#else
+        Result = 0;
+#endif
+    }
+
+    return(Result);
+}
+
+//
+// NOTE: Self-check.  Every strategy that reads has to fail a file that comes back
+// shorter than expected, and one whose reads return errors, rather than hash what
+// it got or wait for reads that never finish.  The mmap strategies are left out,
+// since mapping past the end of a file faults instead of reading short.
+//
+
+static int
+CheckFailureHandling(io_context *Context, char *Directory, bench_file *Files, int FileCount)
+{
+    int Result = 1;
+
+    // NOTE: The first file, expecting a few more chunks than it has, and the
+    // directory itself, which opens but can't be read
+    bench_file Short = Files[0];
+    Short.Size += 3*Context->ChunkSize + 1;
+    bench_file Unreadable = {Directory, 2*Context->ChunkSize};
+    bench_file *BadFiles[] = {&Short, &Unreadable};
+    char const *BadNames[] = {"a short read", "a read error"};
+
+    int Strategies[] = {IO_FRead, IO_PRead, IO_Direct, IO_Uring};
+    for(int StrategyIndex = 0;
+        StrategyIndex < (int)ArrayCount(Strategies);
+        ++StrategyIndex)
+    {
+        int Strategy = Strategies[StrategyIndex];
+        if(StrategyIsAvailable(Strategy, Context, Files, FileCount))
+        {
+            for(int BadIndex = 0;
+                BadIndex < (int)ArrayCount(BadFiles);
+                ++BadIndex)
+            {
+                meow_u128 Hash;
+                if(HashFileWith(Strategy, Context, BadFiles[BadIndex], &Hash))
+                {
+                    fprintf(stdout, "SELF-CHECK FAILED: %s hashed a file despite %s\n",
+                            IOStrategyNames[Strategy], BadNames[BadIndex]);
+                    Result = 0;
+                }
+            }
+        }
+    }
+
+    return(Result);
+}
+
+//
+// NOTE: Test files and the page cache
+//
+
+static void
+DropFromPageCache(bench_file *Files, int FileCount)
+{
+    for(int FileIndex = 0;
+        FileIndex < FileCount;
+        ++FileIndex)
+    {
+        int FD = open(Files[FileIndex].Path, O_RDONLY);
+        if(FD >= 0)
+        {
+            // NOTE: Dirty pages can't be dropped, so make sure there aren't any
+            fdatasync(FD);
+            posix_fadvise(FD, 0, 0, POSIX_FADV_DONTNEED);
+            close(FD);
+        }
+    }
+}
+
+static int
+WriteTestFile(char *Directory, char const *Prefix, int Index, meow_u64 Size, meow_u8 *Block, meow_u64 BlockSize)
+{
+    int Result = 0;
+
+    char Path[4096];
+    snprintf(Path, sizeof(Path), "%s/meow_iobench_%s_%04d", Directory, Prefix, Index);
+    FILE *File = fopen(Path, "wb");
+    if(File)
+    {
+        Result = 1;
+        meow_u64 Remaining = Size;
+        while(Result && Remaining)
+        {
+            // NOTE: Vary each block a little, so no two blocks or files are the same
+            ((meow_u64 *)Block)[0] = Size - Remaining;
+            ((meow_u64 *)Block)[1] = Index;
+            meow_u64 Amount = (Remaining < BlockSize) ? Remaining : BlockSize;
+            Result = (fwrite(Block, Amount, 1, File) == 1);
+            Remaining -= Amount;
+        }
+
+        fflush(File);
+        fsync(fileno(File));
+        fclose(File);
+    }
+
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to write %s\n", Path);
+    }
+    return(Result);
+}
+
+static int
+GenerateTestFiles(char *Directory, int LargeCount, meow_u64 LargeSize, int SmallCount, meow_u64 SmallSize)
+{
+    int Result = 1;
+
+    meow_u64 BlockSize = 1024*1024;
+    meow_u8 *Block = (meow_u8 *)malloc(BlockSize);
+    meow_u64 Series = 0x9e3779b97f4a7c15ULL;
+    for(meow_u64 Index = 0;
+        Index < BlockSize;
+        ++Index)
+    {
+        Series = Series*6364136223846793005ULL + 1442695040888963407ULL;
+        Block[Index] = (meow_u8)(Series >> 56);
+    }
+
+    fprintf(stdout, "Writing %d ", LargeCount);
+    PrintSize(stdout, (double)LargeSize, false);
+    fprintf(stdout, " and %d ", SmallCount);
+    PrintSize(stdout, (double)SmallSize, false);
+    fprintf(stdout, " files to %s...\n", Directory);
+    fflush(stdout);
+
+    for(int Index = 0;
+        Result && (Index < LargeCount);
+        ++Index)
+    {
+        Result = WriteTestFile(Directory, "large", Index, LargeSize, Block, BlockSize);
+    }
+    for(int Index = 0;
+        Result && (Index < SmallCount);
+        ++Index)
+    {
+        Result = WriteTestFile(Directory, "small", Index, SmallSize, Block, BlockSize);
+    }
+
+    free(Block);
+    return(Result);
+}
+
+static int
+CompareBenchFiles(const void *AInit, const void *BInit)
+{
+    bench_file *A = (bench_file *)AInit;
+    bench_file *B = (bench_file *)BInit;
+    int Result = strcmp(A->Path, B->Path);
+    return(Result);
+}
+
+static bench_file *
+ListFiles(char *Directory, int *FileCount)
+{
+    int Count = 0;
+    int Max = 0;
+    bench_file *Result = 0;
+
+    DIR *Dir = opendir(Directory);
+    if(Dir)
+    {
+        while(dirent *Entry = readdir(Dir))
+        {
+            size_t PathSize = strlen(Directory) + strlen(Entry->d_name) + 2;
+            char *Path = (char *)malloc(PathSize);
+            snprintf(Path, PathSize, "%s/%s", Directory, Entry->d_name);
+
+            struct stat Stat;
+            if((stat(Path, &Stat) == 0) && S_ISREG(Stat.st_mode))
+            {
+                if(Count == Max)
+                {
+                    Max = Max ? 2*Max : 256;
+                    Result = (bench_file *)realloc(Result, Max*sizeof(bench_file));
+                }
+                bench_file *File = Result + Count++;
+                memset(File, 0, sizeof(*File));
+                File->Path = Path;
+                File->Size = Stat.st_size;
+            }
+            else
+            {
+                free(Path);
+            }
+        }
+        closedir(Dir);
+    }
+
+    if(Count)
+    {
+        qsort(Result, Count, sizeof(bench_file), CompareBenchFiles);
+    }
+
+    *FileCount = Count;
+    return(Result);
+}
+
+//
+// NOTE: Timing
+//
+
+static double
+GetCPUSeconds(void)
+{
+    rusage Usage;
+    getrusage(RUSAGE_SELF, &Usage);
+    double Result = ((double)Usage.ru_utime.tv_sec + 1.0e-6*(double)Usage.ru_utime.tv_usec +
+                     (double)Usage.ru_stime.tv_sec + 1.0e-6*(double)Usage.ru_stime.tv_usec);
+    return(Result);
+}
+
+struct io_pass
+{
+    double Seconds;
+    double CPUSeconds;
+    meow_u64 Bytes;
+    int FailureCount;
+    int MismatchCount;
+};
+
+static io_pass
+RunPass(int Strategy, io_context *Context, bench_file *Files, int FileCount, int Cold)
+{
+    io_pass Result = {};
+
+    if(Cold)
+    {
+        DropFromPageCache(Files, FileCount);
+    }
+
+    double StartCPU = GetCPUSeconds();
+    double StartTime = GetWallClock();
+    for(int FileIndex = 0;
+        FileIndex < FileCount;
+        ++FileIndex)
+    {
+        bench_file *File = Files + FileIndex;
+        meow_u128 Hash;
+        if(HashFileWith(Strategy, Context, File, &Hash))
+        {
+            Result.Bytes += File->Size;
+
+            // NOTE: fread runs first, and the other strategies have to match it
+            if(Strategy == IO_FRead)
+            {
+                File->Hash = Hash;
+            }
+            else if(!MeowHashesAreEqual(Hash, File->Hash))
+            {
+                ++Result.MismatchCount;
+            }
+        }
+        else
+        {
+            ++Result.FailureCount;
+        }
+    }
+    Result.Seconds = GetWallClock() - StartTime;
+    Result.CPUSeconds = GetCPUSeconds() - StartCPU;
+
+    return(Result);
+}
+
+static void
+PrintPass(char const *Name, io_pass *Pass)
+{
+    double Gigabytes = (double)Pass->Bytes / (1024.0*1024.0*1024.0);
+    fprintf(stdout, " %s %7.2f GB/s, %6.3f cpu s/GB (%3.0f%% cpu)", Name,
+            (Pass->Seconds > 0.0) ? (Gigabytes / Pass->Seconds) : 0.0,
+            (Gigabytes > 0.0) ? (Pass->CPUSeconds / Gigabytes) : 0.0,
+            (Pass->Seconds > 0.0) ? (100.0*Pass->CPUSeconds / Pass->Seconds) : 0.0);
+}
+
+int
+main(int ArgCount, char **Args)
+{
+    int Generate = 0;
+    int LargeCount = IOBENCH_DEFAULT_LARGE_COUNT;
+    meow_u64 LargeMB = IOBENCH_DEFAULT_LARGE_MB;
+    int SmallCount = IOBENCH_DEFAULT_SMALL_COUNT;
+    meow_u64 SmallKB = IOBENCH_DEFAULT_SMALL_KB;
+    meow_u64 ChunkKB = IOBENCH_DEFAULT_CHUNK_KB;
+    int Depth = IOBENCH_DEFAULT_DEPTH;
+    int RunCold = 1;
+    int RunWarm = 1;
+    char *CSVFileName = 0;
+    char *Directory = 0;
+    int ArgsOk = 1;
+    for(int ArgIndex = 1;
+        ArgIndex < ArgCount;
+        ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if(strcmp(Arg, "-generate") == 0)
+        {
+            Generate = 1;
+        }
+        else if((strcmp(Arg, "-large") == 0) && ((ArgIndex + 2) < ArgCount))
+        {
+            LargeCount = atoi(Args[++ArgIndex]);
+            LargeMB = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-small") == 0) && ((ArgIndex + 2) < ArgCount))
+        {
+            SmallCount = atoi(Args[++ArgIndex]);
+            SmallKB = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-chunk") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ChunkKB = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-depth") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            Depth = atoi(Args[++ArgIndex]);
+        }
+        else if(strcmp(Arg, "-cold-only") == 0)
+        {
+            RunWarm = 0;
+        }
+        else if(strcmp(Arg, "-warm-only") == 0)
+        {
+            RunCold = 0;
+        }
+        else if((strcmp(Arg, "-csv") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            CSVFileName = Args[++ArgIndex];
+        }
+        else if((Arg[0] != '-') && !Directory)
+        {
+            Directory = Arg;
+        }
+        else
+        {
+            ArgsOk = 0;
+        }
+    }
+
+    // NOTE: Chunks are 4kb multiples so O_DIRECT can use them, and io_uring reads are at most 2gb
+    if((ChunkKB < 4) || (ChunkKB % 4) || (ChunkKB > 1024*1024) || (Depth < 1) || (Depth > 4096) ||
+       (LargeCount < 0) || (SmallCount < 0) || !(RunCold || RunWarm))
+    {
+        ArgsOk = 0;
+    }
+
+    if(!ArgsOk || !Directory)
+    {
+        fprintf(stderr, "Usage: %s [-generate [-large <count> <mb>] [-small <count> <kb>]] [-chunk <kb>] [-depth <count>]\n"
+                "       [-cold-only | -warm-only] [-csv <file>] <directory>\n", Args[0]);
+        fprintf(stderr, "    Hashes every file in the directory with each I/O strategy, cold and warm\n");
+        fprintf(stderr, "    -generate: first write %d %dmb and %d %dkb test files there (or as given)\n",
+                IOBENCH_DEFAULT_LARGE_COUNT, IOBENCH_DEFAULT_LARGE_MB, IOBENCH_DEFAULT_SMALL_COUNT, IOBENCH_DEFAULT_SMALL_KB);
+        fprintf(stderr, "    -chunk: read size for pread, O_DIRECT and io_uring, a multiple of 4 (default %dkb)\n", IOBENCH_DEFAULT_CHUNK_KB);
+        fprintf(stderr, "    -depth: reads io_uring keeps in flight (default %d)\n", IOBENCH_DEFAULT_DEPTH);
+        fprintf(stderr, "    -cold-only, -warm-only: skip the other pass (cold passes drop the files from\n");
+        fprintf(stderr, "                            the page cache first)\n");
+        return(-1);
+    }
+
+    fprintf(stdout, "meow_iobench %s - file I/O strategies for hashing with the Meow hash\n", MEOW_HASH_VERSION_NAME);
+
+    if(Generate && !GenerateTestFiles(Directory, LargeCount, Mb(LargeMB), SmallCount, Kb(SmallKB)))
+    {
+        return(-1);
+    }
+
+    int FileCount = 0;
+    bench_file *Files = ListFiles(Directory, &FileCount);
+    if(!FileCount)
+    {
+        fprintf(stderr, "ERROR: No files in %s (try -generate)\n", Directory);
+        return(-1);
+    }
+
+    meow_u64 TotalSize = 0;
+    for(int FileIndex = 0;
+        FileIndex < FileCount;
+        ++FileIndex)
+    {
+        TotalSize += Files[FileIndex].Size;
+    }
+    fprintf(stdout, "%d files, ", FileCount);
+    PrintSize(stdout, (double)TotalSize, false);
+    fprintf(stdout, " total, ");
+    PrintSize(stdout, (double)ChunkKB*1024.0, false);
+    fprintf(stdout, " chunks, io_uring depth %d\n\n", Depth);
+
+    io_context Context = {};
+    Context.ChunkSize = Kb(ChunkKB);
+    Context.Depth = Depth;
+    Context.Buffers = (meow_u8 *)aligned_alloc(IOBENCH_DIRECT_ALIGNMENT, Context.ChunkSize*Depth);
+#if __linux__
+    Context.RingOk = OpenIORing(&Context.Ring, Depth);
+    Context.ChunkResults = (int *)malloc(Depth*sizeof(int));
+    Context.ChunkReady = (int *)malloc(Depth*sizeof(int));
+#endif
+
+    FILE *CSV = 0;
+    if(CSVFileName)
+    {
+        CSV = fopen(CSVFileName, "w");
+        if(CSV)
+        {
+            fprintf(CSV, "Strategy,Cache,Files,Bytes,Seconds,CPU seconds,GB/s,CPU s/GB,Failures,Mismatches\n");
+        }
+        else
+        {
+            fprintf(stderr, "    (unable to open %s for writing)\n", CSVFileName);
+        }
+    }
+
+    int Result = 0;
+    if(!CheckFailureHandling(&Context, Directory, Files, FileCount))
+    {
+        Result = 1;
+    }
+
+    for(int Strategy = 0;
+        Strategy < IO_StrategyCount;
+        ++Strategy)
+    {
+        fprintf(stdout, "%-16s", IOStrategyNames[Strategy]);
+        if(!StrategyIsAvailable(Strategy, &Context, Files, FileCount))
+        {
+            fprintf(stdout, " not available on this system or filesystem\n");
+            continue;
+        }
+
+        // NOTE: fread comes first and sets the reference hashes from whichever pass runs
+        for(int Cold = 1;
+            Cold >= 0;
+            --Cold)
+        {
+            if(Cold ? !RunCold : !RunWarm)
+            {
+                continue;
+            }
+
+            io_pass Pass = RunPass(Strategy, &Context, Files, FileCount, Cold);
+            PrintPass(Cold ? "cold:" : "warm:", &Pass);
+            if(Pass.FailureCount || Pass.MismatchCount)
+            {
+                fprintf(stdout, " [%d failed, %d HASH MISMATCHES]", Pass.FailureCount, Pass.MismatchCount);
+                Result = 1;
+            }
+            fflush(stdout);
+
+            if(CSV)
+            {
+                double Gigabytes = (double)Pass.Bytes / (1024.0*1024.0*1024.0);
+                fprintf(CSV, "%s,%s,%d,%.0f,%f,%f,%f,%f,%d,%d\n", IOStrategyNames[Strategy], Cold ? "cold" : "warm",
+                        FileCount, (double)Pass.Bytes, Pass.Seconds, Pass.CPUSeconds,
+                        (Pass.Seconds > 0.0) ? (Gigabytes / Pass.Seconds) : 0.0,
+                        (Gigabytes > 0.0) ? (Pass.CPUSeconds / Gigabytes) : 0.0,
+                        Pass.FailureCount, Pass.MismatchCount);
+            }
+        }
+        fprintf(stdout, "\n");
+    }
+
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+
+#if __linux__
+    CloseIORing(&Context.Ring);
+    free(Context.ChunkResults);
+    free(Context.ChunkReady);
+#endif
+    free(Context.Buffers);
+    for(int FileIndex = 0;
+        FileIndex < FileCount;
+        ++FileIndex)
+    {
+        free(Files[FileIndex].Path);
+    }
+    free(Files);
+
+    return(Result);
+}
+
+#endif
@@ -0,0 +1,697 @@
+/* ========================================================================
+
+   meow_kat.cpp - known-answer test vectors for Meow hash implementations
+   (C) Copyright 2018-2019 by Molly Rocket, Inc. (https://mollyrocket.com)
+
+   See https://mollyrocket.com/meowhash for details.
+
+   ======================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+
+#include "meow_test.h"
+
+//
+// NOTE: A port or a new kernel can't be checked against this header on a machine
+// that can't run it, so this writes out what the header computes as a file of
+// known answers, and checks every implementation in NamedHashTypes that has a
+// Reference against such a file without running the reference at all:
+//
+//     meow_kat -generate [<name>]    writes <name>.bin and <name>.txt (default util/meow_kat)
+//     meow_kat [<name>.bin]          checks against it (default util/meow_kat.bin)
+//
+// The vectors cover the default seed and seeds from MeowExpandSeed, every length
+// from 0 to 4096 and a few large ones past the prefetch window, each hashed from a
+// different offset from a cache line.  The input is never stored: byte i of every
+// input is byte (i % 8) of the (i / 8 + 1)th output of splitmix64 started at zero,
+// taken little-endian, so the same bytes are easy to make in any language.
+//
+// The .bin file is little-endian throughout:
+//
+//   8 bytes      "MEOWKAT1"
+//   4 bytes      seed count, then for each seed:
+//                  4 bytes    MeowExpandSeed input length (0 for MeowDefaultSeed)
+//                  n bytes    the input
+//                  128 bytes  the seed
+//   4 bytes      vector count, then for each vector:
+//                  8 bytes    length
+//                  1 byte     seed index
+//                  1 byte     offset of the input from a 128-byte boundary
+//                  16 bytes   the hash, as stored to memory
+//
+// The .txt file has the same seeds and vectors, for reading, with the hashes
+// written the way PrintHash writes them.
+//
+
+#define KAT_MAGIC "MEOWKAT1"
+#define KAT_SMALL_LENGTHS 4097
+
+// NOTE: Files from elsewhere are checked against this before anything is allocated
+// for their inputs; it's well past the largest length -generate writes
+#define KAT_MAX_LENGTH (256ull*1024*1024)
+
+#define KAT_SEED_MIN_SIZE (4 + 128)
+#define KAT_VECTOR_SIZE (8 + 1 + 1 + 16)
+
+static meow_u64 KATLargeLengths[] =
+{
+    16384 + 7,
+    262144 + 1,
+    1048576 + 15,
+    16777216 + 127,
+    67108864 + 4095,
+};
+
+struct kat_seed
+{
+    meow_u32 InputLen;
+    meow_u8 *Input;
+    meow_u8 Seed128[128];
+};
+
+struct kat_vector
+{
+    meow_u64 Len;
+    meow_u8 SeedIndex;
+    meow_u8 Offset;
+    meow_u8 Hash[16];
+};
+
+struct kat_file
+{
+    meow_u32 SeedCount;
+    kat_seed *Seeds;
+
+    meow_u32 VectorCount;
+    kat_vector *Vectors;
+
+    meow_u64 MaxLen;
+};
+
+static void
+FillKATInput(meow_u8 *Dest, meow_u64 Len)
+{
+    meow_u64 Series = 0;
+    for(meow_u64 At = 0;
+        At < Len;
+        At += 8)
+    {
+        // NOTE: splitmix64
+        meow_u64 Z = (Series += 0x9e3779b97f4a7c15ull);
+        Z = (Z ^ (Z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        Z = (Z ^ (Z >> 27)) * 0x94d049bb133111ebull;
+        Z = (Z ^ (Z >> 31));
+
+        for(int Byte = 0;
+            (Byte < 8) && ((At + Byte) < Len);
+            ++Byte)
+        {
+            Dest[At + Byte] = (meow_u8)(Z >> (8*Byte));
+        }
+    }
+}
+
+static meow_u8 *
+AllocKATBuffer(meow_u64 Len, meow_u8 **Base)
+{
+    *Base = (meow_u8 *)malloc(Len + 2*CACHE_LINE_ALIGNMENT);
+    meow_u8 *Result = 0;
+    if(*Base)
+    {
+        Result = (meow_u8 *)(((meow_umm)*Base + CACHE_LINE_ALIGNMENT - 1) & ~(meow_umm)(CACHE_LINE_ALIGNMENT - 1));
+    }
+    return(Result);
+}
+
+//
+// NOTE: Generating
+//
+
+static void
+WriteU32(FILE *File, meow_u32 Value)
+{
+    meow_u8 Bytes[4];
+    for(int Byte = 0;
+        Byte < 4;
+        ++Byte)
+    {
+        Bytes[Byte] = (meow_u8)(Value >> (8*Byte));
+    }
+    fwrite(Bytes, sizeof(Bytes), 1, File);
+}
+
+static void
+WriteU64(FILE *File, meow_u64 Value)
+{
+    WriteU32(File, (meow_u32)Value);
+    WriteU32(File, (meow_u32)(Value >> 32));
+}
+
+static void
+WriteHex(FILE *File, meow_u8 *Bytes, meow_u32 Count)
+{
+    for(meow_u32 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        fprintf(File, "%02X", Bytes[Index]);
+    }
+}
+
+static int
+GenerateKAT(char *Name)
+{
+    int Result = 0;
+
+    kat_file KAT = {};
+
+    // NOTE: The default seed, and ones expanded from a short input and from one
+    // longer than the 256 bytes MeowExpandSeed absorbs per pass
+    static meow_u8 ShortInput[] = {'m', 'e', 'o', 'w'};
+    static meow_u8 LongInput[300];
+    FillKATInput(LongInput, sizeof(LongInput));
+
+    kat_seed Seeds[3] = {};
+    memcpy(Seeds[0].Seed128, MeowDefaultSeed, sizeof(Seeds[0].Seed128));
+    Seeds[1].InputLen = sizeof(ShortInput);
+    Seeds[1].Input = ShortInput;
+    Seeds[2].InputLen = sizeof(LongInput);
+    Seeds[2].Input = LongInput;
+    for(int SeedIndex = 1;
+        SeedIndex < ArrayCount(Seeds);
+        ++SeedIndex)
+    {
+        MeowExpandSeed(Seeds[SeedIndex].InputLen, Seeds[SeedIndex].Input, Seeds[SeedIndex].Seed128);
+    }
+    KAT.SeedCount = ArrayCount(Seeds);
+    KAT.Seeds = Seeds;
+
+    KAT.VectorCount = KAT.SeedCount*(KAT_SMALL_LENGTHS + ArrayCount(KATLargeLengths));
+    KAT.Vectors = (kat_vector *)calloc(KAT.VectorCount, sizeof(kat_vector));
+    KAT.MaxLen = KATLargeLengths[ArrayCount(KATLargeLengths) - 1];
+
+    meow_u8 *InputBase;
+    meow_u8 *PlacedBase;
+    meow_u8 *Input = AllocKATBuffer(KAT.MaxLen, &InputBase);
+    meow_u8 *Placed = AllocKATBuffer(KAT.MaxLen, &PlacedBase);
+    if(KAT.Vectors && Input && Placed)
+    {
+        FillKATInput(Input, KAT.MaxLen);
+
+        meow_u32 VectorIndex = 0;
+        for(meow_u32 SeedIndex = 0;
+            SeedIndex < KAT.SeedCount;
+            ++SeedIndex)
+        {
+            for(meow_u32 LenIndex = 0;
+                LenIndex < (KAT_SMALL_LENGTHS + ArrayCount(KATLargeLengths));
+                ++LenIndex)
+            {
+                kat_vector *Vector = KAT.Vectors + VectorIndex++;
+                Vector->Len = (LenIndex < KAT_SMALL_LENGTHS) ? LenIndex : KATLargeLengths[LenIndex - KAT_SMALL_LENGTHS];
+                Vector->SeedIndex = (meow_u8)SeedIndex;
+                Vector->Offset = (meow_u8)((Vector->Len*37 + SeedIndex*11) % 64);
+
+                memcpy(Placed + Vector->Offset, Input, Vector->Len);
+                meow_u128 Hash = MeowHash(KAT.Seeds[SeedIndex].Seed128, Vector->Len, Placed + Vector->Offset);
+                _mm_storeu_si128((__m128i *)Vector->Hash, Hash);
+            }
+        }
+
+        char BinName[4096];
+        char TextName[4096];
+        snprintf(BinName, sizeof(BinName), "%s.bin", Name);
+        snprintf(TextName, sizeof(TextName), "%s.txt", Name);
+        FILE *Bin = fopen(BinName, "wb");
+        FILE *Text = fopen(TextName, "wb");
+        if(Bin && Text)
+        {
+            fwrite(KAT_MAGIC, 8, 1, Bin);
+            WriteU32(Bin, KAT.SeedCount);
+            for(meow_u32 SeedIndex = 0;
+                SeedIndex < KAT.SeedCount;
+                ++SeedIndex)
+            {
+                kat_seed *Seed = KAT.Seeds + SeedIndex;
+                WriteU32(Bin, Seed->InputLen);
+                fwrite(Seed->Input, Seed->InputLen, 1, Bin);
+                fwrite(Seed->Seed128, sizeof(Seed->Seed128), 1, Bin);
+            }
+            WriteU32(Bin, KAT.VectorCount);
+            for(meow_u32 VectorIndex = 0;
+                VectorIndex < KAT.VectorCount;
+                ++VectorIndex)
+            {
+                kat_vector *Vector = KAT.Vectors + VectorIndex;
+                WriteU64(Bin, Vector->Len);
+                fwrite(&Vector->SeedIndex, 1, 1, Bin);
+                fwrite(&Vector->Offset, 1, 1, Bin);
+                fwrite(Vector->Hash, sizeof(Vector->Hash), 1, Bin);
+            }
+
+            fprintf(Text, "# Meow hash %s known-answer tests, from meow_kat -generate\n", MEOW_HASH_VERSION_NAME);
+            fprintf(Text, "#\n");
+            fprintf(Text, "# Input: byte i is byte (i %% 8) of the (i / 8 + 1)th output of splitmix64 started at zero, little-endian\n");
+            fprintf(Text, "# seed <index> default|expand <input length> <input>, then the 128-byte seed\n");
+            fprintf(Text, "# <seed index> <length> <offset from a 128-byte boundary> <hash, 32-bit words 3 to 0>\n");
+            fprintf(Text, "#\n");
+            for(meow_u32 SeedIndex = 0;
+                SeedIndex < KAT.SeedCount;
+                ++SeedIndex)
+            {
+                kat_seed *Seed = KAT.Seeds + SeedIndex;
+                if(Seed->InputLen)
+                {
+                    fprintf(Text, "seed %u expand %u ", SeedIndex, Seed->InputLen);
+                    WriteHex(Text, Seed->Input, Seed->InputLen);
+                    fprintf(Text, "\n");
+                }
+                else
+                {
+                    fprintf(Text, "seed %u default\n", SeedIndex);
+                }
+
+                for(meow_u32 Row = 0;
+                    Row < 4;
+                    ++Row)
+                {
+                    fprintf(Text, "    ");
+                    WriteHex(Text, Seed->Seed128 + 32*Row, 32);
+                    fprintf(Text, "\n");
+                }
+            }
+            fprintf(Text, "vectors %u\n", KAT.VectorCount);
+            for(meow_u32 VectorIndex = 0;
+                VectorIndex < KAT.VectorCount;
+                ++VectorIndex)
+            {
+                kat_vector *Vector = KAT.Vectors + VectorIndex;
+                fprintf(Text, "%u %llu %u ", Vector->SeedIndex, Vector->Len, Vector->Offset);
+                PrintHash(Text, _mm_loadu_si128((__m128i *)Vector->Hash));
+                fprintf(Text, "\n");
+            }
+
+            printf("Wrote %u vectors over %u seeds to %s and %s\n", KAT.VectorCount, KAT.SeedCount, BinName, TextName);
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to write %s and %s\n", BinName, TextName);
+            Result = 1;
+        }
+
+        if(Bin) fclose(Bin);
+        if(Text) fclose(Text);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %llu bytes for the inputs\n", KAT.MaxLen);
+        Result = 1;
+    }
+
+    free(PlacedBase);
+    free(InputBase);
+    free(KAT.Vectors);
+
+    return(Result);
+}
+
+//
+// NOTE: Checking
+//
+
+struct kat_reader
+{
+    meow_u8 *At;
+    meow_u64 Remaining;
+    int Ok;
+};
+
+static meow_u8 *
+TakeKATBytes(kat_reader *Reader, meow_u64 Count)
+{
+    meow_u8 *Result = 0;
+    if(Reader->Ok && (Count <= Reader->Remaining))
+    {
+        Result = Reader->At;
+        Reader->At += Count;
+        Reader->Remaining -= Count;
+    }
+    else
+    {
+        Reader->Ok = 0;
+    }
+    return(Result);
+}
+
+static meow_u64
+TakeKATValue(kat_reader *Reader, int ByteCount)
+{
+    meow_u64 Result = 0;
+    meow_u8 *Bytes = TakeKATBytes(Reader, ByteCount);
+    if(Bytes)
+    {
+        for(int Byte = 0;
+            Byte < ByteCount;
+            ++Byte)
+        {
+            Result |= (meow_u64)Bytes[Byte] << (8*Byte);
+        }
+    }
+    return(Result);
+}
+
+// NOTE: Points the seed inputs into Contents, which has to stay around.  Returns 0,
+// or what was wrong with the file.
+static char const *
+ParseKAT(meow_u8 *Contents, meow_u64 Size, kat_file *KAT)
+{
+    char const *Result = 0;
+
+    kat_reader Reader = {Contents, Size, 1};
+    meow_u8 *Magic = TakeKATBytes(&Reader, 8);
+    if(!Magic || (memcmp(Magic, KAT_MAGIC, 8) != 0))
+    {
+        Result = "not a meow_kat file";
+    }
+
+    // NOTE: Counts are checked against what's left of the file before they're
+    // allocated for, so a corrupt count can't ask for more than the file could hold
+    if(!Result)
+    {
+        KAT->SeedCount = (meow_u32)TakeKATValue(&Reader, 4);
+        if(!Reader.Ok || (KAT->SeedCount > (Reader.Remaining / KAT_SEED_MIN_SIZE)))
+        {
+            Result = "seed count is larger than the file";
+        }
+        else if(!(KAT->Seeds = (kat_seed *)calloc(KAT->SeedCount ? KAT->SeedCount : 1, sizeof(kat_seed))))
+        {
+            Result = "unable to allocate the seeds";
+        }
+    }
+
+    for(meow_u32 SeedIndex = 0;
+        !Result && (SeedIndex < KAT->SeedCount);
+        ++SeedIndex)
+    {
+        kat_seed *Seed = KAT->Seeds + SeedIndex;
+        Seed->InputLen = (meow_u32)TakeKATValue(&Reader, 4);
+        Seed->Input = TakeKATBytes(&Reader, Seed->InputLen);
+        meow_u8 *Seed128 = TakeKATBytes(&Reader, sizeof(Seed->Seed128));
+        if(Seed128)
+        {
+            memcpy(Seed->Seed128, Seed128, sizeof(Seed->Seed128));
+        }
+        else
+        {
+            Result = "truncated in the seeds";
+        }
+    }
+
+    if(!Result)
+    {
+        KAT->VectorCount = (meow_u32)TakeKATValue(&Reader, 4);
+        if(!Reader.Ok || ((meow_u64)KAT->VectorCount*KAT_VECTOR_SIZE != Reader.Remaining))
+        {
+            Result = "vector count doesn't match the size of the file";
+        }
+        else if(!(KAT->Vectors = (kat_vector *)calloc(KAT->VectorCount ? KAT->VectorCount : 1, sizeof(kat_vector))))
+        {
+            Result = "unable to allocate the vectors";
+        }
+    }
+
+    KAT->MaxLen = 0;
+    for(meow_u32 VectorIndex = 0;
+        !Result && (VectorIndex < KAT->VectorCount);
+        ++VectorIndex)
+    {
+        kat_vector *Vector = KAT->Vectors + VectorIndex;
+        Vector->Len = TakeKATValue(&Reader, 8);
+        Vector->SeedIndex = (meow_u8)TakeKATValue(&Reader, 1);
+        Vector->Offset = (meow_u8)TakeKATValue(&Reader, 1);
+        meow_u8 *Hash = TakeKATBytes(&Reader, sizeof(Vector->Hash));
+        if(Hash)
+        {
+            memcpy(Vector->Hash, Hash, sizeof(Vector->Hash));
+        }
+
+        if(!Reader.Ok)
+        {
+            Result = "truncated in the vectors";
+        }
+        else if(Vector->Len > KAT_MAX_LENGTH)
+        {
+            Result = "a vector is longer than meow_kat will check";
+        }
+        else if(Vector->SeedIndex >= KAT->SeedCount)
+        {
+            Result = "a vector uses a seed that isn't in the file";
+        }
+        else if(Vector->Offset >= CACHE_LINE_ALIGNMENT)
+        {
+            Result = "a vector's offset is past a cache line";
+        }
+
+        if(KAT->MaxLen < Vector->Len)
+        {
+            KAT->MaxLen = Vector->Len;
+        }
+    }
+
+    return(Result);
+}
+
+#define KAT_MAX_REPORTED_FAILURES 8
+
+struct kat_type_result
+{
+    named_hash_type *Type;
+    meow_u32 OneShotFailures;
+    meow_u32 StreamFailures;
+};
+
+static void
+ReportKATFailure(kat_type_result *TypeResult, char const *How, kat_vector *Vector, meow_u128 Hash)
+{
+    if((TypeResult->OneShotFailures + TypeResult->StreamFailures) <= KAT_MAX_REPORTED_FAILURES)
+    {
+        printf("    FAILED: %s %s, seed %u, %llu bytes at offset %u: ",
+               TypeResult->Type->FullName, How, Vector->SeedIndex, Vector->Len, Vector->Offset);
+        PrintHash(stdout, Hash);
+        printf(" (expected ");
+        PrintHash(stdout, _mm_loadu_si128((__m128i *)Vector->Hash));
+        printf(")\n");
+    }
+}
+
+static int
+CheckKAT(char *FileName)
+{
+    int Result = 0;
+
+    meow_u8 *Contents = 0;
+    meow_u64 Size = 0;
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        Size = (meow_u64)ftell(File);
+        fseek(File, 0, SEEK_SET);
+        Contents = (meow_u8 *)malloc(Size ? Size : 1);
+        if(Size && (fread(Contents, Size, 1, File) != 1))
+        {
+            Size = 0;
+        }
+        fclose(File);
+    }
+
+    kat_file KAT = {};
+    char const *ParseError = 0;
+    if(!Contents)
+    {
+        fprintf(stderr, "ERROR: Unable to read %s\n", FileName);
+        Result = 1;
+    }
+    else if((ParseError = ParseKAT(Contents, Size, &KAT)) != 0)
+    {
+        fprintf(stderr, "ERROR: %s isn't a usable known-answer file (%s)\n", FileName, ParseError);
+        Result = 1;
+    }
+    else
+    {
+        printf("%s: %u vectors over %u seeds, up to ", FileName, KAT.VectorCount, KAT.SeedCount);
+        PrintSize(stdout, (double)KAT.MaxLen, false);
+        printf("\n");
+
+        // NOTE: The stored seeds are what get hashed with, so a bad MeowExpandSeed
+        // shows up on its own rather than as every vector of that seed failing
+        int SeedFailures = 0;
+        for(meow_u32 SeedIndex = 0;
+            SeedIndex < KAT.SeedCount;
+            ++SeedIndex)
+        {
+            kat_seed *Seed = KAT.Seeds + SeedIndex;
+            meow_u8 Expanded[128];
+            if(Seed->InputLen)
+            {
+                MeowExpandSeed(Seed->InputLen, Seed->Input, Expanded);
+            }
+            else
+            {
+                memcpy(Expanded, MeowDefaultSeed, sizeof(Expanded));
+            }
+
+            if(memcmp(Expanded, Seed->Seed128, sizeof(Expanded)) != 0)
+            {
+                printf("    FAILED: seed %u from %s doesn't match\n", SeedIndex, Seed->InputLen ? "MeowExpandSeed" : "MeowDefaultSeed");
+                ++SeedFailures;
+            }
+        }
+
+        kat_type_result TypeResults[ArrayCount(NamedHashTypes)];
+        int TypeCount = 0;
+        for(int TypeIndex = 0;
+            TypeIndex < ArrayCount(NamedHashTypes);
+            ++TypeIndex)
+        {
+            // NOTE: Only the implementations of the full Meow hash have a Reference
+            if(NamedHashTypes[TypeIndex].Reference)
+            {
+                kat_type_result *TypeResult = TypeResults + TypeCount++;
+                TypeResult->Type = NamedHashTypes + TypeIndex;
+                TypeResult->OneShotFailures = 0;
+                TypeResult->StreamFailures = 0;
+            }
+        }
+
+        meow_u8 *InputBase;
+        meow_u8 *PlacedBase;
+        meow_u8 *Input = AllocKATBuffer(KAT.MaxLen, &InputBase);
+        meow_u8 *Placed = AllocKATBuffer(KAT.MaxLen, &PlacedBase);
+        if(Input && Placed)
+        {
+            FillKATInput(Input, KAT.MaxLen);
+
+            double StartTime = GetWallClock();
+            for(meow_u32 VectorIndex = 0;
+                VectorIndex < KAT.VectorCount;
+                ++VectorIndex)
+            {
+                kat_vector *Vector = KAT.Vectors + VectorIndex;
+                meow_u8 *Seed128 = KAT.Seeds[Vector->SeedIndex].Seed128;
+                meow_u8 *Source = Placed + Vector->Offset;
+                memcpy(Source, Input, Vector->Len);
+                meow_u128 Expected = _mm_loadu_si128((__m128i *)Vector->Hash);
+
+                for(int TypeIndex = 0;
+                    TypeIndex < TypeCount;
+                    ++TypeIndex)
+                {
+                    kat_type_result *TypeResult = TypeResults + TypeIndex;
+                    named_hash_type *Type = TypeResult->Type;
+
+                    meow_u128 Hash = Type->Imp(Seed128, Vector->Len, Source);
+                    if(!MeowHashesAreEqual(Hash, Expected))
+                    {
+                        ++TypeResult->OneShotFailures;
+                        ReportKATFailure(TypeResult, "one-shot", Vector, Hash);
+                    }
+
+                    if(Type->Absorb)
+                    {
+                        // NOTE: In three uneven pieces, so the streaming code has to carry
+                        // partial blocks between calls
+                        meow_u64 Split0 = Vector->Len / 3;
+                        meow_u64 Split1 = Split0 + (Vector->Len - Split0) / 2 + 1;
+                        if(Split1 > Vector->Len)
+                        {
+                            Split1 = Vector->Len;
+                        }
+
+                        meow_u8 StateBuffer[1024];
+                        Type->Begin(StateBuffer, Seed128);
+                        Type->Absorb(StateBuffer, Split0, Source);
+                        Type->Absorb(StateBuffer, Split1 - Split0, Source + Split0);
+                        Type->Absorb(StateBuffer, Vector->Len - Split1, Source + Split1);
+                        Hash = Type->End(StateBuffer, 0);
+                        if(!MeowHashesAreEqual(Hash, Expected))
+                        {
+                            ++TypeResult->StreamFailures;
+                            ReportKATFailure(TypeResult, "streaming", Vector, Hash);
+                        }
+                    }
+                }
+            }
+            double Seconds = GetWallClock() - StartTime;
+
+            Result = (SeedFailures != 0);
+            for(int TypeIndex = 0;
+                TypeIndex < TypeCount;
+                ++TypeIndex)
+            {
+                kat_type_result *TypeResult = TypeResults + TypeIndex;
+                named_hash_type *Type = TypeResult->Type;
+                printf("%s: one-shot %s", Type->FullName,
+                       TypeResult->OneShotFailures ? "FAILED" : "ok");
+                if(Type->Absorb)
+                {
+                    printf(", streaming %s", TypeResult->StreamFailures ? "FAILED" : "ok");
+                }
+                if(TypeResult->OneShotFailures + TypeResult->StreamFailures)
+                {
+                    printf(" (%u of %u vectors failed)",
+                           TypeResult->OneShotFailures + TypeResult->StreamFailures,
+                           KAT.VectorCount*(Type->Absorb ? 2 : 1));
+                    Result = 1;
+                }
+                printf("\n");
+            }
+            printf("Checked in %0.2f seconds\n", Seconds);
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to allocate %llu bytes for the inputs\n", KAT.MaxLen);
+            Result = 1;
+        }
+
+        free(PlacedBase);
+        free(InputBase);
+    }
+
+    free(KAT.Vectors);
+    free(KAT.Seeds);
+    free(Contents);
+
+    return(Result);
+}
+
+int
+main(int ArgCount, char **Args)
+{
+    int Result = 0;
+
+    if((ArgCount >= 2) && (strcmp(Args[1], "-generate") == 0) && (ArgCount <= 3))
+    {
+        Result = GenerateKAT((ArgCount == 3) ? Args[2] : (char *)"util/meow_kat");
+    }
+    else if((ArgCount <= 2) && ((ArgCount == 1) || (Args[1][0] != '-')))
+    {
+        printf("meow_kat %s - known-answer tests for Meow hash implementations\n", MEOW_HASH_VERSION_NAME);
+        fflush(stdout);
+        Result = CheckKAT((ArgCount == 2) ? Args[1] : (char *)"util/meow_kat.bin");
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [<file>.bin]\n", Args[0]);
+        fprintf(stderr, "       %s -generate [<name>]\n", Args[0]);
+        fprintf(stderr, "    Checks every implementation of the Meow hash against known answers (default: util/meow_kat.bin),\n");
+        fprintf(stderr, "    or with -generate, writes the known answers this build computes to <name>.bin and <name>.txt\n");
+        fprintf(stderr, "    (default: util/meow_kat)\n");
+        Result = -1;
+    }
+
+    return(Result);
+}
@@ -14,18 +14,341 @@
 #include <time.h>
 #if _WIN32
 #include <windows.h>
+#include <io.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if __linux__
+#include <sys/syscall.h>
+#endif
 #endif
 
 #define MEOW_INCLUDE_TRUNCATIONS 1
 #include "meow_test.h"
 
+//
+// NOTE: Path storage
+//
+// Every file the search sees stays referenced for the whole run, so storing a full
+// copy of every path made path strings the biggest thing in memory on deep trees.
+// Instead, each directory entry is a node pointing at its parent directory's node,
+// with the name itself interned so that the many repeats (Makefile, index.js, .git,
+// etc.) are only stored once.  Full paths are only rebuilt when something needs to
+// be reported, or a file has to be reopened after the walk has moved on.
+//
+
+struct path_node
+{
+    path_node *Parent;
+    char *Name;
+};
+
+struct memory_arena
+{
+    meow_u8 *Base;
+    size_t Used;
+    size_t Size;
+};
+
+struct path_storage
+{
+    memory_arena Arena;
+    
+    meow_u64 NameSlotMask;
+    meow_u64 NameCount;
+    char **NameSlots;
+    
+    // NOTE: The directory currently being walked, so that files in it can be
+    // opened and stat'd relative to its handle instead of by full path.
+    path_node *CurrentDir;
+    int CurrentDirHandle;
+    
+    // NOTE: Nodes, names and full paths that couldn't be allocated
+    meow_u64 AllocationFailureCount;
+};
+
+static void *
+PushSize(memory_arena *Arena, size_t Size)
+{
+    void *Result = 0;
+    
+    Size = (Size + 7) & ~(size_t)7;
+    if((Arena->Used + Size) > Arena->Size)
+    {
+        // NOTE: Blocks are never freed, because everything in them is permanent
+        size_t BlockSize = 1024*1024;
+        if(BlockSize < Size)
+        {
+            BlockSize = Size;
+        }
+        
+        meow_u8 *Block = (meow_u8 *)malloc(BlockSize);
+        if(Block)
+        {
+            Arena->Base = Block;
+            Arena->Used = 0;
+            Arena->Size = BlockSize;
+        }
+    }
+    
+    if((Arena->Used + Size) <= Arena->Size)
+    {
+        Result = Arena->Base + Arena->Used;
+        Arena->Used += Size;
+    }
+    
+    return(Result);
+}
+
+// NOTE: Names are hashed with FNV-1a rather than Meow, so that -stats counts the
+// hashes of file contents and not of every name in the tree (the only other Meow
+// hash is the scan index's type signature, once per run with -index)
+static meow_u64
+NameHash(char *Name, size_t Length)
+{
+    meow_u64 Result = 0xcbf29ce484222325ULL;
+    for(size_t Index = 0;
+        Index < Length;
+        ++Index)
+    {
+        Result = (Result ^ (meow_u8)Name[Index])*0x100000001b3ULL;
+    }
+    
+    return(Result);
+}
+
+static char *
+InternName(path_storage *Paths, char *Name)
+{
+    char *Result = 0;
+    
+    // NOTE: If the table can't grow, it can still be used until it's full, as long
+    // as there's an empty slot left to end every probe
+    int HaveRoom = 1;
+    if((2*(Paths->NameCount + 1)) > Paths->NameSlotMask)
+    {
+        meow_u64 OldSlotCount = Paths->NameSlotMask ? (Paths->NameSlotMask + 1) : 0;
+        char **OldSlots = Paths->NameSlots;
+        
+        meow_u64 SlotCount = OldSlotCount ? 2*OldSlotCount : 4096;
+        char **NewSlots = (char **)calloc(SlotCount, sizeof(char *));
+        if(NewSlots)
+        {
+            Paths->NameSlotMask = SlotCount - 1;
+            Paths->NameSlots = NewSlots;
+            for(meow_u64 SlotIndex = 0;
+                SlotIndex < OldSlotCount;
+                ++SlotIndex)
+            {
+                char *Old = OldSlots[SlotIndex];
+                if(Old)
+                {
+                    meow_u64 Slot = NameHash(Old, strlen(Old)) & Paths->NameSlotMask;
+                    while(Paths->NameSlots[Slot])
+                    {
+                        Slot = (Slot + 1) & Paths->NameSlotMask;
+                    }
+                    Paths->NameSlots[Slot] = Old;
+                }
+            }
+            
+            free(OldSlots);
+        }
+        else
+        {
+            HaveRoom = ((Paths->NameCount + 1) < OldSlotCount);
+        }
+    }
+    
+    if(HaveRoom)
+    {
+        size_t Length = strlen(Name);
+        meow_u64 Slot = NameHash(Name, Length) & Paths->NameSlotMask;
+        while((Result = Paths->NameSlots[Slot]) != 0)
+        {
+            if(strcmp(Result, Name) == 0)
+            {
+                break;
+            }
+            Slot = (Slot + 1) & Paths->NameSlotMask;
+        }
+        
+        if(!Result)
+        {
+            Result = (char *)PushSize(&Paths->Arena, Length + 1);
+            if(Result)
+            {
+                memcpy(Result, Name, Length + 1);
+                Paths->NameSlots[Slot] = Result;
+                ++Paths->NameCount;
+            }
+        }
+    }
+    
+    return(Result);
+}
+
+static path_node *
+PushPathNode(path_storage *Paths, path_node *Parent, char *Name)
+{
+    // NOTE: Returns 0 (and counts it) if there was no memory for the node or its name
+    path_node *Result = (path_node *)PushSize(&Paths->Arena, sizeof(path_node));
+    char *InternedName = InternName(Paths, Name);
+    if(Result && InternedName)
+    {
+        Result->Parent = Parent;
+        Result->Name = InternedName;
+    }
+    else
+    {
+        Result = 0;
+        ++Paths->AllocationFailureCount;
+    }
+    
+    return(Result);
+}
+
+static char *
+AllocPath(path_node *Node)
+{
+    // NOTE: Sized for every name, a separator between each pair, and the terminator
+    size_t Size = 1;
+    for(path_node *Part = Node;
+        Part;
+        Part = Part->Parent)
+    {
+        Size += strlen(Part->Name) + (Part->Parent ? 1 : 0);
+    }
+    
+    char *Result = (char *)malloc(Size);
+    if(Result)
+    {
+        size_t At = Size - 1;
+        Result[At] = 0;
+        for(path_node *Part = Node;
+            Part;
+            Part = Part->Parent)
+        {
+            size_t Count = strlen(Part->Name);
+            At -= Count;
+            memcpy(Result + At, Part->Name, Count);
+            if(Part->Parent)
+            {
+                Result[--At] = '/';
+            }
+        }
+    }
+    
+    return(Result);
+}
+
+// NOTE: For reports, which shouldn't need memory to name a file
+static void
+PrintPath(FILE *Stream, path_node *Node)
+{
+    if(Node->Parent)
+    {
+        PrintPath(Stream, Node->Parent);
+        fputc('/', Stream);
+    }
+    fputs(Node->Name, Stream);
+}
+
+static void
+DeallocPath(char *A)
+{
+    if(A)
+    {
+        free(A);
+    }
+}
+
+static FILE *
+OpenPathFile(path_storage *Paths, path_node *Node)
+{
+    FILE *Result = 0;
+    
+#if !_WIN32
+    if(Paths->CurrentDir && (Node->Parent == Paths->CurrentDir))
+    {
+        int Handle = openat(Paths->CurrentDirHandle, Node->Name, O_RDONLY);
+        if(Handle >= 0)
+        {
+            Result = fdopen(Handle, "rb");
+            if(!Result)
+            {
+                close(Handle);
+            }
+        }
+    }
+    else
+#endif
+    {
+        char *FileName = AllocPath(Node);
+        if(FileName)
+        {
+            Result = fopen(FileName, "rb");
+            DeallocPath(FileName);
+        }
+        else
+        {
+            ++Paths->AllocationFailureCount;
+        }
+    }
+    
+    return(Result);
+}
+
+#if _WIN32
+typedef struct __stat64 path_stat;
+#else
+typedef struct stat path_stat;
+#endif
+
+static int
+StatPath(path_storage *Paths, path_node *Node, path_stat *Stat)
+{
+    int Result = 0;
+    
+#if !_WIN32
+    if(Paths->CurrentDir && (Node->Parent == Paths->CurrentDir))
+    {
+        Result = (fstatat(Paths->CurrentDirHandle, Node->Name, Stat, 0) == 0);
+    }
+    else
+#endif
+    {
+        char *FileName = AllocPath(Node);
+        if(FileName)
+        {
+#if _WIN32
+            Result = (_stat64(FileName, Stat) == 0);
+#else
+            Result = (stat(FileName, Stat) == 0);
+#endif
+            DeallocPath(FileName);
+        }
+        else
+        {
+            ++Paths->AllocationFailureCount;
+        }
+    }
+    
+    return(Result);
+}
+
 struct test_file
 {
     test_file *Next;
-    char *FileName;
+    path_node *Path;
     int IsCollision;
+    
+    // NOTE: Every digest of the file, if they came from an up-to-date scan index
+    // record rather than from reading it (shared by its entries in every test)
+    meow_u128 *IndexHashes;
 };
 
 struct test_value
@@ -42,6 +365,98 @@ struct test
     test_value *Table[4096];
 };
 
+//
+// NOTE: The scan index is a flat file of fixed-size records, each mapping a file's
+// (device, inode, size, mtime) to the digests of every hash type in this build.
+// Records are only ever appended, so a scan that dies part way through never
+// damages what was already there, and a file whose metadata changed just gets
+// a newer record that supersedes the old one.  On startup the existing file is
+// mapped read-only and a small open-addressed table on (device, inode) points
+// at the newest record for each file.
+//
+
+#define SCAN_INDEX_VERSION 1
+
+struct scan_index_header
+{
+    meow_u8 Magic[8];
+    meow_u32 Version;
+    meow_u32 HashVersion;
+    meow_u32 TypeCount;
+    meow_u32 RecordSize;
+    meow_u64 TypeSignature;
+};
+
+struct scan_index_key
+{
+    meow_u64 Device;
+    meow_u64 Inode;
+    meow_u64 Size;
+    meow_u64 MTimeNs;
+};
+
+struct scan_index
+{
+    char *FileName;
+    FILE *Append;
+    
+    // NOTE: The mapped contents of the index as it was when the scan started
+    meow_u8 *Mapped;
+    meow_u64 MappedSize;
+    meow_u64 RecordCount;
+    meow_u32 TypeCount;
+    meow_u32 RecordSize;
+    
+    // NOTE: Records appended during this scan, kept so that later lookups (a hard
+    // link to a file already hashed, say) find them too.  They are numbered on
+    // from the mapped ones.
+    meow_u8 *Appended;
+    meow_u64 AppendedMax;
+    
+    // NOTE: (device, inode) lookup, storing record index + 1 so that 0 is empty
+    meow_u64 SlotMask;
+    meow_u64 *Slots;
+    meow_u8 *Used;
+    
+    meow_u64 ReusedCount;
+    meow_u64 AppendedCount;
+};
+
+struct dedup_file
+{
+    path_node *Path;
+    meow_u64 Size;
+    meow_u128 Sample;
+    meow_u128 Full;
+    int FullKnown;
+    
+    // NOTE: Files with the same size and full hash get the same class only if their
+    // bytes are the same too
+    meow_u32 Class;
+};
+
+// NOTE: The hash is stored as words so that records pack to 24 bytes on disk
+struct external_record
+{
+    meow_u64 Hash[2];
+    meow_u64 FileId;
+};
+
+struct external_sorter
+{
+    char *Directory;
+    char *Prefix;
+    
+    meow_u64 RecordMax;
+    meow_u64 RecordCount;
+    external_record *Records;
+    external_record *SortTemp;
+    
+    meow_u32 RunCount;
+    meow_u64 SpilledCount;
+    int Failed;
+};
+
 struct test_group
 {
     int TestCount;
@@ -58,41 +473,108 @@ struct test_group
     meow_u64 AllocationFailureCount;
     meow_u64 ReadFailureCount;
     
+    // NOTE: Big files can be read into memory mapped with huge pages, so hashing them
+    // doesn't miss the TLB every 4kb; if that kind of page runs out, they fall back
+    page_kind PageKind;
+    meow_u64 HugePageFallbackCount;
+    
+    // NOTE: With more than one NUMA node, big files are also read into memory bound
+    // to the node the search is running on at the time, so they're never hashed
+    // from another socket's memory
+    int NUMANodeCount;
+    
     char *ReportFileName;
     char *RootPath;
+    
+    path_storage Paths;
+    scan_index Index;
+    
+    // NOTE: The report is an append-only journal, so a crashed scan can be resumed
+    // by replaying the walk up to its last checkpoint.
+    FILE *Journal;
+    meow_u64 ResumeFileCount;
+    char *ResumePath;
+    meow_u64 ResumeOffset;
+    
+    // NOTE: Dedup mode only collects file names and sizes during the walk
+    int DedupMode;
+    meow_u64 DedupFileCount;
+    meow_u64 DedupFileMax;
+    dedup_file *DedupFiles;
+    
+    // NOTE: External mode keeps nothing per file in memory; see RunExternal
+    char *ExternalDirectory;
+    meow_u64 ExternalMemory;
+    FILE *ExternalPaths;
+    external_sorter *ExternalSorters;
 };
 
 struct entire_file
 {
     size_t Size;
     void *Contents;
+    page_kind PageKind;
+    int Mapped;
 };
 
+// NOTE: Smaller files wouldn't fill one huge page, or be worth a mapping of their
+// own to place on a NUMA node, so they just use the heap
+#define MAPPED_FILE_MIN_SIZE (2*1024*1024)
+
 static void
 FreeEntireFile(entire_file *File)
 {
     if(File->Contents)
     {
-        free(File->Contents);
+        if(File->Mapped)
+        {
+            FreePages(File->Contents, File->Size, File->PageKind);
+        }
+        else
+        {
+            free(File->Contents);
+        }
         File->Contents = 0;
     }
     
     File->Size = 0;
+    File->PageKind = Pages_Default;
+    File->Mapped = 0;
 }
 
 static entire_file
-ReadEntireFile(test_group *Group, char *Filename)
+ReadEntireFile(test_group *Group, path_node *Path)
 {
     entire_file Result = {};
     
-    FILE *File = fopen(Filename, "rb");
+    FILE *File = OpenPathFile(&Group->Paths, Path);
     if(File)
     {
         fseek(File, 0, SEEK_END);
         Result.Size = ftell(File);
         fseek(File, 0, SEEK_SET);
         
-        Result.Contents = aligned_alloc(CACHE_LINE_ALIGNMENT, Result.Size);
+        if(((Group->PageKind != Pages_Default) || (Group->NUMANodeCount > 1)) &&
+           (Result.Size >= MAPPED_FILE_MIN_SIZE))
+        {
+            // NOTE: The node is asked for every file, since the OS can move us between them
+            int Node = (Group->NUMANodeCount > 1) ? GetCurrentNUMANode() : NUMA_NODE_ANY;
+            Result.Contents = AllocPages(Result.Size, Node, Group->PageKind);
+            if(Result.Contents)
+            {
+                Result.PageKind = Group->PageKind;
+                Result.Mapped = 1;
+            }
+            else if(Group->PageKind != Pages_Default)
+            {
+                ++Group->HugePageFallbackCount;
+            }
+        }
+        
+        if(!Result.Contents)
+        {
+            Result.Contents = aligned_alloc(CACHE_LINE_ALIGNMENT, Result.Size);
+        }
         if(Result.Contents)
         {
             if(Result.Size)
@@ -125,35 +607,558 @@ ReadEntireFile(test_group *Group, char *Filename)
     return(Result);
 }
 
+//
+// NOTE: Scan index
+//
+
+static meow_u64
+ScanIndexTypeSignature(int TestCount, test *Tests)
+{
+    // NOTE: Digests are only reusable if they were made by the same set of hash
+    // implementations, in the same order, so we fold the short names into the header.
+    meow_state State;
+    MeowBegin(&State, MeowDefaultSeed);
+    for(int TestIndex = 0;
+        TestIndex < TestCount;
+        ++TestIndex)
+    {
+        char *Name = Tests[TestIndex].Type.ShortName;
+        MeowAbsorb(&State, strlen(Name) + 1, Name);
+    }
+    meow_u128 Hash = MeowEnd(&State, 0);
+    
+    meow_u64 Result = MeowU64From(Hash, 0);
+    return(Result);
+}
+
 static void
-WriteReport(test_group *Group, int Completed)
+InitScanIndexHeader(scan_index_header *Header, int TestCount, test *Tests)
 {
-    FILE *R = fopen(Group->ReportFileName, "w");
-    if(R)
+    memset(Header, 0, sizeof(*Header));
+    memcpy(Header->Magic, "MEOWSIDX", 8);
+    Header->Version = SCAN_INDEX_VERSION;
+    Header->HashVersion = MEOW_HASH_VERSION;
+    Header->TypeCount = TestCount;
+    Header->RecordSize = sizeof(scan_index_key) + TestCount*sizeof(meow_u128);
+    Header->TypeSignature = ScanIndexTypeSignature(TestCount, Tests);
+}
+
+static meow_u64
+ScanIndexSlotFor(scan_index_key *Key)
+{
+    meow_u64 Result = (Key->Device*0x9E3779B97F4A7C15ULL) ^ Key->Inode;
+    Result ^= Result >> 29;
+    Result *= 0xBF58476D1CE4E5B9ULL;
+    Result ^= Result >> 32;
+    return(Result);
+}
+
+static scan_index_key *
+ScanIndexRecord(scan_index *Index, meow_u64 RecordIndex)
+{
+    scan_index_key *Result = 0;
+    if(RecordIndex < Index->RecordCount)
     {
-        time_t Time;
-        time(&Time);
-        tm *TimeInfo = localtime(&Time);
-        
-        fprintf(R, "meow_search %s results:\n", MEOW_HASH_VERSION_NAME);
-        fprintf(R, "    Root: %s\n", Group->RootPath);
-        fprintf(R, "    %s: %s", Completed ? "Completed on" : "Progress as of", asctime(TimeInfo));
-        fprintf(R, "    Files: %0.0f\n", (double)Group->FileCount);
-        fprintf(R, "    Total size: ");
-        PrintSize(R, Group->ByteCount, false);
-        fprintf(R, "\n");
-        fprintf(R, "    Duplicate files: %0.0f\n", (double)Group->DuplicateFileCount);
-        fprintf(R, "    Files changed during search: %0.0f\n", (double)Group->ChangedFileCount);
-        fprintf(R, "    Access failures: %0.0f\n", (double)Group->AccessFailureCount);
-        fprintf(R, "    Allocation failures: %0.0f\n", (double)Group->AllocationFailureCount);
-        fprintf(R, "    Read failures: %0.0f\n", (double)Group->ReadFailureCount);
-        
-        for(int TestIndex = 0;
-            TestIndex < Group->TestCount;
-            ++TestIndex)
+        Result = (scan_index_key *)(Index->Mapped + sizeof(scan_index_header) +
+                                    RecordIndex*Index->RecordSize);
+    }
+    else
+    {
+        Result = (scan_index_key *)(Index->Appended + (RecordIndex - Index->RecordCount)*Index->RecordSize);
+    }
+    return(Result);
+}
+
+static void
+InsertScanIndexSlot(scan_index *Index, meow_u64 RecordIndex)
+{
+    scan_index_key *Record = ScanIndexRecord(Index, RecordIndex);
+    meow_u64 Slot = ScanIndexSlotFor(Record) & Index->SlotMask;
+    while(Index->Slots[Slot])
+    {
+        scan_index_key *Other = ScanIndexRecord(Index, Index->Slots[Slot] - 1);
+        if((Other->Device == Record->Device) && (Other->Inode == Record->Inode))
+        {
+            break;
+        }
+        Slot = (Slot + 1) & Index->SlotMask;
+    }
+    Index->Slots[Slot] = RecordIndex + 1;
+}
+
+static void
+BuildScanIndexSlots(scan_index *Index, meow_u64 RecordTotal)
+{
+    meow_u64 SlotCount = 1024;
+    while(SlotCount < 2*RecordTotal)
+    {
+        SlotCount *= 2;
+    }
+    free(Index->Slots);
+    Index->SlotMask = SlotCount - 1;
+    Index->Slots = (meow_u64 *)calloc(SlotCount, sizeof(meow_u64));
+    
+    // NOTE: Later records supersede earlier ones, so walking forward leaves
+    // every slot pointing at the newest record for its file.
+    for(meow_u64 RecordIndex = 0;
+        RecordIndex < RecordTotal;
+        ++RecordIndex)
+    {
+        InsertScanIndexSlot(Index, RecordIndex);
+    }
+}
+
+#if _WIN32
+
+static int
+OpenScanIndex(scan_index *Index, char *FileName, int TestCount, test *Tests)
+{
+    printf("ERROR: Scan indexes are not supported on this platform yet.\n");
+    return(0);
+}
+
+static int
+GetScanIndexKey(path_storage *Paths, path_node *Path, scan_index_key *Key)
+{
+    return(0);
+}
+
+static void
+CloseScanIndex(scan_index *Index, int Completed)
+{
+}
+
+#else
+
+static int
+OpenScanIndex(scan_index *Index, char *FileName, int TestCount, test *Tests)
+{
+    int Result = 0;
+    
+    scan_index_header Expected;
+    InitScanIndexHeader(&Expected, TestCount, Tests);
+    
+    memset(Index, 0, sizeof(*Index));
+    Index->FileName = FileName;
+    Index->TypeCount = Expected.TypeCount;
+    Index->RecordSize = Expected.RecordSize;
+    
+    int FileHandle = open(FileName, O_RDONLY);
+    if(FileHandle >= 0)
+    {
+        struct stat Stat;
+        if((fstat(FileHandle, &Stat) == 0) && (Stat.st_size >= (off_t)sizeof(scan_index_header)))
+        {
+            void *Mapped = mmap(0, Stat.st_size, PROT_READ, MAP_PRIVATE, FileHandle, 0);
+            if(Mapped != MAP_FAILED)
+            {
+                Index->Mapped = (meow_u8 *)Mapped;
+                Index->MappedSize = Stat.st_size;
+            }
+        }
+        close(FileHandle);
+        
+        if(Index->Mapped)
+        {
+            if(memcmp(Index->Mapped, &Expected, sizeof(Expected)) == 0)
+            {
+                // NOTE: A torn append at the tail is simply ignored - the next append
+                // starts after the last whole record.
+                Index->RecordCount = (Index->MappedSize - sizeof(scan_index_header)) / Index->RecordSize;
+                Result = 1;
+            }
+            else
+            {
+                printf("ERROR: %s was written by a different build of meow_search (or is not a scan index).\n", FileName);
+            }
+        }
+        else
+        {
+            printf("ERROR: Unable to map scan index %s.\n", FileName);
+        }
+    }
+    else
+    {
+        // NOTE: No index yet, so start a fresh one
+        FILE *Fresh = fopen(FileName, "wb");
+        if(Fresh)
+        {
+            Result = (fwrite(&Expected, sizeof(Expected), 1, Fresh) == 1);
+            fclose(Fresh);
+        }
+        
+        if(!Result)
+        {
+            printf("ERROR: Unable to create scan index %s.\n", FileName);
+        }
+    }
+    
+    if(Result)
+    {
+        BuildScanIndexSlots(Index, Index->RecordCount);
+        Index->Used = (meow_u8 *)calloc(Index->RecordCount + 1, 1);
+        
+        // NOTE: Append after the last whole record, dropping any torn tail
+        Index->Append = fopen(FileName, "r+b");
+        if(Index->Append)
+        {
+            fseek(Index->Append, sizeof(scan_index_header) + Index->RecordCount*Index->RecordSize, SEEK_SET);
+        }
+        else
+        {
+            printf("ERROR: Unable to open scan index %s for writing.\n", FileName);
+            Result = 0;
+        }
+    }
+    
+    return(Result);
+}
+
+static int
+GetScanIndexKey(path_storage *Paths, path_node *Path, scan_index_key *Key)
+{
+    int Result = 0;
+    
+    path_stat Stat;
+    if(StatPath(Paths, Path, &Stat))
+    {
+        Key->Device = (meow_u64)Stat.st_dev;
+        Key->Inode = (meow_u64)Stat.st_ino;
+        Key->Size = (meow_u64)Stat.st_size;
+#if __APPLE__
+        Key->MTimeNs = (meow_u64)Stat.st_mtimespec.tv_sec*1000000000ULL + (meow_u64)Stat.st_mtimespec.tv_nsec;
+#else
+        Key->MTimeNs = (meow_u64)Stat.st_mtim.tv_sec*1000000000ULL + (meow_u64)Stat.st_mtim.tv_nsec;
+#endif
+        Result = 1;
+    }
+    
+    return(Result);
+}
+
+static void
+CloseScanIndex(scan_index *Index, int Completed)
+{
+    if(Index->Append)
+    {
+        fclose(Index->Append);
+        Index->Append = 0;
+        
+        // NOTE: Once a completed scan shows that most of the index is superseded
+        // or refers to files that are gone, rewrite it with just the live records.
+        meow_u64 LiveCount = Index->ReusedCount + Index->AppendedCount;
+        meow_u64 TotalCount = Index->RecordCount + Index->AppendedCount;
+        if(Completed && (TotalCount > 2*LiveCount + 1024))
+        {
+            size_t CompactNameSize = strlen(Index->FileName) + 16;
+            char *CompactName = (char *)malloc(CompactNameSize);
+            snprintf(CompactName, CompactNameSize, "%s.compact", Index->FileName);
+            
+            FILE *Source = fopen(Index->FileName, "rb");
+            FILE *Dest = fopen(CompactName, "wb");
+            void *Record = malloc(Index->RecordSize);
+            int Written = (Source && Dest && Record);
+            if(Written)
+            {
+                Written = (fwrite(Index->Mapped, sizeof(scan_index_header), 1, Dest) == 1);
+                for(meow_u64 RecordIndex = 0;
+                    Written && (RecordIndex < Index->RecordCount);
+                    ++RecordIndex)
+                {
+                    if(Index->Used[RecordIndex])
+                    {
+                        Written = (fwrite(ScanIndexRecord(Index, RecordIndex), Index->RecordSize, 1, Dest) == 1);
+                    }
+                }
+                
+                fseek(Source, sizeof(scan_index_header) + Index->RecordCount*Index->RecordSize, SEEK_SET);
+                for(meow_u64 RecordIndex = 0;
+                    Written && (RecordIndex < Index->AppendedCount);
+                    ++RecordIndex)
+                {
+                    Written = ((fread(Record, Index->RecordSize, 1, Source) == 1) &&
+                               (fwrite(Record, Index->RecordSize, 1, Dest) == 1));
+                }
+            }
+            
+            if(Dest && (fclose(Dest) != 0))
+            {
+                Written = 0;
+            }
+            if(Source)
+            {
+                fclose(Source);
+            }
+            
+            if(Written && (rename(CompactName, Index->FileName) == 0))
+            {
+                printf("Compacted scan index to %0.0f records.\n", (double)LiveCount);
+            }
+            else
+            {
+                remove(CompactName);
+            }
+            
+            free(Record);
+            free(CompactName);
+        }
+    }
+    
+    if(Index->Mapped)
+    {
+        munmap(Index->Mapped, Index->MappedSize);
+        Index->Mapped = 0;
+    }
+    
+    free(Index->Slots);
+    free(Index->Used);
+    free(Index->Appended);
+    Index->Slots = 0;
+    Index->Used = 0;
+    Index->Appended = 0;
+}
+
+#endif
+
+static int
+LookupScanIndex(scan_index *Index, scan_index_key *Key, meow_u128 *Hashes)
+{
+    int Result = 0;
+    
+    if(Index->Slots)
+    {
+        meow_u64 Slot = ScanIndexSlotFor(Key) & Index->SlotMask;
+        while(Index->Slots[Slot])
+        {
+            meow_u64 RecordIndex = Index->Slots[Slot] - 1;
+            scan_index_key *Record = ScanIndexRecord(Index, RecordIndex);
+            if((Record->Device == Key->Device) && (Record->Inode == Key->Inode))
+            {
+                if((Record->Size == Key->Size) && (Record->MTimeNs == Key->MTimeNs))
+                {
+                    memcpy(Hashes, Record + 1, Index->TypeCount*sizeof(meow_u128));
+                    
+                    // NOTE: A record appended this scan is already counted as live
+                    if(RecordIndex < Index->RecordCount)
+                    {
+                        Index->Used[RecordIndex] = 1;
+                        ++Index->ReusedCount;
+                    }
+                    Result = 1;
+                }
+                break;
+            }
+            Slot = (Slot + 1) & Index->SlotMask;
+        }
+    }
+    
+    return(Result);
+}
+
+static void
+AppendScanIndex(scan_index *Index, scan_index_key *Key, meow_u128 *Hashes)
+{
+    if(Index->Append)
+    {
+        fwrite(Key, sizeof(*Key), 1, Index->Append);
+        fwrite(Hashes, sizeof(meow_u128), Index->TypeCount, Index->Append);
+        
+        if(Index->AppendedCount == Index->AppendedMax)
+        {
+            Index->AppendedMax = Index->AppendedMax ? 2*Index->AppendedMax : 4096;
+            Index->Appended = (meow_u8 *)realloc(Index->Appended, Index->AppendedMax*Index->RecordSize);
+        }
+        meow_u8 *Record = Index->Appended + Index->AppendedCount*Index->RecordSize;
+        memcpy(Record, Key, sizeof(*Key));
+        memcpy(Record + sizeof(*Key), Hashes, Index->TypeCount*sizeof(meow_u128));
+        ++Index->AppendedCount;
+        
+        meow_u64 RecordTotal = Index->RecordCount + Index->AppendedCount;
+        if(2*RecordTotal > Index->SlotMask)
+        {
+            BuildScanIndexSlots(Index, RecordTotal);
+        }
+        else
+        {
+            InsertScanIndexSlot(Index, RecordTotal - 1);
+        }
+    }
+}
+
+//
+// NOTE: Report journal
+//
+// Rather than rewriting the whole report as the search goes (which means walking
+// every table, every time), the report is a journal that only ever has lines
+// appended to it: a header, a checkpoint every 1000 files, one line per collision
+// as it is found, and the final summary when the search completes.
+//
+
+#define JOURNAL_CHECKPOINT_INTERVAL 1000
+
+static void
+PrintJournalTime(FILE *Stream, char const *Label)
+{
+    time_t Time;
+    time(&Time);
+    tm *TimeInfo = localtime(&Time);
+    fprintf(Stream, "    %s: %s", Label, asctime(TimeInfo));
+}
+
+static int
+BeginJournal(test_group *Group, char *IndexFileName)
+{
+    int Result = 0;
+    
+    if(Group->ResumePath)
+    {
+        // NOTE: Everything after the checkpoint will be found again by the resumed
+        // walk, so it is cut off rather than left to be written twice
+        Group->Journal = fopen(Group->ReportFileName, "r+b");
+#if _WIN32
+        if(Group->Journal && (_chsize_s(_fileno(Group->Journal), Group->ResumeOffset) != 0))
+#else
+        if(Group->Journal && (ftruncate(fileno(Group->Journal), (off_t)Group->ResumeOffset) != 0))
+#endif
+        {
+            fclose(Group->Journal);
+            Group->Journal = 0;
+        }
+        
+        if(Group->Journal)
+        {
+            fseek(Group->Journal, 0, SEEK_END);
+            fprintf(Group->Journal, "resume from checkpoint %.0f\n", (double)Group->ResumeFileCount);
+            PrintJournalTime(Group->Journal, "Resumed on");
+            Result = 1;
+        }
+    }
+    else
+    {
+        Group->Journal = fopen(Group->ReportFileName, "wb");
+        if(Group->Journal)
+        {
+            fprintf(Group->Journal, "meow_search %s journal:\n", MEOW_HASH_VERSION_NAME);
+            fprintf(Group->Journal, "    Root: %s\n", Group->RootPath);
+            if(IndexFileName)
+            {
+                fprintf(Group->Journal, "    Index: %s\n", IndexFileName);
+            }
+            PrintJournalTime(Group->Journal, "Began on");
+            Result = 1;
+        }
+    }
+    
+    if(Group->Journal)
+    {
+        fflush(Group->Journal);
+    }
+    else
+    {
+        printf("ERROR: Unable to open %s for writing.\n", Group->ReportFileName);
+    }
+    
+    return(Result);
+}
+
+static int
+IsReplaying(test_group *Group)
+{
+    int Result = (Group->FileCount <= Group->ResumeFileCount);
+    return(Result);
+}
+
+static void
+WriteCheckpoint(test_group *Group, path_node *Path)
+{
+    if(!IsReplaying(Group))
+    {
+        // NOTE: Make sure the index has every digest up to this point, so that a resume
+        // from this checkpoint can replay the files before it without rehashing them.
+        if(Group->Index.Append)
+        {
+            fflush(Group->Index.Append);
+        }
+        
+        fprintf(Group->Journal, "checkpoint %.0f files, %.0f bytes, %.0f dupes, %.0f chng: ",
+                (double)Group->FileCount, (double)Group->ByteCount,
+                (double)Group->DuplicateFileCount, (double)Group->ChangedFileCount);
+        PrintPath(Group->Journal, Path);
+        fprintf(Group->Journal, "\n");
+        fflush(Group->Journal);
+    }
+    else if(Group->FileCount == Group->ResumeFileCount)
+    {
+        char *FileName = AllocPath(Path);
+        if(!FileName)
+        {
+            ++Group->Paths.AllocationFailureCount;
+        }
+        else if(strcmp(FileName, Group->ResumePath))
+        {
+            printf("\nWARNING: The tree has changed since the checkpoint (expected %s, found %s).\n",
+                   Group->ResumePath, FileName);
+        }
+        DeallocPath(FileName);
+    }
+}
+
+static void
+WriteCollision(test_group *Group, test *Test, meow_u128 Hash, path_node *Path, path_node *OtherPath)
+{
+    if(!IsReplaying(Group))
+    {
+        fprintf(Group->Journal, "collision [%s] ", Test->Type.ShortName);
+        PrintHash(Group->Journal, Hash);
+        fprintf(Group->Journal, ": ");
+        PrintPath(Group->Journal, Path);
+        fprintf(Group->Journal, "\n    with: ");
+        PrintPath(Group->Journal, OtherPath);
+        fprintf(Group->Journal, "\n");
+        fflush(Group->Journal);
+    }
+}
+
+static void
+WriteSummary(test_group *Group)
+{
+    FILE *R = Group->Journal;
+    
+    fprintf(R, "meow_search %s results:\n", MEOW_HASH_VERSION_NAME);
+    fprintf(R, "    Root: %s\n", Group->RootPath);
+    PrintJournalTime(R, "Completed on");
+    fprintf(R, "    Files: %0.0f\n", (double)Group->FileCount);
+    fprintf(R, "    Total size: ");
+    PrintSize(R, Group->ByteCount, false);
+    fprintf(R, "\n");
+    fprintf(R, "    Duplicate files: %0.0f\n", (double)Group->DuplicateFileCount);
+    fprintf(R, "    Files changed during search: %0.0f\n", (double)Group->ChangedFileCount);
+    fprintf(R, "    Access failures: %0.0f\n", (double)Group->AccessFailureCount);
+    fprintf(R, "    Allocation failures: %0.0f\n",
+            (double)(Group->AllocationFailureCount + Group->Paths.AllocationFailureCount));
+    fprintf(R, "    Read failures: %0.0f\n", (double)Group->ReadFailureCount);
+    if(Group->PageKind != Pages_Default)
+    {
+        fprintf(R, "    Files that couldn't get %s pages: %0.0f\n",
+                PageKindNames[Group->PageKind], (double)Group->HugePageFallbackCount);
+    }
+    if(Group->Index.Append)
+    {
+        fprintf(R, "    Files reused from index: %0.0f\n", (double)Group->Index.ReusedCount);
+    }
+    if(Group->ExternalSorters)
+    {
+        fprintf(R, "    External runs: %u per hash type\n", Group->ExternalSorters[0].RunCount);
+    }
+    
+    for(int TestIndex = 0;
+        TestIndex < Group->TestCount;
+        ++TestIndex)
+    {
+        test *Test = Group->Tests + TestIndex;
+        fprintf(R, "    [%s] %s collisions: %0.0f\n", Test->Type.ShortName, Test->Type.FullName, (double)Test->CollisionCount);
+        if(Test->CollisionCount)
         {
-            test *Test = Group->Tests + TestIndex;
-            fprintf(R, "    [%s] %s collisions: %0.0f\n", Test->Type.ShortName, Test->Type.FullName, (double)Test->CollisionCount);
             for(int HashSlot = 0;
                 HashSlot < ArrayCount(Test->Table);
                 ++HashSlot)
@@ -186,122 +1191,1520 @@ WriteReport(test_group *Group, int Completed)
                         {
                             if(File->IsCollision)
                             {
-                                fprintf(R, "            %s\n", File->FileName);
+                                fprintf(R, "            ");
+                                PrintPath(R, File->Path);
+                                fprintf(R, "\n");
                             }
                         }
                     }
                 }
             }
         }
-        
-        fclose(R);
     }
+    
+    fclose(R);
+    Group->Journal = 0;
 }
 
-static void
-IngestFile(test_group *Group, char *FileName)
+static char *
+CopyString(char *Source)
+{
+    size_t Size = strlen(Source) + 1;
+    char *Result = (char *)malloc(Size);
+    memcpy(Result, Source, Size);
+    return(Result);
+}
+
+static int
+ReadJournalForResume(test_group *Group, char **IndexFileName)
 {
-    entire_file File = ReadEntireFile(Group, FileName);
-    if(File.Contents)
+    int Result = 0;
+    
+    FILE *Journal = fopen(Group->ReportFileName, "rb");
+    if(Journal)
     {
-        ++Group->FileCount;
-        Group->ByteCount += File.Size;
-        
-        int QuickStatus = ((Group->FileCount % 10) == 0);
-        if(QuickStatus)
-        {
-            double Gigabyte = 1024.0*1024.0*1024.0;
-            printf("\r%0.0f files, %0.02fgb, %0.0f dupes, %0.0f chng",
-                   (double)Group->FileCount,
-                   (double)Group->ByteCount / (double)Gigabyte,
-                   (double)Group->DuplicateFileCount,
-                   (double)Group->ChangedFileCount);
-        }
+        int RootMatches = 0;
+        int Completed = 0;
         
-        if((Group->FileCount % 1000) == 0)
-        {
-            WriteReport(Group, false);
-        }
+        // NOTE: Where the resumed journal picks up: after the last whole checkpoint,
+        // or after the header if there wasn't one
+        meow_u64 HeaderEnd = 0;
+        meow_u64 CheckpointEnd = 0;
         
-        int DuplicateFileFound = 0;
-        int FileChanged = 0;
-        for(int TestIndex = 0;
-            TestIndex < Group->TestCount;
-            ++TestIndex)
+        size_t LineSize = 65536;
+        char *Line = (char *)malloc(LineSize);
+        while(fgets(Line, (int)LineSize, Journal))
         {
-            test *Test = Group->Tests + TestIndex;
-            
-            meow_u128 Hash = Test->Type.Imp(MeowDefaultSeed, File.Size, File.Contents);
-            
-            test_value **Slot = &Test->Table[MeowU32From(Hash, 0) % ArrayCount(Test->Table)];
-            test_value *Entry = *Slot;
-            while(Entry && memcmp(&Entry->Hash, &Hash, sizeof(Hash)))
+            size_t LineLength = strlen(Line);
+            int LineIsWhole = (LineLength && (Line[LineLength - 1] == '\n'));
+            meow_u64 LineEnd = (meow_u64)ftell(Journal);
+            while(LineLength && ((Line[LineLength - 1] == '\n') || (Line[LineLength - 1] == '\r')))
             {
-                Entry = Entry->Next;
+                Line[--LineLength] = 0;
             }
             
-            int IsCollision = 0;
-            if(Entry)
+            char *Value;
+            if(strncmp(Line, "    Root: ", 10) == 0)
+            {
+                RootMatches = (strcmp(Line + 10, Group->RootPath) == 0);
+            }
+            else if((strncmp(Line, "    Index: ", 11) == 0) && !*IndexFileName)
+            {
+                *IndexFileName = CopyString(Line + 11);
+            }
+            else if((strncmp(Line, "    Began on: ", 14) == 0) && LineIsWhole && !HeaderEnd)
+            {
+                HeaderEnd = LineEnd;
+            }
+            else if(strncmp(Line, "    Completed on: ", 18) == 0)
+            {
+                Completed = 1;
+            }
+            else if((strncmp(Line, "checkpoint ", 11) == 0) && LineIsWhole && (Value = strstr(Line, " chng: ")))
+            {
+                // NOTE: Only the last whole checkpoint counts
+                Group->ResumeFileCount = (meow_u64)strtod(Line + 11, 0);
+                free(Group->ResumePath);
+                Group->ResumePath = CopyString(Value + 7);
+                CheckpointEnd = LineEnd;
+            }
+        }
+        free(Line);
+        fclose(Journal);
+        
+        if(Completed)
+        {
+            printf("ERROR: %s is from a search that already completed.\n", Group->ReportFileName);
+        }
+        else if(!RootMatches || !HeaderEnd)
+        {
+            printf("ERROR: %s is not a journal for a search of %s.\n", Group->ReportFileName, Group->RootPath);
+        }
+        else
+        {
+            Group->ResumeOffset = CheckpointEnd ? CheckpointEnd : HeaderEnd;
+
+            if(!Group->ResumePath)
+            {
+                // NOTE: Crashed before the first checkpoint, so there is nothing to skip
+                Group->ResumePath = CopyString((char *)"");
+            }
+            
+            Result = 1;
+        }
+    }
+    else
+    {
+        printf("ERROR: Unable to open %s to resume.\n", Group->ReportFileName);
+    }
+    
+    return(Result);
+}
+
+static int
+HashFile(test_group *Group, path_node *Path, meow_u128 *Hashes, meow_u64 *FileSize, entire_file *File)
+{
+    int Result = 0;
+    
+    // NOTE: If the scan index already has digests for this exact file, we can skip
+    // reading it entirely (unless it turns out to need a content comparison later).
+    scan_index_key Key = {};
+    int HaveKey = (Group->Index.Append && GetScanIndexKey(&Group->Paths, Path, &Key));
+    if(HaveKey && LookupScanIndex(&Group->Index, &Key, Hashes))
+    {
+        Result = 1;
+        *FileSize = Key.Size;
+    }
+    else
+    {
+        *File = ReadEntireFile(Group, Path);
+        if(File->Contents)
+        {
+            for(int TestIndex = 0;
+                TestIndex < Group->TestCount;
+                ++TestIndex)
+            {
+                test *Test = Group->Tests + TestIndex;
+                Hashes[TestIndex] = Test->Type.Imp(MeowDefaultSeed, File->Size, File->Contents);
+            }
+            
+            Result = 1;
+            *FileSize = File->Size;
+            
+            if(HaveKey && (Key.Size == File->Size))
+            {
+                AppendScanIndex(&Group->Index, &Key, Hashes);
+            }
+        }
+    }
+    
+    if(Result)
+    {
+        ++Group->FileCount;
+        Group->ByteCount += *FileSize;
+    }
+    
+    return(Result);
+}
+
+static int
+PrintQuickStatus(test_group *Group)
+{
+    int Result = ((Group->FileCount % 10) == 0);
+    if(Result)
+    {
+        double Gigabyte = 1024.0*1024.0*1024.0;
+        printf("\r%0.0f files, %0.02fgb, %0.0f dupes, %0.0f chng",
+               (double)Group->FileCount,
+               (double)Group->ByteCount / (double)Gigabyte,
+               (double)Group->DuplicateFileCount,
+               (double)Group->ChangedFileCount);
+    }
+    
+    return(Result);
+}
+
+// NOTE: What reading another file in a hash chain showed, so that a file that
+// matches in several hash types is only read and compared once
+struct content_check
+{
+    content_check *Next;
+    path_node *Path;
+    int Readable;
+    int Identical;
+    meow_u128 Hashes[ArrayCount(NamedHashTypes)];
+};
+
+static content_check *
+CompareWithFile(test_group *Group, content_check **Checks, entire_file *File, path_node *OtherPath)
+{
+    content_check *Result = *Checks;
+    while(Result && (Result->Path != OtherPath))
+    {
+        Result = Result->Next;
+    }
+    
+    if(!Result)
+    {
+        Result = (content_check *)malloc(sizeof(content_check));
+        Result->Next = *Checks;
+        Result->Path = OtherPath;
+        *Checks = Result;
+        
+        entire_file OtherFile = ReadEntireFile(Group, OtherPath);
+        Result->Readable = (OtherFile.Contents != 0);
+        Result->Identical = (Result->Readable &&
+                             (File->Size == OtherFile.Size) &&
+                             (memcmp(File->Contents, OtherFile.Contents, File->Size) == 0));
+        if(Result->Readable && !Result->Identical)
+        {
+            // NOTE: Tells a collision (same digest now) from a file that changed since it was hashed
+            for(int TestIndex = 0;
+                TestIndex < Group->TestCount;
+                ++TestIndex)
+            {
+                test *Test = Group->Tests + TestIndex;
+                Result->Hashes[TestIndex] = Test->Type.Imp(MeowDefaultSeed, OtherFile.Size, OtherFile.Contents);
+            }
+        }
+        FreeEntireFile(&OtherFile);
+    }
+    
+    return(Result);
+}
+
+static void
+IngestFile(test_group *Group, path_node *Path)
+{
+    meow_u128 Hashes[ArrayCount(NamedHashTypes)];
+    meow_u64 FileSize = 0;
+    entire_file File = {};
+    
+    if(HashFile(Group, Path, Hashes, &FileSize, &File))
+    {
+        int QuickStatus = PrintQuickStatus(Group);
+        
+        // NOTE: HashFile only skips reading the file when the index had its digests
+        meow_u128 *IndexHashes = 0;
+        if(!File.Contents)
+        {
+            IndexHashes = (meow_u128 *)malloc(Group->TestCount*sizeof(meow_u128));
+            memcpy(IndexHashes, Hashes, Group->TestCount*sizeof(meow_u128));
+        }
+        
+        content_check *Checks = 0;
+        int DuplicateFileFound = 0;
+        int FileChanged = 0;
+        for(int TestIndex = 0;
+            TestIndex < Group->TestCount;
+            ++TestIndex)
+        {
+            test *Test = Group->Tests + TestIndex;
+            
+            meow_u128 Hash = Hashes[TestIndex];
+            
+            test_value **Slot = &Test->Table[MeowU32From(Hash, 0) % ArrayCount(Test->Table)];
+            test_value *Entry = *Slot;
+            while(Entry && memcmp(&Entry->Hash, &Hash, sizeof(Hash)))
+            {
+                Entry = Entry->Next;
+            }
+            
+            int IsCollision = 0;
+            if(Entry)
             {
                 for(test_file *Check = Entry->FirstFile;
                     Check;
                     Check = Check->Next)
                 {
-                    entire_file OtherFile = ReadEntireFile(Group, Check->FileName);
-                    meow_u128 OtherHash = Test->Type.Imp(MeowDefaultSeed, OtherFile.Size, OtherFile.Contents);
-                    if(MeowHashesAreEqual(Hash, OtherHash))
+                    int CheckIsCollision = 0;
+                    if(IndexHashes && Check->IndexHashes &&
+                       memcmp(IndexHashes, Check->IndexHashes, Group->TestCount*sizeof(meow_u128)))
+                    {
+                        // NOTE: Neither file has changed since its digests were made, so a
+                        // digest that differs means the contents do, without reading either.
+                        // Digests that all match still get compared below, since that's
+                        // exactly what a collision in every hash type would look like.
+                        CheckIsCollision = 1;
+                    }
+                    else
+                    {
+                        if(!File.Contents)
+                        {
+                            File = ReadEntireFile(Group, Path);
+                        }
+                        
+                        if(File.Contents)
+                        {
+                            content_check *Compare = CompareWithFile(Group, &Checks, &File, Check->Path);
+                            if(Compare->Identical)
+                            {
+                                DuplicateFileFound = 1;
+                            }
+                            else if(Compare->Readable && MeowHashesAreEqual(Hash, Compare->Hashes[TestIndex]))
+                            {
+                                CheckIsCollision = 1;
+                            }
+                            else
+                            {
+                                FileChanged = 1;
+                            }
+                        }
+                    }
+                    
+                    if(CheckIsCollision)
+                    {
+                        Check->IsCollision = 1;
+                        IsCollision = 1;
+                        ++Test->CollisionCount;
+                        WriteCollision(Group, Test, Hash, Path, Check->Path);
+                    }
+                }
+            }
+            else
+            {
+                Entry = (test_value *)malloc(sizeof(test_value));
+                Entry->Hash = Hash;
+                Entry->FirstFile = 0;
+                Entry->Next = *Slot;
+                *Slot = Entry;
+            }
+            
+            test_file *TestFile = (test_file *)malloc(sizeof(test_file));
+            TestFile->Path = Path;
+            TestFile->Next = Entry->FirstFile;
+            TestFile->IsCollision = IsCollision;
+            TestFile->IndexHashes = IndexHashes;
+            Entry->FirstFile = TestFile;
+            
+            if(QuickStatus && Test->CollisionCount)
+            {
+                printf(" %s:%u!", Test->Type.ShortName, (int unsigned)Test->CollisionCount);
+            }
+        }
+        
+        while(Checks)
+        {
+            content_check *Next = Checks->Next;
+            free(Checks);
+            Checks = Next;
+        }
+        
+        if(QuickStatus)
+        {
+            fflush(stdout);
+        }
+        
+        Group->DuplicateFileCount += DuplicateFileFound;
+        Group->ChangedFileCount += FileChanged;
+        
+        if((Group->FileCount % JOURNAL_CHECKPOINT_INTERVAL) == 0)
+        {
+            WriteCheckpoint(Group, Path);
+        }
+    }
+    
+    FreeEntireFile(&File);
+}
+
+//
+// NOTE: Dedup mode
+//
+// Most files have a size nobody else has, and so can never be duplicates.  Dedup
+// mode therefore works in stages, each of which only reads the files that survived
+// the one before:
+//
+//   1) group every file by size, from metadata alone
+//   2) for sizes shared by more than one file, hash a head/tail sample
+//   3) for files that still share a (size, sample) pair, hash the whole file
+//
+// Files small enough that the sample _is_ the whole file skip stage 3.
+//
+
+#define DEDUP_SAMPLE_SIZE 4096
+#define DEDUP_STREAM_SIZE (1024*1024)
+
+static int
+GetFileSizeOnDisk(path_storage *Paths, path_node *Path, meow_u64 *Size)
+{
+    int Result = 0;
+    
+    path_stat Stat;
+    if(StatPath(Paths, Path, &Stat))
+    {
+        *Size = (meow_u64)Stat.st_size;
+        Result = 1;
+    }
+    
+    return(Result);
+}
+
+static void
+AddDedupFile(test_group *Group, path_node *Path)
+{
+    meow_u64 Size;
+    if(GetFileSizeOnDisk(&Group->Paths, Path, &Size))
+    {
+        if(Group->DedupFileCount == Group->DedupFileMax)
+        {
+            meow_u64 NewMax = Group->DedupFileMax ? 2*Group->DedupFileMax : 4096;
+            dedup_file *NewFiles = (dedup_file *)realloc(Group->DedupFiles, NewMax*sizeof(dedup_file));
+            if(NewFiles)
+            {
+                Group->DedupFileMax = NewMax;
+                Group->DedupFiles = NewFiles;
+            }
+        }
+        
+        if(Group->DedupFileCount < Group->DedupFileMax)
+        {
+            dedup_file *File = Group->DedupFiles + Group->DedupFileCount++;
+            memset(File, 0, sizeof(*File));
+            File->Path = Path;
+            File->Size = Size;
+            
+            ++Group->FileCount;
+            Group->ByteCount += Size;
+            if((Group->FileCount % 1000) == 0)
+            {
+                printf("\r%0.0f files", (double)Group->FileCount);
+                fflush(stdout);
+            }
+        }
+        else
+        {
+            ++Group->AllocationFailureCount;
+        }
+    }
+    else
+    {
+        ++Group->AccessFailureCount;
+    }
+}
+
+static int
+CompareU128(meow_u128 A, meow_u128 B)
+{
+    int Result = memcmp(&A, &B, sizeof(A));
+    return(Result);
+}
+
+static int
+DedupCompareSize(const void *AInit, const void *BInit)
+{
+    dedup_file *A = (dedup_file *)AInit;
+    dedup_file *B = (dedup_file *)BInit;
+    
+    int Result = (A->Size < B->Size) ? -1 : (A->Size > B->Size) ? 1 : 0;
+    return(Result);
+}
+
+static int
+DedupCompareSample(const void *AInit, const void *BInit)
+{
+    dedup_file *A = (dedup_file *)AInit;
+    dedup_file *B = (dedup_file *)BInit;
+    
+    int Result = DedupCompareSize(A, B);
+    if(Result == 0)
+    {
+        Result = CompareU128(A->Sample, B->Sample);
+    }
+    return(Result);
+}
+
+static int
+DedupCompareFull(const void *AInit, const void *BInit)
+{
+    dedup_file *A = (dedup_file *)AInit;
+    dedup_file *B = (dedup_file *)BInit;
+    
+    int Result = DedupCompareSize(A, B);
+    if(Result == 0)
+    {
+        Result = CompareU128(A->Full, B->Full);
+    }
+    return(Result);
+}
+
+static int
+DedupCompareContents(const void *AInit, const void *BInit)
+{
+    dedup_file *A = (dedup_file *)AInit;
+    dedup_file *B = (dedup_file *)BInit;
+    
+    int Result = DedupCompareFull(A, B);
+    if(Result == 0)
+    {
+        Result = (A->Class < B->Class) ? -1 : (A->Class > B->Class) ? 1 : 0;
+    }
+    return(Result);
+}
+
+typedef int dedup_compare(const void *A, const void *B);
+
+static meow_u64
+KeepDedupGroups(dedup_file *Files, meow_u64 Count, dedup_compare *Compare)
+{
+    // NOTE: Sorts the files by the given key, then compacts them down to only
+    // the ones that share their key with at least one other file.
+    qsort(Files, Count, sizeof(Files[0]), Compare);
+    
+    meow_u64 Result = 0;
+    meow_u64 RunStart = 0;
+    while(RunStart < Count)
+    {
+        meow_u64 RunEnd = RunStart + 1;
+        while((RunEnd < Count) && (Compare(Files + RunStart, Files + RunEnd) == 0))
+        {
+            ++RunEnd;
+        }
+        
+        if((RunEnd - RunStart) > 1)
+        {
+            while(RunStart < RunEnd)
+            {
+                Files[Result++] = Files[RunStart++];
+            }
+        }
+        
+        RunStart = RunEnd;
+    }
+    
+    return(Result);
+}
+
+static int
+HashDedupSample(test_group *Group, dedup_file *File, meow_u8 *Buffer, meow_u64 *BytesRead)
+{
+    int Result = 0;
+    
+    FILE *Handle = OpenPathFile(&Group->Paths, File->Path);
+    if(Handle)
+    {
+        if(File->Size <= 2*DEDUP_SAMPLE_SIZE)
+        {
+            // NOTE: The sample would cover the whole file, so just hash the whole file
+            if((File->Size == 0) || (fread(Buffer, File->Size, 1, Handle) == 1))
+            {
+                File->Full = MeowHash(MeowDefaultSeed, File->Size, Buffer);
+                File->Sample = File->Full;
+                File->FullKnown = 1;
+                *BytesRead += File->Size;
+                Result = 1;
+            }
+        }
+        else
+        {
+            if((fread(Buffer, DEDUP_SAMPLE_SIZE, 1, Handle) == 1) &&
+               (fseek(Handle, -DEDUP_SAMPLE_SIZE, SEEK_END) == 0) &&
+               (fread(Buffer + DEDUP_SAMPLE_SIZE, DEDUP_SAMPLE_SIZE, 1, Handle) == 1))
+            {
+                File->Sample = MeowHash(MeowDefaultSeed, 2*DEDUP_SAMPLE_SIZE, Buffer);
+                *BytesRead += 2*DEDUP_SAMPLE_SIZE;
+                Result = 1;
+            }
+        }
+        
+        fclose(Handle);
+    }
+    
+    if(!Result)
+    {
+        ++Group->ReadFailureCount;
+    }
+    
+    return(Result);
+}
+
+static int
+HashDedupFull(test_group *Group, dedup_file *File, meow_u8 *Buffer, meow_u64 *BytesRead)
+{
+    int Result = 0;
+    
+    FILE *Handle = OpenPathFile(&Group->Paths, File->Path);
+    if(Handle)
+    {
+        meow_state State;
+        MeowBegin(&State, MeowDefaultSeed);
+        
+        meow_u64 Remaining = File->Size;
+        while(Remaining)
+        {
+            size_t Amount = (Remaining < DEDUP_STREAM_SIZE) ? (size_t)Remaining : DEDUP_STREAM_SIZE;
+            if(fread(Buffer, Amount, 1, Handle) != 1)
+            {
+                break;
+            }
+            
+            MeowAbsorb(&State, Amount, Buffer);
+            Remaining -= Amount;
+            *BytesRead += Amount;
+        }
+        
+        if(Remaining == 0)
+        {
+            File->Full = MeowEnd(&State, 0);
+            File->FullKnown = 1;
+            Result = 1;
+        }
+        
+        fclose(Handle);
+    }
+    
+    if(!Result)
+    {
+        ++Group->ReadFailureCount;
+    }
+    
+    return(Result);
+}
+
+// NOTE: Returns 1 if the two files' bytes are the same, 0 if they differ, and -1 if
+// either couldn't be read all the way through (which is counted)
+static int
+CompareDedupContents(test_group *Group, dedup_file *A, dedup_file *B, meow_u8 *Buffer, meow_u64 *BytesRead)
+{
+    int Result = -1;
+    
+    FILE *HandleA = OpenPathFile(&Group->Paths, A->Path);
+    FILE *HandleB = OpenPathFile(&Group->Paths, B->Path);
+    if(HandleA && HandleB)
+    {
+        meow_u8 *BufferA = Buffer;
+        meow_u8 *BufferB = Buffer + DEDUP_STREAM_SIZE/2;
+        
+        Result = 1;
+        meow_u64 Remaining = A->Size;
+        while((Result == 1) && Remaining)
+        {
+            size_t Amount = (Remaining < DEDUP_STREAM_SIZE/2) ? (size_t)Remaining : DEDUP_STREAM_SIZE/2;
+            if((fread(BufferA, Amount, 1, HandleA) != 1) ||
+               (fread(BufferB, Amount, 1, HandleB) != 1))
+            {
+                Result = -1;
+            }
+            else if(memcmp(BufferA, BufferB, Amount))
+            {
+                Result = 0;
+            }
+            
+            Remaining -= Amount;
+            *BytesRead += 2*Amount;
+        }
+    }
+    
+    if(HandleA)
+    {
+        fclose(HandleA);
+    }
+    if(HandleB)
+    {
+        fclose(HandleB);
+    }
+    
+    if(Result < 0)
+    {
+        ++Group->ReadFailureCount;
+    }
+    
+    return(Result);
+}
+
+static meow_u64
+DropUnreadable(dedup_file *Files, meow_u64 Count)
+{
+    meow_u64 Result = 0;
+    for(meow_u64 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        // NOTE: Files that failed to read are marked with an impossible size
+        if(Files[Index].Size != (meow_u64)-1)
+        {
+            Files[Result++] = Files[Index];
+        }
+    }
+    return(Result);
+}
+
+static void
+RunDedup(test_group *Group)
+{
+    dedup_file *Files = Group->DedupFiles;
+    meow_u64 Count = Group->DedupFileCount;
+    // NOTE: Every byte the dedup stages hash passes through this buffer, so keep it on
+    // the NUMA node we're running on rather than wherever the allocator finds room
+    meow_u8 *Buffer = (meow_u8 *)NUMAAlloc(DEDUP_STREAM_SIZE, GetCurrentNUMANode());
+    if(!Buffer)
+    {
+        printf("\nERROR: Unable to allocate the dedup buffer.\n");
+        ++Group->AllocationFailureCount;
+        Count = 0;
+    }
+    
+    // NOTE: Stage 1 - sizes only
+    Count = KeepDedupGroups(Files, Count, DedupCompareSize);
+    meow_u64 SizeCandidates = Count;
+    printf("\nStage 1: %0.0f files share a size with another file\n", (double)Count);
+    
+    // NOTE: Stage 2 - head/tail sample
+    meow_u64 SampleBytes = 0;
+    for(meow_u64 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        if(!HashDedupSample(Group, Files + Index, Buffer, &SampleBytes))
+        {
+            Files[Index].Size = (meow_u64)-1;
+        }
+    }
+    Count = DropUnreadable(Files, Count);
+    Count = KeepDedupGroups(Files, Count, DedupCompareSample);
+    meow_u64 SampleCandidates = Count;
+    printf("Stage 2: %0.0f files share a size and sample with another file\n", (double)Count);
+    
+    // NOTE: Stage 3 - full streaming hash
+    meow_u64 FullBytes = 0;
+    for(meow_u64 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        if(!Files[Index].FullKnown &&
+           !HashDedupFull(Group, Files + Index, Buffer, &FullBytes))
+        {
+            Files[Index].Size = (meow_u64)-1;
+        }
+    }
+    Count = DropUnreadable(Files, Count);
+    Count = KeepDedupGroups(Files, Count, DedupCompareFull);
+    meow_u64 FullCandidates = Count;
+    printf("Stage 3: %0.0f files share a size and full hash with another file\n", (double)Count);
+    
+    // NOTE: Stage 4 - byte compare.  Equal hashes are only a candidate; every file
+    // in a run is compared against the first file of each class found so far, so a
+    // real collision ends up in a class of its own instead of being called a duplicate.
+    meow_u64 CompareBytes = 0;
+    meow_u64 CollisionCount = 0;
+    meow_u64 RunStart = 0;
+    while(RunStart < Count)
+    {
+        meow_u64 RunEnd = RunStart + 1;
+        while((RunEnd < Count) && (DedupCompareFull(Files + RunStart, Files + RunEnd) == 0))
+        {
+            ++RunEnd;
+        }
+        
+        meow_u32 NextClass = 1;
+        for(meow_u64 Index = RunStart;
+            Index < RunEnd;
+            ++Index)
+        {
+            dedup_file *File = Files + Index;
+            File->Class = 0;
+            
+            // NOTE: Classes are numbered as their first files turn up, so those are
+            // the files whose class is one past the last class tried
+            meow_u32 TriedClass = 0;
+            for(meow_u64 FirstIndex = RunStart;
+                !File->Class && (FirstIndex < Index);
+                ++FirstIndex)
+            {
+                dedup_file *First = Files + FirstIndex;
+                if(First->Class == (TriedClass + 1))
+                {
+                    ++TriedClass;
+                    int Same = CompareDedupContents(Group, First, File, Buffer, &CompareBytes);
+                    if(Same > 0)
+                    {
+                        File->Class = First->Class;
+                    }
+                    else if(Same == 0)
+                    {
+                        ++CollisionCount;
+                    }
+                }
+            }
+            
+            if(!File->Class)
+            {
+                File->Class = NextClass++;
+            }
+        }
+        
+        RunStart = RunEnd;
+    }
+    Count = KeepDedupGroups(Files, Count, DedupCompareContents);
+    printf("Stage 4: %0.0f files are duplicates", (double)Count);
+    if(CollisionCount)
+    {
+        printf(" (%0.0f HASH COLLISIONS: pairs of different files with the same hash)", (double)CollisionCount);
+    }
+    printf("\n");
+    
+    NUMAFree(Buffer, DEDUP_STREAM_SIZE);
+    
+    // NOTE: Report
+    FILE *R = fopen(Group->ReportFileName, "wb");
+    if(R)
+    {
+        fprintf(R, "meow_search %s dedup results:\n", MEOW_HASH_VERSION_NAME);
+        fprintf(R, "    Root: %s\n", Group->RootPath);
+        PrintJournalTime(R, "Completed on");
+        fprintf(R, "    Files: %0.0f\n", (double)Group->FileCount);
+        fprintf(R, "    Total size: ");
+        PrintSize(R, Group->ByteCount, false);
+        fprintf(R, "\n");
+        fprintf(R, "    Files sharing a size: %0.0f\n", (double)SizeCandidates);
+        fprintf(R, "    Files sharing a size and sample: %0.0f\n", (double)SampleCandidates);
+        fprintf(R, "    Files sharing a size and full hash: %0.0f\n", (double)FullCandidates);
+        fprintf(R, "    Duplicate files: %0.0f\n", (double)Count);
+        fprintf(R, "    Hash collisions (file pairs): %0.0f\n", (double)CollisionCount);
+        fprintf(R, "    Bytes read for samples: ");
+        PrintSize(R, SampleBytes, false);
+        fprintf(R, "\n");
+        fprintf(R, "    Bytes read for full hashes: ");
+        PrintSize(R, FullBytes, false);
+        fprintf(R, "\n");
+        fprintf(R, "    Bytes read for comparisons: ");
+        PrintSize(R, CompareBytes, false);
+        fprintf(R, "\n");
+        fprintf(R, "    Access failures: %0.0f\n", (double)Group->AccessFailureCount);
+        fprintf(R, "    Allocation failures: %0.0f\n",
+                (double)(Group->AllocationFailureCount + Group->Paths.AllocationFailureCount));
+        fprintf(R, "    Read failures: %0.0f\n", (double)Group->ReadFailureCount);
+        
+        RunStart = 0;
+        while(RunStart < Count)
+        {
+            dedup_file *First = Files + RunStart;
+            fprintf(R, "    ");
+            PrintHash(R, First->Full);
+            fprintf(R, " (%.0f bytes):\n", (double)First->Size);
+            
+            meow_u64 RunEnd = RunStart;
+            while((RunEnd < Count) && (DedupCompareContents(First, Files + RunEnd) == 0))
+            {
+                fprintf(R, "        ");
+                PrintPath(R, Files[RunEnd].Path);
+                fprintf(R, "\n");
+                ++RunEnd;
+            }
+            
+            RunStart = RunEnd;
+        }
+        
+        fclose(R);
+    }
+    else
+    {
+        printf("ERROR: Unable to open %s for writing.\n", Group->ReportFileName);
+    }
+    
+    meow_u64 BytesRead = SampleBytes + FullBytes + CompareBytes;
+    printf("Read ");
+    PrintSize(stdout, BytesRead, false);
+    printf(" of ");
+    PrintSize(stdout, Group->ByteCount, false);
+    if(BytesRead && (BytesRead < Group->ByteCount))
+    {
+        printf(" (%0.1fx less than hashing everything)", (double)Group->ByteCount / (double)BytesRead);
+    }
+    printf("\n");
+}
+
+//
+// NOTE: External mode
+//
+// For trees with more files than the test tables can hold in memory, nothing is
+// kept per file during the walk.  Each file's path is appended to a temporary
+// paths file, and its offset there becomes the file id.  Every hash type gets
+// its own external sorter, which buffers (hash, file id) records up to its share
+// of the memory budget, then sorts and spills them as a run.  After the walk, the
+// runs for each hash type are k-way merged, so records with the same hash come
+// out next to each other and collisions and duplicates can be found in a single
+// streaming pass.  The only files ever re-read are ones that share a hash.
+//
+
+#define EXTERNAL_DEFAULT_MEMORY_MB 1024
+#define EXTERNAL_MIN_READ_RECORDS 4096
+
+struct external_run
+{
+    FILE *File;
+    external_record *Buffer;
+    meow_u64 BufferMax;
+    meow_u64 Count;
+    meow_u64 At;
+};
+
+struct external_merge
+{
+    meow_u32 RunCount;
+    external_run *Runs;
+    
+    // NOTE: Min-heap of run indices, ordered by each run's current record
+    meow_u32 HeapCount;
+    meow_u32 *Heap;
+};
+
+static char *
+ExternalFileName(char *Directory, char *Prefix, meow_u32 RunIndex)
+{
+    size_t Size = strlen(Directory) + strlen(Prefix) + 32;
+    char *Result = (char *)malloc(Size);
+    snprintf(Result, Size, "%s/meow_%s_%u.run", Directory, Prefix, RunIndex);
+    return(Result);
+}
+
+static meow_u128
+ExternalRecordHash(external_record *Record)
+{
+    meow_u128 Result;
+    memcpy(&Result, Record->Hash, sizeof(Result));
+    return(Result);
+}
+
+static int
+ExternalHashesAreEqual(external_record *A, external_record *B)
+{
+    int Result = ((A->Hash[0] == B->Hash[0]) && (A->Hash[1] == B->Hash[1]));
+    return(Result);
+}
+
+static int
+CompareExternalRecords(external_record *A, external_record *B)
+{
+    // NOTE: Any total order that groups equal hashes works, so compare whole words
+    // rather than bytes; this comparison is most of the cost of sorting and merging.
+    meow_u64 A0 = A->Hash[0], B0 = B->Hash[0];
+    meow_u64 A1 = A->Hash[1], B1 = B->Hash[1];
+    int Result = ((A0 != B0) ? ((A0 < B0) ? -1 : 1) :
+                  (A1 != B1) ? ((A1 < B1) ? -1 : 1) :
+                  (A->FileId != B->FileId) ? ((A->FileId < B->FileId) ? -1 : 1) :
+                  0);
+    return(Result);
+}
+
+static void
+SortExternalRecords(external_record *Records, external_record *Temp, meow_u64 Count)
+{
+    // NOTE: qsort spends most of its time calling the comparison, so runs are
+    // radix sorted on the first hash word instead, eight bits at a time.  Digits
+    // that are the same for every record (like the zeroed bytes of a truncated hash)
+    // are skipped.  The sort is stable, so records with equal hashes stay in the order
+    // they were pushed.
+    meow_u64 Histograms[8][256] = {};
+    for(meow_u64 Index = 0;
+        Index < Count;
+        ++Index)
+    {
+        meow_u64 Key = Records[Index].Hash[0];
+        for(int Digit = 0;
+            Digit < 8;
+            ++Digit)
+        {
+            ++Histograms[Digit][(Key >> (8*Digit)) & 0xff];
+        }
+    }
+    
+    external_record *Source = Records;
+    external_record *Dest = Temp;
+    for(int Digit = 0;
+        Digit < 8;
+        ++Digit)
+    {
+        meow_u64 *Histogram = Histograms[Digit];
+        int Shift = 8*Digit;
+        if(Histogram[(Source[0].Hash[0] >> Shift) & 0xff] != Count)
+        {
+            meow_u64 Offset = 0;
+            for(int Bucket = 0;
+                Bucket < 256;
+                ++Bucket)
+            {
+                meow_u64 BucketCount = Histogram[Bucket];
+                Histogram[Bucket] = Offset;
+                Offset += BucketCount;
+            }
+            
+            for(meow_u64 Index = 0;
+                Index < Count;
+                ++Index)
+            {
+                external_record *Record = Source + Index;
+                Dest[Histogram[(Record->Hash[0] >> Shift) & 0xff]++] = *Record;
+            }
+            
+            external_record *Swap = Source;
+            Source = Dest;
+            Dest = Swap;
+        }
+    }
+    
+    if(Source != Records)
+    {
+        memcpy(Records, Source, Count*sizeof(external_record));
+    }
+    
+    // NOTE: Records that share a first word still need ordering by the rest of the
+    // record, which is almost always already the case, so insertion sort finishes it.
+    for(meow_u64 Index = 1;
+        Index < Count;
+        ++Index)
+    {
+        if(CompareExternalRecords(Records + Index - 1, Records + Index) > 0)
+        {
+            external_record Record = Records[Index];
+            meow_u64 Insert = Index;
+            while(Insert && (CompareExternalRecords(Records + Insert - 1, &Record) > 0))
+            {
+                Records[Insert] = Records[Insert - 1];
+                --Insert;
+            }
+            Records[Insert] = Record;
+        }
+    }
+}
+
+static void
+InitExternalSorter(external_sorter *Sorter, char *Directory, char *Prefix, meow_u64 MemorySize)
+{
+    Sorter->Directory = Directory;
+    Sorter->Prefix = Prefix;
+    Sorter->RecordMax = MemorySize / (2*sizeof(external_record));
+    if(Sorter->RecordMax < EXTERNAL_MIN_READ_RECORDS)
+    {
+        Sorter->RecordMax = EXTERNAL_MIN_READ_RECORDS;
+    }
+    Sorter->RecordCount = 0;
+    Sorter->Records = (external_record *)malloc(Sorter->RecordMax*sizeof(external_record));
+    Sorter->SortTemp = (external_record *)malloc(Sorter->RecordMax*sizeof(external_record));
+    Sorter->RunCount = 0;
+    Sorter->SpilledCount = 0;
+    Sorter->Failed = (!Sorter->Records || !Sorter->SortTemp);
+}
+
+static void
+SpillExternalRun(external_sorter *Sorter)
+{
+    SortExternalRecords(Sorter->Records, Sorter->SortTemp, Sorter->RecordCount);
+    
+    char *RunName = ExternalFileName(Sorter->Directory, Sorter->Prefix, Sorter->RunCount);
+    FILE *Run = fopen(RunName, "wb");
+    if(Run &&
+       (fwrite(Sorter->Records, sizeof(external_record), Sorter->RecordCount, Run) == Sorter->RecordCount) &&
+       (fclose(Run) == 0))
+    {
+        ++Sorter->RunCount;
+        Sorter->SpilledCount += Sorter->RecordCount;
+    }
+    else
+    {
+        printf("\nERROR: Unable to write %s.\n", RunName);
+        Sorter->Failed = 1;
+    }
+    free(RunName);
+    
+    Sorter->RecordCount = 0;
+}
+
+static void
+PushExternalRecord(external_sorter *Sorter, meow_u128 Hash, meow_u64 FileId)
+{
+    if(Sorter->RecordCount == Sorter->RecordMax)
+    {
+        SpillExternalRun(Sorter);
+    }
+    
+    external_record *Record = Sorter->Records + Sorter->RecordCount++;
+    memcpy(Record->Hash, &Hash, sizeof(Record->Hash));
+    Record->FileId = FileId;
+}
+
+static int
+FillExternalRun(external_run *Run)
+{
+    Run->Count = fread(Run->Buffer, sizeof(external_record), Run->BufferMax, Run->File);
+    Run->At = 0;
+    return(Run->Count != 0);
+}
+
+static int
+ExternalRunLess(external_merge *Merge, meow_u32 A, meow_u32 B)
+{
+    external_run *RunA = Merge->Runs + A;
+    external_run *RunB = Merge->Runs + B;
+    int Result = (CompareExternalRecords(RunA->Buffer + RunA->At, RunB->Buffer + RunB->At) < 0);
+    return(Result);
+}
+
+static void
+SiftExternalHeap(external_merge *Merge, meow_u32 Index)
+{
+    for(;;)
+    {
+        meow_u32 Smallest = Index;
+        meow_u32 Left = 2*Index + 1;
+        meow_u32 Right = Left + 1;
+        if((Left < Merge->HeapCount) && ExternalRunLess(Merge, Merge->Heap[Left], Merge->Heap[Smallest]))
+        {
+            Smallest = Left;
+        }
+        if((Right < Merge->HeapCount) && ExternalRunLess(Merge, Merge->Heap[Right], Merge->Heap[Smallest]))
+        {
+            Smallest = Right;
+        }
+        if(Smallest == Index)
+        {
+            break;
+        }
+        
+        meow_u32 Temp = Merge->Heap[Index];
+        Merge->Heap[Index] = Merge->Heap[Smallest];
+        Merge->Heap[Smallest] = Temp;
+        Index = Smallest;
+    }
+}
+
+static int
+BeginExternalMerge(external_sorter *Sorter, external_merge *Merge, meow_u64 MemorySize)
+{
+    // NOTE: Whatever is still buffered becomes the last run, and the sort buffer
+    // is released so the whole budget can go to the merge's read buffers.
+    if(Sorter->RecordCount)
+    {
+        SpillExternalRun(Sorter);
+    }
+    free(Sorter->Records);
+    free(Sorter->SortTemp);
+    Sorter->Records = 0;
+    Sorter->SortTemp = 0;
+    
+    Merge->RunCount = Sorter->RunCount;
+    Merge->Runs = (external_run *)calloc(Merge->RunCount + 1, sizeof(external_run));
+    Merge->Heap = (meow_u32 *)calloc(Merge->RunCount + 1, sizeof(meow_u32));
+    Merge->HeapCount = 0;
+    
+    meow_u64 BufferMax = (MemorySize / sizeof(external_record)) / (Merge->RunCount + 1);
+    if(BufferMax < EXTERNAL_MIN_READ_RECORDS)
+    {
+        BufferMax = EXTERNAL_MIN_READ_RECORDS;
+    }
+    
+    int Result = !Sorter->Failed;
+    for(meow_u32 RunIndex = 0;
+        Result && (RunIndex < Merge->RunCount);
+        ++RunIndex)
+    {
+        external_run *Run = Merge->Runs + RunIndex;
+        char *RunName = ExternalFileName(Sorter->Directory, Sorter->Prefix, RunIndex);
+        Run->File = fopen(RunName, "rb");
+        Run->BufferMax = BufferMax;
+        Run->Buffer = (external_record *)malloc(BufferMax*sizeof(external_record));
+        if(Run->File && Run->Buffer)
+        {
+            if(FillExternalRun(Run))
+            {
+                Merge->Heap[Merge->HeapCount++] = RunIndex;
+            }
+        }
+        else
+        {
+            printf("ERROR: Unable to read %s.\n", RunName);
+            Result = 0;
+        }
+        free(RunName);
+    }
+    
+    for(meow_u32 Index = Merge->HeapCount / 2;
+        Index > 0;
+        --Index)
+    {
+        SiftExternalHeap(Merge, Index - 1);
+    }
+    
+    return(Result);
+}
+
+static int
+NextExternalRecord(external_merge *Merge, external_record *Record)
+{
+    int Result = 0;
+    
+    if(Merge->HeapCount)
+    {
+        external_run *Run = Merge->Runs + Merge->Heap[0];
+        *Record = Run->Buffer[Run->At++];
+        if((Run->At == Run->Count) && !FillExternalRun(Run))
+        {
+            Merge->Heap[0] = Merge->Heap[--Merge->HeapCount];
+        }
+        SiftExternalHeap(Merge, 0);
+        
+        Result = 1;
+    }
+    
+    return(Result);
+}
+
+static void
+EndExternalMerge(external_sorter *Sorter, external_merge *Merge)
+{
+    for(meow_u32 RunIndex = 0;
+        RunIndex < Merge->RunCount;
+        ++RunIndex)
+    {
+        external_run *Run = Merge->Runs + RunIndex;
+        if(Run->File)
+        {
+            fclose(Run->File);
+        }
+        free(Run->Buffer);
+        
+        char *RunName = ExternalFileName(Sorter->Directory, Sorter->Prefix, RunIndex);
+        remove(RunName);
+        free(RunName);
+    }
+    
+    free(Merge->Runs);
+    free(Merge->Heap);
+    Merge->Runs = 0;
+    Merge->Heap = 0;
+}
+
+static char *
+ReadExternalPath(FILE *Paths, meow_u64 FileId)
+{
+    size_t Max = 256;
+    size_t Count = 0;
+    char *Result = (char *)malloc(Max);
+    
+    fseek(Paths, FileId, SEEK_SET);
+    int Char;
+    while(((Char = fgetc(Paths)) != EOF) && Char)
+    {
+        if((Count + 1) == Max)
+        {
+            Max *= 2;
+            Result = (char *)realloc(Result, Max);
+        }
+        Result[Count++] = (char)Char;
+    }
+    Result[Count] = 0;
+    
+    return(Result);
+}
+
+static int
+BeginExternal(test_group *Group)
+{
+    int Result = 0;
+    
+    char *PathsName = ExternalFileName(Group->ExternalDirectory, (char *)"paths", 0);
+    Group->ExternalPaths = fopen(PathsName, "w+b");
+    if(Group->ExternalPaths)
+    {
+        // NOTE: Every hash type's sorter is filling at once during the walk
+        Group->ExternalSorters = (external_sorter *)calloc(Group->TestCount, sizeof(external_sorter));
+        for(int TestIndex = 0;
+            TestIndex < Group->TestCount;
+            ++TestIndex)
+        {
+            InitExternalSorter(Group->ExternalSorters + TestIndex, Group->ExternalDirectory,
+                               Group->Tests[TestIndex].Type.ShortName,
+                               Group->ExternalMemory / Group->TestCount);
+        }
+        
+        Result = 1;
+    }
+    else
+    {
+        printf("ERROR: Unable to create %s.\n", PathsName);
+    }
+    free(PathsName);
+    
+    return(Result);
+}
+
+static void
+ExternalIngestFile(test_group *Group, path_node *Path)
+{
+    meow_u128 Hashes[ArrayCount(NamedHashTypes)];
+    meow_u64 FileSize = 0;
+    entire_file File = {};
+    
+    if(HashFile(Group, Path, Hashes, &FileSize, &File))
+    {
+        meow_u64 FileId = ftell(Group->ExternalPaths);
+        PrintPath(Group->ExternalPaths, Path);
+        fputc(0, Group->ExternalPaths);
+        
+        for(int TestIndex = 0;
+            TestIndex < Group->TestCount;
+            ++TestIndex)
+        {
+            PushExternalRecord(Group->ExternalSorters + TestIndex, Hashes[TestIndex], FileId);
+        }
+        
+        if(PrintQuickStatus(Group))
+        {
+            fflush(stdout);
+        }
+    }
+    
+    FreeEntireFile(&File);
+}
+
+static void
+RunExternal(test_group *Group)
+{
+    fflush(Group->ExternalPaths);
+    
+    // NOTE: Files are reopened by full path from here on
+    Group->Paths.CurrentDir = 0;
+    
+    for(int TestIndex = 0;
+        TestIndex < Group->TestCount;
+        ++TestIndex)
+    {
+        test *Test = Group->Tests + TestIndex;
+        external_sorter *Sorter = Group->ExternalSorters + TestIndex;
+        
+        double MergeStart = GetWallClock();
+        meow_u64 RecordCount = Sorter->SpilledCount + Sorter->RecordCount;
+        
+        external_merge Merge = {};
+        if(BeginExternalMerge(Sorter, &Merge, Group->ExternalMemory))
+        {
+            // NOTE: Each record is checked against the first record with the same hash,
+            // which is the only file held in memory.
+            external_record First = {};
+            int HaveFirst = 0;
+            char *FirstName = 0;
+            entire_file FirstFile = {};
+            
+            external_record Record;
+            while(NextExternalRecord(&Merge, &Record))
+            {
+                if(HaveFirst && ExternalHashesAreEqual(&First, &Record))
+                {
+                    path_node FirstPath = {0, FirstName};
+                    if(!FirstFile.Contents)
+                    {
+                        FirstFile = ReadEntireFile(Group, &FirstPath);
+                    }
+                    
+                    char *FileName = ReadExternalPath(Group->ExternalPaths, Record.FileId);
+                    path_node Path = {0, FileName};
+                    entire_file File = ReadEntireFile(Group, &Path);
+                    
+                    if(FirstFile.Contents && File.Contents)
                     {
-                        if(OtherFile.Contents &&
-                           ((File.Size != OtherFile.Size) ||
-                            memcmp(File.Contents, OtherFile.Contents, File.Size)))
+                        meow_u128 FirstHash = Test->Type.Imp(MeowDefaultSeed, FirstFile.Size, FirstFile.Contents);
+                        meow_u128 Hash = Test->Type.Imp(MeowDefaultSeed, File.Size, File.Contents);
+                        if(!MeowHashesAreEqual(FirstHash, ExternalRecordHash(&First)) ||
+                           !MeowHashesAreEqual(Hash, ExternalRecordHash(&Record)))
+                        {
+                            if(TestIndex == MEOW_HASH_TEST_INDEX_128)
+                            {
+                                ++Group->ChangedFileCount;
+                            }
+                        }
+                        else if((File.Size != FirstFile.Size) ||
+                                memcmp(File.Contents, FirstFile.Contents, File.Size))
                         {
-                            Check->IsCollision = 1;
-                            IsCollision = 1;
                             ++Test->CollisionCount;
+                            WriteCollision(Group, Test, Hash, &Path, &FirstPath);
                         }
-                        else
+                        else if(TestIndex == MEOW_HASH_TEST_INDEX_128)
                         {
-                            DuplicateFileFound = 1;
+                            ++Group->DuplicateFileCount;
                         }
                     }
-                    else
-                    {
-                        FileChanged = 1;
-                    }
-                    FreeEntireFile(&OtherFile);
+                    
+                    FreeEntireFile(&File);
+                    free(FileName);
+                }
+                else
+                {
+                    FreeEntireFile(&FirstFile);
+                    free(FirstName);
+                    
+                    First = Record;
+                    HaveFirst = 1;
+                    FirstName = ReadExternalPath(Group->ExternalPaths, Record.FileId);
                 }
             }
+            
+            FreeEntireFile(&FirstFile);
+            free(FirstName);
+        }
+        EndExternalMerge(Sorter, &Merge);
+        
+        double Seconds = GetWallClock() - MergeStart;
+        printf("[%s] merged %0.0f records from %u runs in %0.2fs, %0.0f collisions\n",
+               Test->Type.ShortName, (double)RecordCount, Merge.RunCount, Seconds,
+               (double)Test->CollisionCount);
+    }
+    
+    fclose(Group->ExternalPaths);
+    Group->ExternalPaths = 0;
+    
+    char *PathsName = ExternalFileName(Group->ExternalDirectory, (char *)"paths", 0);
+    remove(PathsName);
+    free(PathsName);
+}
+
+//
+// NOTE: The external benchmark runs the same spill/merge on synthetic records,
+// without touching the file system for anything but the runs.  The hashes are
+// truncated to 32 bits so that the merge has plenty of equal-hash runs to find,
+// and the number it finds can be checked against the birthday bound.
+//
+
+static int
+RunExternalBench(char *Directory, meow_u64 RecordCount, meow_u64 MemorySize)
+{
+    int Result = -1;
+    
+    printf("meow_search %s external benchmark: %0.0f records, %0.0fmb memory, in %s\n",
+           MEOW_HASH_VERSION_NAME, (double)RecordCount,
+           (double)(MemorySize / (1024*1024)), Directory);
+    
+    external_sorter Sorter = {};
+    InitExternalSorter(&Sorter, Directory, (char *)"bench", MemorySize);
+    
+    double SpillStart = GetWallClock();
+    for(meow_u64 RecordIndex = 0;
+        !Sorter.Failed && (RecordIndex < RecordCount);
+        ++RecordIndex)
+    {
+        meow_u128 Hash = MeowHashTruncate32(MeowDefaultSeed, sizeof(RecordIndex), &RecordIndex);
+        PushExternalRecord(&Sorter, Hash, RecordIndex);
+        
+        if((RecordIndex % (16*1024*1024)) == 0)
+        {
+            printf("\rspill: %0.0f records", (double)RecordIndex);
+            fflush(stdout);
+        }
+    }
+    double MergeStart = GetWallClock();
+    printf("\rspill: %0.0f records in %u runs, %0.2fs\n",
+           (double)RecordCount, Sorter.RunCount + (Sorter.RecordCount != 0), MergeStart - SpillStart);
+    
+    external_merge Merge = {};
+    if(BeginExternalMerge(&Sorter, &Merge, MemorySize))
+    {
+        meow_u64 MergedCount = 0;
+        meow_u64 PairCount = 0;
+        meow_u64 OrderFailures = 0;
+        meow_u64 RunLength = 0;
+        
+        external_record Last = {};
+        external_record Record;
+        while(NextExternalRecord(&Merge, &Record))
+        {
+            if(MergedCount && ExternalHashesAreEqual(&Last, &Record))
+            {
+                PairCount += RunLength++;
+            }
             else
             {
-                Entry = (test_value *)malloc(sizeof(test_value));
-                Entry->Hash = Hash;
-                Entry->FirstFile = 0;
-                Entry->Next = *Slot;
-                *Slot = Entry;
+                RunLength = 1;
             }
             
-            test_file *TestFile = (test_file *)malloc(sizeof(test_file));
-            TestFile->FileName = FileName;
-            TestFile->Next = Entry->FirstFile;
-            TestFile->IsCollision = IsCollision;
-            Entry->FirstFile = TestFile;
-            
-            if(QuickStatus && Test->CollisionCount)
+            if(MergedCount && (CompareExternalRecords(&Last, &Record) > 0))
             {
-                printf(" %s:%u!", Test->Type.ShortName, (int unsigned)Test->CollisionCount);
+                ++OrderFailures;
             }
+            
+            Last = Record;
+            ++MergedCount;
         }
+        double MergeEnd = GetWallClock();
         
-        if(QuickStatus)
+        double Spill = MergeStart - SpillStart;
+        double Merged = MergeEnd - MergeStart;
+        double Megabyte = 1024.0*1024.0;
+        double Bytes = (double)RecordCount*(double)sizeof(external_record);
+        double Expected = 0.5*(double)RecordCount*(double)(RecordCount - 1) / 4294967296.0;
+        printf("merge: %0.0f records from %u runs, %0.2fs\n", (double)MergedCount, Merge.RunCount, Merged);
+        printf("total: %0.2fs, %0.2fm records/s, %0.0fmb/s spilled, %0.0fmb/s merged\n",
+               Spill + Merged, (double)RecordCount / (Spill + Merged) / 1000000.0,
+               Bytes / Spill / Megabyte, Bytes / Merged / Megabyte);
+        printf("equal-hash pairs: %0.0f (%0.0f expected for a 32-bit hash)\n", (double)PairCount, Expected);
+        
+        if((MergedCount == RecordCount) && !OrderFailures)
         {
-            fflush(stdout);
+            Result = 0;
+        }
+        else
+        {
+            printf("ERROR: merge produced %0.0f records with %0.0f out of order.\n",
+                   (double)MergedCount, (double)OrderFailures);
         }
-        
-        Group->DuplicateFileCount += DuplicateFileFound;
-        Group->ChangedFileCount += FileChanged;
     }
+    EndExternalMerge(&Sorter, &Merge);
     
-    FreeEntireFile(&File);
+    return(Result);
+}
+
+static void
+VisitFile(test_group *Group, path_node *Path)
+{
+    if(Group->DedupMode)
+    {
+        AddDedupFile(Group, Path);
+    }
+    else if(Group->ExternalDirectory)
+    {
+        ExternalIngestFile(Group, Path);
+    }
+    else
+    {
+        IngestFile(Group, Path);
+    }
 }
 
 static void IngestDirectoriesRecursively(test_group *Group, char *Path);
@@ -311,11 +2714,121 @@ int main(int ArgCount, char **Args)
 
     InitializeHashesThatNeedInitializers();
     
-    if(ArgCount == 3)
+    // NOTE: Pull out any options, leaving the positional arguments in order
+    char *IndexFileName = 0;
+    int Resume = 0;
+    int DedupMode = 0;
+    int PrintStats = 0;
+    char *ExternalDirectory = 0;
+    char *ExternalBenchDirectory = 0;
+    meow_u64 ExternalMemoryMB = EXTERNAL_DEFAULT_MEMORY_MB;
+    int PageKind = Pages_Default;
+    meow_u64 ExternalBenchRecords = 1000000000ull;
+    char *Positional[2] = {};
+    int PositionalCount = 0;
+    int ArgsOk = 1;
+    for(int ArgIndex = 1;
+        ArgIndex < ArgCount;
+        ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if((strcmp(Arg, "-index") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            IndexFileName = Args[++ArgIndex];
+        }
+        else if(strcmp(Arg, "-resume") == 0)
+        {
+            Resume = 1;
+        }
+        else if(strcmp(Arg, "-dedup") == 0)
+        {
+            DedupMode = 1;
+        }
+        else if(strcmp(Arg, "-stats") == 0)
+        {
+            PrintStats = 1;
+        }
+        else if((strcmp(Arg, "-external") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ExternalDirectory = Args[++ArgIndex];
+        }
+        else if((strcmp(Arg, "-external-bench") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ExternalBenchDirectory = Args[++ArgIndex];
+        }
+        else if((strcmp(Arg, "-memory") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ExternalMemoryMB = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((strcmp(Arg, "-pages") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            char *KindName = Args[++ArgIndex];
+            PageKind = -1;
+            for(int KindIndex = 0;
+                KindIndex < Pages_Count;
+                ++KindIndex)
+            {
+                if(strcmp(KindName, PageKindNames[KindIndex]) == 0)
+                {
+                    PageKind = KindIndex;
+                }
+            }
+        }
+        else if((strcmp(Arg, "-records") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ExternalBenchRecords = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if((Arg[0] != '-') && (PositionalCount < ArrayCount(Positional)))
+        {
+            Positional[PositionalCount++] = Arg;
+        }
+        else
+        {
+            ArgsOk = 0;
+        }
+    }
+    
+    if(DedupMode && (Resume || IndexFileName))
+    {
+        printf("ERROR: -dedup cannot be combined with -index or -resume.\n");
+        ArgsOk = 0;
+    }
+    
+    if(ExternalDirectory && (Resume || DedupMode))
+    {
+        printf("ERROR: -external cannot be combined with -dedup or -resume.\n");
+        ArgsOk = 0;
+    }
+    
+    if(ExternalMemoryMB == 0)
+    {
+        printf("ERROR: -memory must be at least 1 megabyte.\n");
+        ArgsOk = 0;
+    }
+    
+    if(PageKind < 0)
+    {
+        printf("ERROR: -pages must be one of default, 4k, thp, 2m or 1g.\n");
+        ArgsOk = 0;
+    }
+    
+#if !MEOW_STATS
+    if(PrintStats)
+    {
+        printf("ERROR: -stats needs the hash statistics compiled in (./build.sh -DMEOW_STATS=1).\n");
+        ArgsOk = 0;
+    }
+#endif
+    
+    if(ArgsOk && ExternalBenchDirectory && (PositionalCount == 0))
+    {
+        Result = RunExternalBench(ExternalBenchDirectory, ExternalBenchRecords, ExternalMemoryMB*1024*1024);
+    }
+    else if(ArgsOk && !ExternalBenchDirectory && (PositionalCount == 2))
     {
         // NOTE(casey): Strip trailing slashes from the input
-        char *RootPath = Args[1];
-        size_t RootPathLen = strlen(Args[1]);
+        char *RootPath = Positional[0];
+        size_t RootPathLen = strlen(RootPath);
         while(RootPathLen)
         {
             --RootPathLen;
@@ -330,9 +2843,14 @@ int main(int ArgCount, char **Args)
             }
         }
         
-        char *ReportFileName = Args[2];
+        char *ReportFileName = Positional[1];
         FILE *ReportFileTest = fopen(ReportFileName, "rb");
-        if(!ReportFileTest)
+        if(ReportFileTest)
+        {
+            fclose(ReportFileTest);
+        }
+        
+        if(Resume ? (ReportFileTest != 0) : (ReportFileTest == 0))
         {
             // NOTE(casey): Prepare the test group
             test Tests[ArrayCount(NamedHashTypes)] = {};
@@ -348,43 +2866,126 @@ int main(int ArgCount, char **Args)
             Group.Tests = Tests;
             Group.ReportFileName = ReportFileName;
             Group.RootPath = RootPath;
+            Group.ExternalDirectory = ExternalDirectory;
+            Group.ExternalMemory = ExternalMemoryMB*1024*1024;
+            Group.PageKind = (page_kind)PageKind;
+            Group.NUMANodeCount = GetNUMANodeCount();
             
-            // NOTE(casey): Print the banner
-            time_t Time;
-            time(&Time);
-            tm *TimeInfo = localtime(&Time);
-            
-            printf("meow_search %s began at %s", MEOW_HASH_VERSION_NAME, asctime(TimeInfo));
-            printf("Root: %s\n", RootPath);
-            printf("Hash types:\n");
-            for(int TestIndex = 0;
-                TestIndex < Group.TestCount;
-                ++TestIndex)
+            if(DedupMode)
             {
-                test *Test = Group.Tests + TestIndex;
-                printf("    %s = %s\n", Test->Type.ShortName, Test->Type.FullName);
+                printf("meow_search %s dedup of %s\n", MEOW_HASH_VERSION_NAME, RootPath);
+                
+                Group.DedupMode = 1;
+                IngestDirectoriesRecursively(&Group, RootPath);
+                RunDedup(&Group);
+#if MEOW_STATS
+                if(PrintStats)
+                {
+                    PrintMeowStats(stdout);
+                }
+#endif
+                
+                Result = 0;
             }
-            
-            // NOTE(casey): Run the search
-            IngestDirectoriesRecursively(&Group, RootPath);
-            printf("\n");
-            printf("meow_search complete.\n");
-            
-            // NOTE(casey): Report the results
-            WriteReport(&Group, true);
-            
-            // NOTE(casey): Prepare a result code based on the collision count
-            Result = (int)Group.Tests[MEOW_HASH_TEST_INDEX_128].CollisionCount;
+            else if((!Resume || ReadJournalForResume(&Group, &IndexFileName)) &&
+               (!IndexFileName || OpenScanIndex(&Group.Index, IndexFileName, Group.TestCount, Group.Tests)) &&
+               (!ExternalDirectory || BeginExternal(&Group)) &&
+               BeginJournal(&Group, IndexFileName))
+            {
+                // NOTE(casey): Print the banner
+                time_t Time;
+                time(&Time);
+                tm *TimeInfo = localtime(&Time);
+                
+                printf("meow_search %s began at %s", MEOW_HASH_VERSION_NAME, asctime(TimeInfo));
+                printf("Root: %s\n", RootPath);
+                printf("Hash types:\n");
+                for(int TestIndex = 0;
+                    TestIndex < Group.TestCount;
+                    ++TestIndex)
+                {
+                    test *Test = Group.Tests + TestIndex;
+                    printf("    %s = %s\n", Test->Type.ShortName, Test->Type.FullName);
+                }
+                if(IndexFileName)
+                {
+                    printf("Index: %s (%0.0f records)\n", IndexFileName, (double)Group.Index.RecordCount);
+                }
+                if(Resume)
+                {
+                    printf("Resuming after %0.0f files\n", (double)Group.ResumeFileCount);
+                }
+                if(ExternalDirectory)
+                {
+                    printf("External: %s (%0.0fmb memory)\n", ExternalDirectory, (double)ExternalMemoryMB);
+                }
+                if(Group.NUMANodeCount > 1)
+                {
+                    printf("NUMA: %d nodes, files of 2mb and up are read into memory on the current node\n",
+                           Group.NUMANodeCount);
+                }
+                
+                // NOTE(casey): Run the search
+                IngestDirectoriesRecursively(&Group, RootPath);
+                printf("\n");
+                if(ExternalDirectory)
+                {
+                    RunExternal(&Group);
+                }
+                printf("meow_search complete.\n");
+                if(IndexFileName)
+                {
+                    printf("Index: %0.0f files reused, %0.0f rehashed.\n",
+                           (double)Group.Index.ReusedCount, (double)Group.Index.AppendedCount);
+                }
+                
+                // NOTE(casey): Report the results
+                WriteSummary(&Group);
+#if MEOW_STATS
+                if(PrintStats)
+                {
+                    PrintMeowStats(stdout);
+                }
+#endif
+                
+                if(IndexFileName)
+                {
+                    CloseScanIndex(&Group.Index, true);
+                }
+                
+                // NOTE(casey): Prepare a result code based on the collision count
+                Result = (int)Group.Tests[MEOW_HASH_TEST_INDEX_128].CollisionCount;
+            }
+        }
+        else if(Resume)
+        {
+            printf("ERROR: %s does not exist, so there is nothing to resume.\n", ReportFileName);
         }
         else
         {
-            printf("ERROR: %s already exists.  Please specify a different report filename.\n", ReportFileName);
-            fclose(ReportFileTest);
+            printf("ERROR: %s already exists.  Please specify a different report filename (or -resume).\n", ReportFileName);
         }
     }
     else
     {
-        printf("Usage: %s <directory to search recursively> <report filename to write>\n", Args[0]);
+        printf("Usage: %s [-index <index file>] [-resume] [-dedup] [-external <temp directory>] [-memory <mb>]\n"
+               "       [-pages default|4k|thp|2m|1g] [-stats] <directory to search recursively> <report filename to write>\n", Args[0]);
+        printf("       %s -external-bench <temp directory> [-records <count>] [-memory <mb>]\n", Args[0]);
+        printf("    -index: reuse digests for files whose device, inode, size and mtime are unchanged\n");
+        printf("            since the last scan that used the same index file, and record new ones\n");
+        printf("    -resume: continue an interrupted search from the last checkpoint in its report\n");
+        printf("             (files before the checkpoint are replayed, from the index if there is one)\n");
+        printf("    -dedup: find duplicate files instead of collisions, only reading files whose size\n");
+        printf("            and then head/tail sample match some other file\n");
+        printf("    -external: keep no per-file state in memory, spilling sorted (hash, file id) runs\n");
+        printf("               to the temp directory and merging them after the walk\n");
+        printf("    -memory: memory budget for -external and -external-bench (default %u mb)\n", EXTERNAL_DEFAULT_MEMORY_MB);
+        printf("    -pages: read files of 2mb and up into memory mapped with this kind of page\n");
+        printf("            (thp for transparent huge pages, 2m or 1g for the reserved huge page pool)\n");
+        printf("    -stats: print how many hashes of each size were done, and how many bytes went\n");
+        printf("            through each of the hash's paths (needs a build with -DMEOW_STATS=1)\n");
+        printf("    -external-bench: time the external spill and merge on synthetic records\n");
+        printf("                     (default 1000000000 records)\n");
     }
     
     return(Result);
@@ -394,41 +2995,30 @@ int main(int ArgCount, char **Args)
 // NOTE(casey) Platform-specific directory walking
 //
 
-static char *
-AllocPath(char *A, char *B)
-{
-    size_t ACount = strlen(A);
-    size_t BCount = strlen(B);
-    size_t Size = ACount + BCount + 2;
-    
-    char *Result = (char *)malloc(Size);
-    memcpy(Result, A, ACount);
-    memcpy(Result + ACount + 1, B, BCount);
-    Result[ACount] = '/';
-    Result[Size - 1] = 0;
-    
-    return(Result);
-}
+#if _WIN32
 
 static void
-DeallocPath(char *A)
+IngestDirectory(test_group *Group, path_node *Directory)
 {
-    if(A)
+    char *Path = AllocPath(Directory);
+    size_t PathLength = Path ? strlen(Path) : 0;
+    char *Wildcard = Path ? (char *)malloc(PathLength + 3) : 0;
+    if(Wildcard)
     {
-        free(A);
+        memcpy(Wildcard, Path, PathLength);
+        memcpy(Wildcard + PathLength, "/*", 3);
     }
-}
-
-#if _WIN32
-
-static void
-IngestDirectoriesRecursively(test_group *Group, char *Path)
-{
-    char *Wildcard = AllocPath(Path, (char *)"*");
+    else
+    {
+        ++Group->AllocationFailureCount;
+    }
+    DeallocPath(Path);
     
     WIN32_FIND_DATAA FindData;
-    HANDLE SearchHandle = FindFirstFileExA(Wildcard, FindExInfoBasic, &FindData,
-                                           FindExSearchNameMatch, 0, FIND_FIRST_EX_LARGE_FETCH);
+    HANDLE SearchHandle = (Wildcard ?
+                           FindFirstFileExA(Wildcard, FindExInfoBasic, &FindData,
+                                            FindExSearchNameMatch, 0, FIND_FIRST_EX_LARGE_FETCH) :
+                           INVALID_HANDLE_VALUE);
     if(SearchHandle != INVALID_HANDLE_VALUE)
     {
         do
@@ -436,14 +3026,23 @@ IngestDirectoriesRecursively(test_group *Group, char *Path)
             char *Stem = FindData.cFileName;
             if(strcmp(Stem, ".") && strcmp(Stem, ".."))
             {
-                char *EntryName = AllocPath(Path, Stem);
                 if(FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
                 {
-                    IngestDirectoriesRecursively(Group, EntryName);
+                    path_node *Child = PushPathNode(&Group->Paths, Directory, Stem);
+                    if(Child)
+                    {
+                        IngestDirectory(Group, Child);
+                    }
                 }
                 else
                 {
-                    IngestFile(Group, EntryName);
+                    // NOTE: External mode never holds on to file nodes, so they are not stored
+                    path_node Transient = {Directory, Stem};
+                    path_node *File = Group->ExternalDirectory ? &Transient : PushPathNode(&Group->Paths, Directory, Stem);
+                    if(File)
+                    {
+                        VisitFile(Group, File);
+                    }
                 }
             }
         } while(FindNextFileA(SearchHandle, &FindData));
@@ -451,44 +3050,154 @@ IngestDirectoriesRecursively(test_group *Group, char *Path)
         FindClose(SearchHandle);
     }
     
-    DeallocPath(Wildcard);
+    free(Wildcard);
+}
+
+static void
+IngestDirectoriesRecursively(test_group *Group, char *Path)
+{
+    path_node *Root = PushPathNode(&Group->Paths, 0, Path);
+    if(Root)
+    {
+        IngestDirectory(Group, Root);
+    }
 }
 
 #else
 
+static void IngestDirectory(test_group *Group, path_node *Directory, int DirectoryHandle);
+
 static void
-IngestDirectoriesRecursively(test_group *Group, char *Path)
+IngestDirectoryEntry(test_group *Group, path_node *Directory, int DirectoryHandle, char *Stem, int Type)
+{
+    if(strcmp(Stem, ".") && strcmp(Stem, ".."))
+    {
+        if(Type == DT_UNKNOWN)
+        {
+            // NOTE: Not every file system fills in the type, so ask directly
+            struct stat Stat;
+            if(fstatat(DirectoryHandle, Stem, &Stat, AT_SYMLINK_NOFOLLOW) == 0)
+            {
+                Type = (S_ISDIR(Stat.st_mode) ? DT_DIR :
+                        S_ISREG(Stat.st_mode) ? DT_REG :
+                        DT_LNK);
+            }
+            else
+            {
+                ++Group->AccessFailureCount;
+            }
+        }
+        
+        if(Type == DT_DIR)
+        {
+            path_node *Child = PushPathNode(&Group->Paths, Directory, Stem);
+            int ChildHandle = Child ? openat(DirectoryHandle, Stem, O_RDONLY | O_DIRECTORY | O_NOFOLLOW) : -1;
+            if(ChildHandle >= 0)
+            {
+                IngestDirectory(Group, Child, ChildHandle);
+                close(ChildHandle);
+                
+                // NOTE: The child's handle is gone now, so go back to this directory's
+                // rather than leave files in the child to be opened against a dead one
+                Group->Paths.CurrentDir = Directory;
+                Group->Paths.CurrentDirHandle = DirectoryHandle;
+            }
+        }
+        else if(Type == DT_REG)
+        {
+            // NOTE: Recursing changes the current directory, so it is set for every file
+            Group->Paths.CurrentDir = Directory;
+            Group->Paths.CurrentDirHandle = DirectoryHandle;
+            
+            // NOTE: External mode never holds on to file nodes, so they are not stored
+            path_node Transient = {Directory, Stem};
+            path_node *File = Group->ExternalDirectory ? &Transient : PushPathNode(&Group->Paths, Directory, Stem);
+            if(File)
+            {
+                VisitFile(Group, File);
+            }
+        }
+    }
+}
+
+#if __linux__
+
+struct linux_dirent64
+{
+    meow_u64 d_ino;
+    meow_u64 d_off;
+    short unsigned d_reclen;
+    meow_u8 d_type;
+    char d_name[1];
+};
+
+static void
+IngestDirectory(test_group *Group, path_node *Directory, int DirectoryHandle)
+{
+    // NOTE: getdents64 hands back a whole batch of entries per system call, and
+    // we never need the DIR machinery around it since we already have the handle.
+    int unsigned BatchSize = 64*1024;
+    meow_u8 *Batch = (meow_u8 *)malloc(BatchSize);
+    for(;;)
+    {
+        long BytesRead = syscall(SYS_getdents64, DirectoryHandle, Batch, BatchSize);
+        if(BytesRead <= 0)
+        {
+            break;
+        }
+        
+        long At = 0;
+        while(At < BytesRead)
+        {
+            linux_dirent64 *Entry = (linux_dirent64 *)(Batch + At);
+            IngestDirectoryEntry(Group, Directory, DirectoryHandle, Entry->d_name, Entry->d_type);
+            At += Entry->d_reclen;
+        }
+    }
+    free(Batch);
+}
+
+#else
+
+static void
+IngestDirectory(test_group *Group, path_node *Directory, int DirectoryHandle)
 {
-    DIR *DirHandle = opendir(Path);
+    // NOTE: fdopendir takes ownership of the handle it is given, so give it a copy
+    int ReadHandle = dup(DirectoryHandle);
+    DIR *DirHandle = (ReadHandle >= 0) ? fdopendir(ReadHandle) : 0;
     if(DirHandle)
     {
         for(dirent *Entry = readdir(DirHandle);
             Entry;
             Entry = readdir(DirHandle))
         {
-            // NOTE(casey): We intentionally never free these, because they are
-            // used in the permanent structure.
-            char *Stem = Entry->d_name;
-            char *EntryName = AllocPath(Path, Stem);
-            if(strcmp(Stem, ".") && strcmp(Stem, ".."))
-            {
-                if(Entry->d_type == DT_UNKNOWN)
-                {
-                    ++Group->AccessFailureCount;
-                }
-                else if(Entry->d_type == DT_DIR)
-                {
-                    IngestDirectoriesRecursively(Group, EntryName);
-                }
-                else if(Entry->d_type == DT_REG)
-                {
-                    IngestFile(Group, EntryName);
-                }
-            }
+            IngestDirectoryEntry(Group, Directory, DirectoryHandle, Entry->d_name, Entry->d_type);
         }
         
         closedir(DirHandle);
     }
+    else if(ReadHandle >= 0)
+    {
+        close(ReadHandle);
+    }
+}
+
+#endif
+
+static void
+IngestDirectoriesRecursively(test_group *Group, char *Path)
+{
+    path_node *Root = PushPathNode(&Group->Paths, 0, Path);
+    int Handle = Root ? open(Path, O_RDONLY | O_DIRECTORY) : -1;
+    if(Handle >= 0)
+    {
+        IngestDirectory(Group, Root, Handle);
+        close(Handle);
+        
+        // NOTE: Every handle from the walk is closed, so anything opened after it
+        // (dedup, collision checks at the end) goes by full path
+        Group->Paths.CurrentDir = 0;
+    }
 }
 
 #endif
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <memory.h>
 
 #undef MEOW_INCLUDE_C
@@ -106,11 +107,291 @@ DiffStates(char const *NameA, meow_u32 CanonicalDumpCount, meow_dump *CanonicalD
     }
 }
 
+//
+// NOTE: The bit-flip matrix (every hash type x 4 seeds x 2048 buffer sizes x every
+// bit of the buffer) is split into one task per type, seed and buffer size, and
+// worker threads take tasks off a shared counter, biggest buffers first so that the
+// last tasks to finish are short ones.  Each task draws its streaming split points
+// from its own random series, seeded by the task's number, so every case runs the
+// same splits no matter how many threads there are or which machine runs it.
+// -shard i/n runs every nth task starting at the ith, so n machines can split
+// the matrix between them.
+//
+
+#define FLIP_TEST_SEED_COUNT 4
+#define FLIP_TEST_MAX_BUFFER_SIZE 2048
+
+struct flip_test_result
+{
+    volatile meow_u32 TotalPossible;
+    volatile meow_u32 ImpError;
+    volatile meow_u32 StreamError;
+    volatile meow_u32 Unsupported;
+    volatile meow_u32 TaskCount;
+};
+
+struct flip_test_work
+{
+    meow_u8 Seeds[FLIP_TEST_SEED_COUNT][128];
+    meow_u32 TaskCount;
+    meow_u32 ShardIndex;
+    meow_u32 ShardCount;
+    
+    volatile meow_u32 NextClaim;
+    volatile meow_u32 TasksDone;
+    
+    // NOTE: A ticket lock, so that failure reports from different threads don't interleave
+    volatile meow_u32 NextTicket;
+    volatile meow_u32 NowServing;
+    
+    flip_test_result Results[ArrayCount(NamedHashTypes)][FLIP_TEST_SEED_COUNT];
+};
+
+static meow_u32
+LockOutput(flip_test_work *Work)
+{
+    meow_u32 Ticket = AtomicIncrement(&Work->NextTicket) - 1;
+    while(AtomicLoad(&Work->NowServing) != Ticket)
+    {
+    }
+    return(Ticket);
+}
+
+static void
+UnlockOutput(flip_test_work *Work, meow_u32 Ticket)
+{
+    fflush(stdout);
+    AtomicStore(&Work->NowServing, Ticket + 1);
+}
+
+static meow_u32
+NextRandom(meow_u64 *Series)
+{
+    // NOTE: splitmix64
+    meow_u64 Z = (*Series += 0x9e3779b97f4a7c15ull);
+    Z = (Z ^ (Z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    Z = (Z ^ (Z >> 27)) * 0x94d049bb133111ebull;
+    Z = (Z ^ (Z >> 31));
+    return((meow_u32)(Z >> 32));
+}
+
+static void
+RunFlipTask(flip_test_work *Work, meow_u32 Task)
+{
+    meow_u32 PerSize = ArrayCount(NamedHashTypes)*FLIP_TEST_SEED_COUNT;
+    int BufferSize = FLIP_TEST_MAX_BUFFER_SIZE - (int)(Task / PerSize);
+    int TypeIndex = (int)((Task % PerSize) / FLIP_TEST_SEED_COUNT);
+    int SeedIndex = (int)(Task % FLIP_TEST_SEED_COUNT);
+    
+    named_hash_type *Type = NamedHashTypes + TypeIndex;
+    flip_test_result *TaskResult = &Work->Results[TypeIndex][SeedIndex];
+    meow_u8 *Seed128 = Work->Seeds[SeedIndex];
+    meow_u64 Series = Task;
+    
+    meow_u32 CanonicalDumpCount = 0;
+    meow_dump CanonicalDump[32] = {};
+    meow_u32 TestDumpCount = 0;
+    meow_dump TestDump[32] = {};
+    meow_u8 StateBuffer[1024];
+    
+    meow_u32 TotalPossible = 0;
+    meow_u32 ImpError = 0;
+    meow_u32 StreamError = 0;
+    meow_u32 Unsupported = 0;
+    
+    int AllocationSize = BufferSize + 2*CACHE_LINE_ALIGNMENT;
+    meow_u8 *Allocation = (meow_u8 *)aligned_alloc(CACHE_LINE_ALIGNMENT, AllocationSize);
+    memset(Allocation, 0, AllocationSize);
+    
+    meow_u8 *Buffer = Allocation + CACHE_LINE_ALIGNMENT;
+    for(int Guard = 0;
+        Guard < 1;
+        ++Guard)
+    {
+        for(int Flip = 0;
+            Flip < (8*BufferSize);
+            ++Flip)
+        {
+            meow_u8 *FlipByte = Buffer + (Flip / 8);
+            meow_u8 FlipBit = (1 << (Flip % 8));
+            *FlipByte |= FlipBit;
+            
+            meow_u128 Canonical = {};
+            if(Type->Reference)
+            {
+                MeowDumpTo = CanonicalDump;
+                Canonical = Type->Reference(Seed128, BufferSize, Buffer);
+                CanonicalDumpCount = MeowDumpTo - CanonicalDump;
+                MeowDumpTo = 0;
+            }
+            
+            if(Guard)
+            {
+                memset(Allocation, 0xFF, CACHE_LINE_ALIGNMENT);
+                memset(Allocation + CACHE_LINE_ALIGNMENT + BufferSize, 0xFF, CACHE_LINE_ALIGNMENT);
+            }
+            
+            ++TotalPossible;
+            TRY
+            {
+                MeowDumpTo = TestDump;
+                meow_u128 ImpHash = Type->Imp(Seed128, BufferSize, Buffer);
+                TestDumpCount = MeowDumpTo - TestDump;
+                MeowDumpTo = 0;
+                
+                if(Type->Reference && !MeowHashesAreEqual(Canonical, ImpHash))
+                {
+                    meow_u32 Ticket = LockOutput(Work);
+                    DiffStates("Canonical", CanonicalDumpCount, CanonicalDump,
+                               "Test", TestDumpCount, TestDump);
+                    UnlockOutput(Work, Ticket);
+                    ++ImpError;
+                }
+                
+                if(Type->Absorb)
+                {
+                    for(int SplitTest = 0;
+                        SplitTest < 10;
+                        ++SplitTest)
+                    {
+                        MeowDumpTo = TestDump;
+                        Type->Begin(StateBuffer, Seed128);
+                        
+                        meow_u8 *At = Buffer;
+                        int unsigned Count = BufferSize;
+                        while(Count)
+                        {
+                            int unsigned Amount = NextRandom(&Series) % (BufferSize + 1);
+                            if(Amount > Count)
+                            {
+                                Amount = Count;
+                            }
+                            
+                            Type->Absorb(StateBuffer, Amount, At);
+                            At += Amount;
+                            Count -= Amount;
+                        }
+                        
+                        meow_u128 AbsorbHash = Type->End(StateBuffer, 0);
+                        TestDumpCount = MeowDumpTo - TestDump;
+                        MeowDumpTo = 0;
+                        
+                        if(Type->Reference && !MeowHashesAreEqual(Canonical, AbsorbHash))
+                        {
+                            meow_u32 Ticket = LockOutput(Work);
+                            DiffStates("Canonical", CanonicalDumpCount, CanonicalDump,
+                                       "Test", TestDumpCount, TestDump);
+                            UnlockOutput(Work, Ticket);
+                            ++StreamError;
+                            break;
+                        }
+                    }
+                }
+            }
+            CATCH
+            {
+                ++Unsupported;
+                break;
+            }
+            
+            if(Guard)
+            {
+                memset(Allocation, 0, CACHE_LINE_ALIGNMENT);
+                memset(Allocation + CACHE_LINE_ALIGNMENT + BufferSize, 0, CACHE_LINE_ALIGNMENT);
+            }
+            
+            *FlipByte &= ~FlipBit;
+            
+            if(Type->Reference)
+            {
+                MeowDumpTo = TestDump;
+                meow_u128 OppositeHash = Type->Reference(Seed128, BufferSize, Buffer);
+                TestDumpCount = MeowDumpTo - TestDump;
+                MeowDumpTo = 0;
+                
+                for(int LaneCheck = 0;
+                    LaneCheck < 4;
+                    ++LaneCheck)
+                {
+                    if(((meow_u32 *)&OppositeHash)[LaneCheck] == ((meow_u32 *)&Canonical)[LaneCheck])
+                    {
+                        meow_u32 Ticket = LockOutput(Work);
+                        printf("\nCOLLISION: %s/seed%u: buffer size %d with bit %d flipped collides on lane %d\n",
+                               Type->FullName, SeedIndex, BufferSize, Flip, LaneCheck);
+                        DiffStates("Bit=1", CanonicalDumpCount, CanonicalDump,
+                                   "Bit=0", TestDumpCount, TestDump);
+                        UnlockOutput(Work, Ticket);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    free(Allocation);
+    
+    AtomicAdd(&TaskResult->TotalPossible, TotalPossible);
+    AtomicAdd(&TaskResult->ImpError, ImpError);
+    AtomicAdd(&TaskResult->StreamError, StreamError);
+    AtomicAdd(&TaskResult->Unsupported, Unsupported);
+    AtomicIncrement(&TaskResult->TaskCount);
+}
+
+static void
+FlipTestThread(void *Param)
+{
+    flip_test_work *Work = (flip_test_work *)Param;
+    for(;;)
+    {
+        meow_u32 Claim = AtomicIncrement(&Work->NextClaim) - 1;
+        meow_u64 Task = (meow_u64)Claim*Work->ShardCount + Work->ShardIndex;
+        if(Task >= Work->TaskCount)
+        {
+            break;
+        }
+        
+        RunFlipTask(Work, (meow_u32)Task);
+        AtomicIncrement(&Work->TasksDone);
+    }
+}
+
 int
 main(int ArgCount, char **Args)
 {
     int Result = 0;
     
+    int ThreadCount = GetProcessorCount();
+    int ShardIndex = 0;
+    int ShardCount = 1;
+    int ArgsOk = 1;
+    for(int ArgIndex = 1;
+        ArgIndex < ArgCount;
+        ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if((strcmp(Arg, "-threads") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ThreadCount = atoi(Args[++ArgIndex]);
+        }
+        else if((strcmp(Arg, "-shard") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            ArgsOk = (sscanf(Args[++ArgIndex], "%d/%d", &ShardIndex, &ShardCount) == 2);
+        }
+        else
+        {
+            ArgsOk = 0;
+        }
+    }
+    
+    if(!ArgsOk || (ThreadCount < 1) || (ShardCount < 1) || (ShardIndex < 0) || (ShardIndex >= ShardCount))
+    {
+        fprintf(stderr, "Usage: %s [-threads <count>] [-shard <index>/<count>]\n", Args[0]);
+        fprintf(stderr, "    -threads: threads to run the bit-flip tests on (default: one per processor)\n");
+        fprintf(stderr, "    -shard: only run this machine's share of the bit-flip tests, e.g. 0/4 through 3/4\n");
+        fprintf(stderr, "            on four machines (the page size tests only run with shard 0)\n");
+        return(-1);
+    }
+    
     // NOTE(casey): Print the banner
     printf("meow_test %s - basic sanity test for a Meow hash build\n", MEOW_HASH_VERSION_NAME);
     printf("    See https://mollyrocket.com/meowhash for details\n");
@@ -137,183 +418,94 @@ main(int ArgCount, char **Args)
     meow_u32 TestDumpCount = 0;
     meow_dump TestDump[32] = {};
 
-    meow_u8 Seeds[4][128] = {};
-    memcpy(Seeds[2], MeowDefaultSeed, 128);
+    flip_test_work *Work = (flip_test_work *)calloc(1, sizeof(flip_test_work));
+    memcpy(Work->Seeds[2], MeowDefaultSeed, 128);
     meow_u64 BadSeed0 = 0;
     meow_u64 BadSeed1 = 0x01234567;
-    MeowExpandSeed(sizeof(BadSeed0), &BadSeed0, Seeds[2]);
-    MeowExpandSeed(sizeof(BadSeed1), &BadSeed1, Seeds[3]);
-
-    meow_u8 StateBuffer[1024];
+    MeowExpandSeed(sizeof(BadSeed0), &BadSeed0, Work->Seeds[2]);
+    MeowExpandSeed(sizeof(BadSeed1), &BadSeed1, Work->Seeds[3]);
+    Work->TaskCount = ArrayCount(NamedHashTypes)*FLIP_TEST_SEED_COUNT*FLIP_TEST_MAX_BUFFER_SIZE;
+    Work->ShardIndex = ShardIndex;
+    Work->ShardCount = ShardCount;
+    
+    meow_u32 ShardTaskCount = (Work->TaskCount - ShardIndex + ShardCount - 1) / ShardCount;
+    printf("Bit-flip tests: %u cases on %d thread%s", ShardTaskCount, ThreadCount, (ThreadCount == 1) ? "" : "s");
+    if(ShardCount > 1)
+    {
+        printf(" (shard %d of %d, %u cases in all)", ShardIndex, ShardCount, Work->TaskCount);
+    }
+    printf("\n");
+    fflush(stdout);
+    
+    double StartTime = GetWallClock();
+    meow_thread *Threads = (meow_thread *)malloc(ThreadCount*sizeof(meow_thread));
+    int StartedCount = 0;
+    for(int ThreadIndex = 0;
+        ThreadIndex < ThreadCount;
+        ++ThreadIndex)
+    {
+        if(StartThread(Threads + StartedCount, FlipTestThread, Work))
+        {
+            ++StartedCount;
+        }
+    }
+    
+    if(StartedCount)
+    {
+        while(AtomicLoad(&Work->TasksDone) < ShardTaskCount)
+        {
+            fprintf(stderr, "\r(%0.0f%%)   ", 100.0*(double)AtomicLoad(&Work->TasksDone) / (double)ShardTaskCount);
+            SleepSeconds(0.25);
+        }
+        
+        for(int ThreadIndex = 0;
+            ThreadIndex < StartedCount;
+            ++ThreadIndex)
+        {
+            JoinThread(Threads[ThreadIndex]);
+        }
+    }
+    else
+    {
+        // NOTE: No threads to be had, so run everything here
+        FlipTestThread(Work);
+    }
+    free(Threads);
+    fprintf(stderr, "\r");
+    
     for(int TypeIndex = 0;
         TypeIndex < ArrayCount(NamedHashTypes);
         ++TypeIndex)
     {
         named_hash_type *Type = NamedHashTypes + TypeIndex;
-
-        int TotalPossible = 0;
-        int ImpError = 0;
-        int StreamError = 0;
-        int Unsupported = 0;
-        int MaxBufferSize = 2048;
-
         for(int SeedIndex = 0;
-            SeedIndex < ArrayCount(Seeds);
+            SeedIndex < FLIP_TEST_SEED_COUNT;
             ++SeedIndex)
         {
-            meow_u8 *Seed128 = Seeds[SeedIndex];
+            flip_test_result *SeedResult = &Work->Results[TypeIndex][SeedIndex];
+            printf("%s/seed%u: ", Type->FullName, SeedIndex);
             
-            for(int BufferSize = 1;
-                BufferSize <= MaxBufferSize;
-                ++BufferSize)
+            if(SeedResult->TaskCount == 0)
             {
-                int AllocationSize = BufferSize + 2*CACHE_LINE_ALIGNMENT;
-                meow_u8 *Allocation = (meow_u8 *)aligned_alloc(CACHE_LINE_ALIGNMENT, AllocationSize);
-                memset(Allocation, 0, AllocationSize);
-                
-                meow_u8 *Buffer = Allocation + CACHE_LINE_ALIGNMENT;
-                for(int Guard = 0;
-                    Guard < 1;
-                    ++Guard)
-                {
-                    for(int Flip = 0;
-                        Flip < (8*BufferSize);
-                        ++Flip)
-                    {
-                        meow_u8 *FlipByte = Buffer + (Flip / 8);
-                        meow_u8 FlipBit = (1 << (Flip % 8));
-                        *FlipByte |= FlipBit;
-                        
-                        meow_u128 Canonical = {};
-                        if(Type->Reference)
-                        {
-                            MeowDumpTo = CanonicalDump;
-                            Canonical = Type->Reference(Seed128, BufferSize, Buffer);
-                            CanonicalDumpCount = MeowDumpTo - CanonicalDump;
-                            MeowDumpTo = 0;
-                        }
-                        
-                        if(Guard)
-                        {
-                            memset(Allocation, 0xFF, CACHE_LINE_ALIGNMENT);
-                            memset(Allocation + CACHE_LINE_ALIGNMENT + BufferSize, 0xFF, CACHE_LINE_ALIGNMENT);
-                        }
-                        
-                        ++TotalPossible;
-                        TRY
-                        {
-                            MeowDumpTo = TestDump;
-                            meow_u128 ImpHash = Type->Imp(Seed128, BufferSize, Buffer);
-                            TestDumpCount = MeowDumpTo - TestDump;
-                            MeowDumpTo = 0;
-                            
-                            if(Type->Reference && !MeowHashesAreEqual(Canonical, ImpHash))
-                            {
-                                DiffStates("Canonical", CanonicalDumpCount, CanonicalDump,
-                                           "Test", TestDumpCount, TestDump);
-                                ++ImpError;
-                            }
-                            
-                            if(Type->Absorb)
-                            {
-                                for(int SplitTest = 0;
-                                    SplitTest < 10;
-                                    ++SplitTest)
-                                {
-                                    MeowDumpTo = TestDump;
-                                    Type->Begin(StateBuffer, Seed128);
-                                    
-                                    meow_u8 *At = Buffer;
-                                    int unsigned Count = BufferSize;
-                                    while(Count)
-                                    {
-                                        int unsigned Amount = rand() % (BufferSize + 1);
-                                        if(Amount > Count)
-                                        {
-                                            Amount = Count;
-                                        }
-                                        
-                                        Type->Absorb(StateBuffer, Amount, At);
-                                        At += Amount;
-                                        Count -= Amount;
-                                    }
-                                    
-                                    meow_u128 AbsorbHash = Type->End(StateBuffer, 0);
-                                    TestDumpCount = MeowDumpTo - TestDump;
-                                    MeowDumpTo = 0;
-                                    
-                                    if(Type->Reference && !MeowHashesAreEqual(Canonical, AbsorbHash))
-                                    {
-                                        DiffStates("Canonical", CanonicalDumpCount, CanonicalDump,
-                                                   "Test", TestDumpCount, TestDump);
-                                        ++StreamError;
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        CATCH
-                        {
-                            ++Unsupported;
-                            break;
-                        }
-                        
-                        if(Guard)
-                        {
-                            memset(Allocation, 0, CACHE_LINE_ALIGNMENT);
-                            memset(Allocation + CACHE_LINE_ALIGNMENT + BufferSize, 0, CACHE_LINE_ALIGNMENT);
-                        }
-                        
-                        *FlipByte &= ~FlipBit;
-                        
-                        if(Type->Reference)
-                        {
-                            MeowDumpTo = TestDump;
-                            meow_u128 OppositeHash = Type->Reference(Seed128, BufferSize, Buffer);
-                            TestDumpCount = MeowDumpTo - TestDump;
-                            MeowDumpTo = 0;
-                            
-                            for(int LaneCheck = 0;
-                                LaneCheck < 4;
-                                ++LaneCheck)
-                            {
-                                if(((meow_u32 *)&OppositeHash)[LaneCheck] == ((meow_u32 *)&Canonical)[LaneCheck])
-                                {
-                                    printf("\nCOLLISION: buffer size %d with bit %d flipped collides on lane %d\n", BufferSize, Flip, LaneCheck);
-                                    DiffStates("Bit=1", CanonicalDumpCount, CanonicalDump,
-                                               "Bit=0", TestDumpCount, TestDump);
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-                fprintf(stderr, "\r%s/seed%u: (%0.0f%%)   ", Type->FullName, SeedIndex,
-                        (double)BufferSize * 100.0f / (double)MaxBufferSize);
-                
-                
-                free(Allocation);
+                printf("not in this shard");
             }
-            
-            fprintf(stderr, "\r%s/seed%u: ", Type->FullName, SeedIndex);
-            
-            if(Unsupported)
+            else if(SeedResult->Unsupported)
             {
                 printf("UNSUPPORTED");
             }
             else
             {
-                if(ImpError || StreamError)
+                if(SeedResult->ImpError || SeedResult->StreamError)
                 {
                     printf("FAILED");
-                    if(ImpError)
+                    if(SeedResult->ImpError)
                     {
-                        printf(" [direct:%u/%u]", ImpError, TotalPossible);
+                        printf(" [direct:%u/%u]", SeedResult->ImpError, SeedResult->TotalPossible);
                     }
                     
-                    if(StreamError)
+                    if(SeedResult->StreamError)
                     {
-                        printf(" [stream:%u/%u]", StreamError, TotalPossible);
+                        printf(" [stream:%u/%u]", SeedResult->StreamError, SeedResult->TotalPossible);
                     }
                     
                     Result = -1;
@@ -323,9 +515,21 @@ main(int ArgCount, char **Args)
                     printf("PASSED");
                 }
             }
+            
+            if((ShardCount > 1) && SeedResult->TaskCount)
+            {
+                printf(" (%u buffer sizes)", SeedResult->TaskCount);
+            }
             printf("\n");
         }
     }
+    printf("(%0.1f seconds)\n", GetWallClock() - StartTime);
+    free(Work);
+    
+    if(ShardIndex != 0)
+    {
+        return(Result);
+    }
     
     printf("\n\nTesting reading right up to page size.\n");
     for(int TypeIndex = 0;
@@ -347,6 +347,50 @@ PrintSize(FILE *Stream, double Size, int Fixed, int AllowDecimals = 1)
     }
 }
 
+#if MEOW_STATS
+static void
+PrintMeowStats(FILE *Stream)
+{
+    meow_stats Stats;
+    int ThreadCount = MeowStatsSnapshot(&Stats);
+
+    fprintf(Stream, "Meow hash statistics (%d thread%s):\n", ThreadCount, (ThreadCount == 1) ? "" : "s");
+    for(int Bucket = 0;
+        Bucket < MEOW_STATS_BUCKET_COUNT;
+        ++Bucket)
+    {
+        if(Stats.Calls[Bucket])
+        {
+            // NOTE: Bucket N holds lengths in [2^(N-1), 2^N), and bucket 0 the empty input
+            fprintf(Stream, "    ");
+            PrintSize(Stream, Bucket ? (double)(1ull << (Bucket - 1)) : 0.0, true, 0);
+            fprintf(Stream, " and up: %12.0f hashes, ", (double)Stats.Calls[Bucket]);
+            PrintSize(Stream, (double)Stats.Bytes[Bucket], true);
+            fprintf(Stream, "\n");
+        }
+    }
+
+    char const *PathNames[MeowPath_Count] =
+    {
+        "one-shot",
+        "one-shot, prefetching",
+        "streaming",
+        "streaming, prefetching",
+    };
+    for(int Path = 0;
+        Path < MeowPath_Count;
+        ++Path)
+    {
+        if(Stats.PathCalls[Path])
+        {
+            fprintf(Stream, "    %-22s %12.0f calls, ", PathNames[Path], (double)Stats.PathCalls[Path]);
+            PrintSize(Stream, (double)Stats.PathBytes[Path], true);
+            fprintf(Stream, "\n");
+        }
+    }
+}
+#endif
+
 static void
 PrintHash(FILE *Stream, meow_u128 Hash)
 {
@@ -364,3 +408,575 @@ InitializeHashesThatNeedInitializers(void)
     CLHashJunk = get_random_key_for_clhash(1234, 5678);
 #endif
 }
+
+//
+// NOTE: Thread shim, for the utilities that run hashes on more than one thread
+// at a time.  It only covers what they need: start/join, pinning a thread to
+// a processor, a wall clock, and a few atomics for starting and stopping runs.
+//
+
+#if _WIN32
+#include <windows.h>
+typedef HANDLE meow_thread;
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+typedef pthread_t meow_thread;
+#endif
+
+typedef void meow_thread_proc(void *Param);
+
+struct meow_thread_start
+{
+    meow_thread_proc *Proc;
+    void *Param;
+};
+
+#if _WIN32
+static DWORD WINAPI
+MeowThreadEntry(void *StartInit)
+#else
+static void *
+MeowThreadEntry(void *StartInit)
+#endif
+{
+    meow_thread_start Start = *(meow_thread_start *)StartInit;
+    free(StartInit);
+    Start.Proc(Start.Param);
+    return(0);
+}
+
+static int
+StartThread(meow_thread *Thread, meow_thread_proc *Proc, void *Param)
+{
+    meow_thread_start *Start = (meow_thread_start *)malloc(sizeof(meow_thread_start));
+    Start->Proc = Proc;
+    Start->Param = Param;
+    
+#if _WIN32
+    *Thread = CreateThread(0, 0, MeowThreadEntry, Start, 0, 0);
+    int Result = (*Thread != 0);
+#else
+    int Result = (pthread_create(Thread, 0, MeowThreadEntry, Start) == 0);
+#endif
+    if(!Result)
+    {
+        free(Start);
+    }
+    
+    return(Result);
+}
+
+static void
+JoinThread(meow_thread Thread)
+{
+#if _WIN32
+    WaitForSingleObject(Thread, INFINITE);
+    CloseHandle(Thread);
+#else
+    pthread_join(Thread, 0);
+#endif
+}
+
+static int
+GetProcessorCount(void)
+{
+#if _WIN32
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    int Result = (int)Info.dwNumberOfProcessors;
+#elif __linux__
+    cpu_set_t Set;
+    int Result = (sched_getaffinity(0, sizeof(Set), &Set) == 0) ? CPU_COUNT(&Set) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    int Result = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if(Result < 1)
+    {
+        Result = 1;
+    }
+    return(Result);
+}
+
+// NOTE: Pins the calling thread to the Index'th processor it is allowed to run on
+// (wrapping around), and returns the processor number, or -1 if it couldn't.
+static int
+PinCurrentThread(int Index)
+{
+    int Result = -1;
+    
+#if _WIN32
+    int Processor = Index % GetProcessorCount();
+    if(SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << Processor))
+    {
+        Result = Processor;
+    }
+#elif __linux__
+    cpu_set_t Allowed;
+    if(sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0)
+    {
+        int Skip = Index % CPU_COUNT(&Allowed);
+        for(int Processor = 0;
+            Processor < CPU_SETSIZE;
+            ++Processor)
+        {
+            if(CPU_ISSET(Processor, &Allowed) && (Skip-- == 0))
+            {
+                cpu_set_t Set;
+                CPU_ZERO(&Set);
+                CPU_SET(Processor, &Set);
+                if(sched_setaffinity(0, sizeof(Set), &Set) == 0)
+                {
+                    Result = Processor;
+                }
+                break;
+            }
+        }
+    }
+#endif
+    
+    return(Result);
+}
+
+// NOTE: Pins the calling thread to the given processor number, returning whether it could
+static int
+PinToProcessor(int Processor)
+{
+    int Result = 0;
+    
+#if _WIN32
+    Result = ((Processor >= 0) && (Processor < 64) &&
+              SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << Processor));
+#elif __linux__
+    if((Processor >= 0) && (Processor < CPU_SETSIZE))
+    {
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        CPU_SET(Processor, &Set);
+        Result = (sched_setaffinity(0, sizeof(Set), &Set) == 0);
+    }
+#endif
+    
+    return(Result);
+}
+
+static int
+GetCurrentProcessor(void)
+{
+#if _WIN32
+    int Result = (int)GetCurrentProcessorNumber();
+#elif __linux__
+    int Result = sched_getcpu();
+#else
+    int Result = -1;
+#endif
+    return(Result);
+}
+
+static double
+GetWallClock(void)
+{
+#if _WIN32
+    LARGE_INTEGER Counter, Frequency;
+    QueryPerformanceCounter(&Counter);
+    QueryPerformanceFrequency(&Frequency);
+    double Result = (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+    timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    double Result = (double)Time.tv_sec + 1.0e-9*(double)Time.tv_nsec;
+#endif
+    return(Result);
+}
+
+static void
+SleepSeconds(double Seconds)
+{
+#if _WIN32
+    Sleep((DWORD)(1000.0*Seconds));
+#else
+    usleep((useconds_t)(1000000.0*Seconds));
+#endif
+}
+
+static meow_u32
+AtomicIncrement(volatile meow_u32 *Value)
+{
+#if _MSC_VER
+    meow_u32 Result = (meow_u32)InterlockedIncrement((volatile long *)Value);
+#else
+    meow_u32 Result = __atomic_add_fetch(Value, 1, __ATOMIC_SEQ_CST);
+#endif
+    return(Result);
+}
+
+static meow_u32
+AtomicAdd(volatile meow_u32 *Value, meow_u32 Amount)
+{
+#if _MSC_VER
+    meow_u32 Result = (meow_u32)InterlockedExchangeAdd((volatile long *)Value, (long)Amount) + Amount;
+#else
+    meow_u32 Result = __atomic_add_fetch(Value, Amount, __ATOMIC_SEQ_CST);
+#endif
+    return(Result);
+}
+
+static meow_u32
+AtomicLoad(volatile meow_u32 *Value)
+{
+#if _MSC_VER
+    meow_u32 Result = *Value;
+    _ReadWriteBarrier();
+#else
+    meow_u32 Result = __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+#endif
+    return(Result);
+}
+
+static void
+AtomicStore(volatile meow_u32 *Value, meow_u32 New)
+{
+#if _MSC_VER
+    _ReadWriteBarrier();
+    *Value = New;
+#else
+    __atomic_store_n(Value, New, __ATOMIC_RELEASE);
+#endif
+}
+
+//
+// NOTE: NUMA placement.  On a multi-socket machine, memory attached to another
+// socket is noticeably slower to hash than local memory, and by default it ends
+// up wherever the first thread to touch it happened to be running.  These ask
+// the OS directly (mbind / move_pages on Linux, so there's no libnuma dependency)
+// for memory bound to a particular node, and report where memory actually is.
+// Anything that isn't Linux or Windows sees a single node.
+//
+
+#if __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// NOTE: Pass as the node to NUMAAlloc to leave placement to the OS (first touch)
+#define NUMA_NODE_ANY -1
+
+#define MEOW_NUMA_MAX_NODES 1024
+
+// NOTE: From linux/mempolicy.h
+#define MEOW_MPOL_BIND 2
+#define MEOW_MPOL_MF_STRICT (1 << 0)
+
+static int
+GetNUMANodeCount(void)
+{
+    int Result = 1;
+    
+#if _WIN32
+    ULONG HighestNode = 0;
+    if(GetNumaHighestNodeNumber(&HighestNode))
+    {
+        Result = (int)HighestNode + 1;
+    }
+#elif __linux__
+    // NOTE: This is a list like "0" or "0-1" or "0,2-3"; the node count is one past the last node
+    FILE *Nodes = fopen("/sys/devices/system/node/possible", "r");
+    if(Nodes)
+    {
+        char List[256] = {};
+        if(fgets(List, sizeof(List), Nodes))
+        {
+            char *Last = List;
+            for(char *At = List; *At; ++At)
+            {
+                if((*At == '-') || (*At == ','))
+                {
+                    Last = At + 1;
+                }
+            }
+            Result = atoi(Last) + 1;
+        }
+        fclose(Nodes);
+    }
+#endif
+    
+    if((Result < 1) || (Result > MEOW_NUMA_MAX_NODES))
+    {
+        Result = 1;
+    }
+    return(Result);
+}
+
+static int
+GetCurrentNUMANode(void)
+{
+    int Result = 0;
+    
+#if _WIN32
+    PROCESSOR_NUMBER Processor;
+    USHORT Node;
+    GetCurrentProcessorNumberEx(&Processor);
+    if(GetNumaProcessorNodeEx(&Processor, &Node))
+    {
+        Result = Node;
+    }
+#elif __linux__
+    unsigned Processor = 0, Node = 0;
+    if(syscall(SYS_getcpu, &Processor, &Node, 0) == 0)
+    {
+        Result = (int)Node;
+    }
+#endif
+    
+    return(Result);
+}
+
+// NOTE: Page sizes.  A giant input on 4kb pages touches a new page every 4kb, and
+// the TLB only covers a few megabytes of those, so page walks end up mixed into
+// the hashing cost.  Memory can ask for 2mb or 1gb pages explicitly (these come
+// from the reserved pool, /proc/sys/vm/nr_hugepages and friends on Linux, and
+// fail if it's empty), for transparent huge pages (2mb pages if the kernel can
+// find them, 4kb otherwise), or for 4kb pages with transparent huge pages turned
+// off.  This only changes how memory is mapped - MEOW_PAGESIZE, which the hash
+// uses to decide whether reading past the end of the input is safe, stays 4kb,
+// since 4kb is still the smallest page that an input could end next to.
+//
+
+enum page_kind
+{
+    Pages_Default,
+    Pages_Small,
+    Pages_Transparent,
+    Pages_Huge2MB,
+    Pages_Huge1GB,
+    
+    Pages_Count,
+};
+
+static char const *PageKindNames[] =
+{
+    "default",
+    "4k",
+    "thp",
+    "2m",
+    "1g",
+};
+
+#if __linux__
+// NOTE: From linux/mman.h, which not every libc's sys/mman.h pulls in
+#define MEOW_MAP_HUGE_2MB (21 << 26)
+#define MEOW_MAP_HUGE_1GB (30 << 26)
+#endif
+
+// NOTE: What an allocation of this kind is rounded up to (and, for transparent huge pages, aligned to)
+static meow_u64
+PageGranularity(page_kind Kind)
+{
+    meow_u64 Result = ((Kind == Pages_Huge1GB) ? (1ULL << 30) :
+                       ((Kind == Pages_Huge2MB) || (Kind == Pages_Transparent)) ? (1ULL << 21) :
+                       4096);
+#if _WIN32
+    if(Kind == Pages_Huge2MB)
+    {
+        Result = GetLargePageMinimum();
+    }
+#endif
+    return(Result);
+}
+
+// NOTE: Page-aligned memory whose pages will come from Node (or wherever the OS
+// likes, for NUMA_NODE_ANY) and be of the given kind.  Free it with FreePages,
+// passing the same size and kind.  Returns 0 if the OS can't provide that kind.
+static void *
+AllocPages(meow_u64 Size, int Node, page_kind Kind)
+{
+    void *Result = 0;
+    
+    meow_u64 Granularity = PageGranularity(Kind);
+    if(Granularity == 0)
+    {
+        return(Result);
+    }
+    Size = (Size + Granularity - 1) & ~(Granularity - 1);
+    
+#if _WIN32
+    // NOTE: Large pages need SeLockMemoryPrivilege, and there's no 1gb or transparent equivalent
+    DWORD Type = MEM_RESERVE|MEM_COMMIT;
+    if(Kind == Pages_Huge2MB)
+    {
+        Type |= MEM_LARGE_PAGES;
+    }
+    
+    if(Kind != Pages_Huge1GB)
+    {
+        if(Node == NUMA_NODE_ANY)
+        {
+            Result = VirtualAlloc(0, Size, Type, PAGE_READWRITE);
+        }
+        else
+        {
+            Result = VirtualAllocExNuma(GetCurrentProcess(), 0, Size, Type, PAGE_READWRITE, (DWORD)Node);
+        }
+    }
+#elif __linux__
+    int Flags = MAP_PRIVATE|MAP_ANONYMOUS;
+    if(Kind == Pages_Huge2MB)
+    {
+        Flags |= MAP_HUGETLB|MEOW_MAP_HUGE_2MB;
+    }
+    else if(Kind == Pages_Huge1GB)
+    {
+        Flags |= MAP_HUGETLB|MEOW_MAP_HUGE_1GB;
+    }
+    
+    // NOTE: mmap only promises 4kb alignment, and the kernel can only use a
+    // transparent huge page for an aligned 2mb span, so map extra and trim
+    meow_u64 MapSize = (Kind == Pages_Transparent) ? (Size + Granularity) : Size;
+    Result = mmap(0, MapSize, PROT_READ|PROT_WRITE, Flags, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    else if(Kind == Pages_Transparent)
+    {
+        meow_u8 *Mapped = (meow_u8 *)Result;
+        meow_u8 *Aligned = (meow_u8 *)(((meow_umm)Mapped + Granularity - 1) & ~(meow_umm)(Granularity - 1));
+        if(Aligned > Mapped)
+        {
+            munmap(Mapped, Aligned - Mapped);
+        }
+        if((Mapped + MapSize) > (Aligned + Size))
+        {
+            munmap(Aligned + Size, (Mapped + MapSize) - (Aligned + Size));
+        }
+        Result = Aligned;
+    }
+    
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if(Result && ((Kind == Pages_Transparent) || (Kind == Pages_Small)))
+    {
+        madvise(Result, Size, (Kind == Pages_Transparent) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    }
+#endif
+    
+    if(Result && (Node != NUMA_NODE_ANY))
+    {
+        // NOTE: The pages aren't there yet; this sets the policy they'll get when first touched
+        unsigned long Mask[MEOW_NUMA_MAX_NODES / (8*sizeof(unsigned long))] = {};
+        if((Node >= 0) && (Node < MEOW_NUMA_MAX_NODES))
+        {
+            Mask[Node / (8*sizeof(unsigned long))] |= 1UL << (Node % (8*sizeof(unsigned long)));
+        }
+        if(syscall(SYS_mbind, Result, Size, MEOW_MPOL_BIND, Mask, MEOW_NUMA_MAX_NODES + 1, MEOW_MPOL_MF_STRICT) != 0)
+        {
+            munmap(Result, Size);
+            Result = 0;
+        }
+    }
+#else
+    if((Kind == Pages_Default) || (Kind == Pages_Small))
+    {
+        Result = aligned_alloc(4096, Size);
+    }
+#endif
+    
+    return(Result);
+}
+
+static void
+FreePages(void *Memory, meow_u64 Size, page_kind Kind)
+{
+    if(Memory)
+    {
+#if _WIN32
+        (void)Size;
+        (void)Kind;
+        VirtualFree(Memory, 0, MEM_RELEASE);
+#elif __linux__
+        meow_u64 Granularity = PageGranularity(Kind);
+        munmap(Memory, (Size + Granularity - 1) & ~(Granularity - 1));
+#else
+        (void)Size;
+        (void)Kind;
+        free(Memory);
+#endif
+    }
+}
+
+static void *
+NUMAAlloc(meow_u64 Size, int Node)
+{
+    void *Result = AllocPages(Size, Node, Pages_Default);
+    return(Result);
+}
+
+static void
+NUMAFree(void *Memory, meow_u64 Size)
+{
+    FreePages(Memory, Size, Pages_Default);
+}
+
+// NOTE: The node holding the page at Address, or -1 if it isn't resident or can't be asked
+static int
+GetMemoryNUMANode(void *Address)
+{
+    int Result = -1;
+    
+#if __linux__
+    void *Page = (void *)((meow_umm)Address & ~(meow_umm)4095);
+    int Status = -1;
+    if((syscall(SYS_move_pages, 0, 1, &Page, 0, &Status, 0) == 0) && (Status >= 0))
+    {
+        Result = Status;
+    }
+#endif
+    
+    return(Result);
+}
+
+// NOTE: How many bytes of the mapping holding Address are backed by huge pages
+// (explicit or transparent).  Returns 0 if that can't be asked.
+static int
+GetHugePageBytes(void *Address, meow_u64 *Bytes)
+{
+    int Result = 0;
+    *Bytes = 0;
+    
+#if __linux__
+    FILE *Maps = fopen("/proc/self/smaps", "r");
+    if(Maps)
+    {
+        char Line[512];
+        int InMapping = 0;
+        while(fgets(Line, sizeof(Line), Maps))
+        {
+            unsigned long long Start, End;
+            unsigned long long Kb;
+            if(sscanf(Line, "%llx-%llx ", &Start, &End) == 2)
+            {
+                if(InMapping)
+                {
+                    break;
+                }
+                InMapping = (((meow_umm)Address >= Start) && ((meow_umm)Address < End));
+                if(InMapping)
+                {
+                    Result = 1;
+                }
+            }
+            else if(InMapping &&
+                    ((sscanf(Line, "AnonHugePages: %llu kB", &Kb) == 1) ||
+                     (sscanf(Line, "Private_Hugetlb: %llu kB", &Kb) == 1) ||
+                     (sscanf(Line, "Shared_Hugetlb: %llu kB", &Kb) == 1)))
+            {
+                *Bytes += (meow_u64)Kb*1024;
+            }
+        }
+        fclose(Maps);
+    }
+#endif
+    
+    return(Result);
+}